@@ -18,6 +18,14 @@
 %ignore vrv::Toolkit::ResetLogBuffer( );
 %ignore vrv::Toolkit::SetShowBoundingBoxes( bool );
 %ignore vrv::Toolkit::SetCString( const std::string & );
+%ignore vrv::Toolkit::SetCString( std::string && );
+%ignore vrv::Toolkit::GetCStringLength( ) const;
+%ignore vrv::Toolkit::CopyCString( char *, int ) const;
+
+// Asynchronous methods - Java threads can be used instead
+%ignore vrv::Toolkit::LoadDataAsync;
+%ignore vrv::Toolkit::RedoLayoutAsync;
+%ignore vrv::Toolkit::RenderToSVGAsync;
 
 %module verovio
 %include "std_string.i"
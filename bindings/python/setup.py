@@ -15,9 +15,12 @@ os.system("../../tools/get_git_commit.sh")
 
 
 EXTRA_COMPILE_ARGS = ['-DPYTHON_BINDING']
+EXTRA_LINK_ARGS = []
 if platform.system() != 'Windows':
-    EXTRA_COMPILE_ARGS += ['-std=c++11',
+    EXTRA_COMPILE_ARGS += ['-std=c++11', '-pthread',
                            '-Wno-write-strings', '-Wno-overloaded-virtual']
+    # Required for the asynchronous methods of the Toolkit
+    EXTRA_LINK_ARGS += ['-pthread']
 else:
     EXTRA_COMPILE_ARGS += ['-DNO_PAE_SUPPORT']
 
@@ -56,7 +59,8 @@ verovio_module = Extension('_verovio',
                                          '../../include/utf8',
                                          '../../include/win32',
                                          '../../libmei'],
-                           extra_compile_args=EXTRA_COMPILE_ARGS
+                           extra_compile_args=EXTRA_COMPILE_ARGS,
+                           extra_link_args=EXTRA_LINK_ARGS
                            )
 
 setup(name='verovio',
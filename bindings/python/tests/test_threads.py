@@ -0,0 +1,83 @@
+#!/usr/bin/env python
+
+"""
+Multithreaded test and benchmark of the Python toolkit
+
+The toolkits are used by several Python threads at the same time. The output has to be the same as the sequential
+one and, since the GIL is released while the toolkits render, the parallel rendering has to be faster on a machine
+with several cores.
+
+Run from bindings/python with `make test`, which builds the module with SWIG first, or after `make` with:
+    python -m pytest -s tests
+"""
+
+import glob
+import os
+import re
+import threading
+import time
+
+import pytest
+
+# The test fails instead of being skipped when the module is not built
+import verovio
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..")
+RESOURCES = os.path.join(ROOT, "data")
+FILES = sorted(glob.glob(os.path.join(ROOT, "doc", "tests", "*", "*", "*.*")))
+THREADS = 4
+
+
+def convert(filename):
+    toolkit = verovio.toolkit(False)
+    assert toolkit.setResourcePath(RESOURCES)
+    assert toolkit.loadFile(filename)
+    # The generated ids are random and are not compared
+    pages = [re.sub(rb'id="[^"]*"', b"", toolkit.renderToSVGBytes(page))
+             for page in range(1, toolkit.getPageCount() + 1)]
+    return pages + [toolkit.renderToMIDIBytes()]
+
+
+def convert_all(threads):
+    results = {}
+
+    def worker(index):
+        for filename in FILES[index::threads]:
+            results[filename] = convert(filename)
+
+    workers = [threading.Thread(target=worker, args=(i,)) for i in range(threads)]
+    start = time.perf_counter()
+    for thread in workers:
+        thread.start()
+    for thread in workers:
+        thread.join()
+    return results, time.perf_counter() - start
+
+
+@pytest.mark.skipif(not FILES, reason="no test files")
+def test_threads():
+    expected, sequential = convert_all(1)
+    results, parallel = convert_all(THREADS)
+    # Every file is converted, with at least one page and the MIDI
+    assert sorted(expected) == FILES
+    for filename, output in expected.items():
+        assert len(output) >= 2, filename
+        assert all(page.startswith(b"<svg") for page in output[:-1]), filename
+        assert output[-1].startswith(b"MThd"), filename
+    assert results == expected
+    print("\n%d files: %.3f s with 1 thread, %.3f s with %d threads (x%.2f)"
+          % (len(FILES), sequential, parallel, THREADS, sequential / parallel))
+    # The GIL is released while rendering, so the threads run in parallel when there are enough cores
+    if (os.cpu_count() or 1) >= THREADS:
+        assert sequential / parallel > 1.5
+
+
+@pytest.mark.skipif(not FILES, reason="no test files")
+def test_bytes():
+    toolkit = verovio.toolkit(False)
+    assert toolkit.setResourcePath(RESOURCES)
+    assert toolkit.loadFile(FILES[0])
+    svg = toolkit.renderToSVGBytes(1)
+    assert isinstance(svg, bytes)
+    assert svg.decode("utf-8") == toolkit.renderToSVG(1)
+    assert toolkit.renderToMIDIBytes().startswith(b"MThd")
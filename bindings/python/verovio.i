@@ -5,6 +5,9 @@
 // Copyright (c) Authors and others. All rights reserved.
 /////////////////////////////////////////////////////////////////////////////
 
+// Built with thread support for releasing the GIL - this has to be the first directive
+%module(threads="1") verovio
+
 // Change method names to lowerCamelCase
 %rename("%(lowercamelcase)s") "";
 
@@ -16,16 +19,61 @@
 %ignore vrv::Toolkit::ResetLogBuffer( );
 %ignore vrv::Toolkit::SetShowBoundingBoxes( bool );
 %ignore vrv::Toolkit::SetCString( const std::string & );
+%ignore vrv::Toolkit::SetCString( std::string && );
+%ignore vrv::Toolkit::GetCStringLength( ) const;
+%ignore vrv::Toolkit::CopyCString( char *, int ) const;
+
+// Asynchronous methods - Python threads can be used instead
+%ignore vrv::Toolkit::LoadDataAsync;
+%ignore vrv::Toolkit::RedoLayoutAsync;
+%ignore vrv::Toolkit::RenderToSVGAsync;
+
+// The GIL is released only in the long-running methods so other Python threads can run meanwhile.
+// One toolkit instance should still not be used by several threads at the same time.
+%nothread;
+%thread vrv::Toolkit::LoadData;
+%thread vrv::Toolkit::LoadFile;
+%thread vrv::Toolkit::RedoLayout;
+%thread vrv::Toolkit::RenderToSVG;
+%thread vrv::Toolkit::RenderToSVGFile;
+%thread vrv::Toolkit::RenderToMIDI;
+%thread vrv::Toolkit::RenderToMIDIFile;
+%thread vrv::Toolkit::RenderToTimemap;
+%thread vrv::Toolkit::RenderToTimemapFile;
+%thread vrv::Toolkit::GetMEI;
+%thread vrv::Toolkit::SaveFile;
+%thread vrv::Toolkit::GetHumdrum;
+%thread vrv::Toolkit::RenderToSVGBytes;
+%thread vrv::Toolkit::RenderToMIDIBytes;
+%thread vrv::Toolkit::RenderToTimemapBytes;
 
-%module verovio
 %include "std_string.i"
+
+// Returned as bytes instead of str, without decoding (and for MIDI without the base64 encoding)
+%typemap(out) vrv::Bytes %{ $result = PyBytes_FromStringAndSize($1.data(), $1.size()); %}
+
+namespace vrv {
+typedef std::string Bytes;
+}
+
 %include "../../include/vrv/toolkit.h"
 
+%extend vrv::Toolkit {
+    vrv::Bytes RenderToSVGBytes(int pageNo = 1, bool xml_declaration = false)
+    {
+        return $self->RenderToSVG(pageNo, xml_declaration);
+    }
+    vrv::Bytes RenderToMIDIBytes() { return $self->RenderToMIDIRaw(); }
+    vrv::Bytes RenderToTimemapBytes() { return $self->RenderToTimemap(); }
+}
 
 %{
     #include "../../include/vrv/toolkit.h"
-    
+
     using namespace vrv;
     using namespace std;
-%}
 
+    namespace vrv {
+    typedef std::string Bytes;
+    }
+%}
@@ -5,6 +5,7 @@
 // Copyright (c) Authors and others. All rights reserved.
 /////////////////////////////////////////////////////////////////////////////
 
+#include "c_wrapper.h"
 #include "toolkit.h"
 #include "vrv.h"
 
@@ -14,40 +15,15 @@ using namespace vrv;
 extern "C" {
 
 /****************************************************************
-* Methods exported to use the Toolkit class from js
+* Methods exported to use the Toolkit class from js and through the C API of the library
 ****************************************************************/
 
-/** declarations */
-    
-void *vrvToolkit_constructor();
-void vrvToolkit_destructor(Toolkit *tk);
-bool vrvToolkit_edit(Toolkit *tk, const char *editorAction);
-const char *vrvToolkit_getAvailableOptions(Toolkit *tk);
-const char *vrvToolkit_getElementAttr(Toolkit *tk, const char *xmlId);
-const char *vrvToolkit_getElementsAtTime(Toolkit *tk, int millisec);
-const char *vrvToolkit_getHumdrum(Toolkit *tk);
-const char *vrvToolkit_getLog(Toolkit *tk);
-const char *vrvToolkit_getMEI(Toolkit *tk, int page_no, bool score_based);
-const char *vrvToolkit_getOptions(Toolkit *tk, bool default_values);
-int vrvToolkit_getPageCount(Toolkit *tk);
-int vrvToolkit_getPageWithElement(Toolkit *tk, const char *xmlId);
-double vrvToolkit_getTimeForElement(Toolkit *tk, const char *xmlId);
-const char *vrvToolkit_getVersion(Toolkit *tk);
-bool vrvToolkit_loadData(Toolkit *tk, const char *data);
-const char *vrvToolkit_renderToMIDI(Toolkit *tk, const char *c_options);
-const char *vrvToolkit_renderToSVG(Toolkit *tk, int page_no, const char *c_options);
-const char *vrvToolkit_renderToTimemap(Toolkit *tk);
-void vrvToolkit_redoLayout(Toolkit *tk);
-void vrvToolkit_redoPagePitchPosLayout(Toolkit *tk);
-const char *vrvToolkit_renderData(Toolkit *tk, const char *data, const char *options);
-void vrvToolkit_setOptions(Toolkit *tk, const char *options);
-   
-/** implementations */
-    
 void *vrvToolkit_constructor()
 {
+#ifdef USE_EMSCRIPTEN
     // set the resource path in the js blob
     Resources::SetPath("/data");
+#endif
 
     return new Toolkit();
 }
@@ -57,6 +33,11 @@ void vrvToolkit_destructor(Toolkit *tk)
     delete tk;
 }
 
+int vrvToolkit_copyCString(Toolkit *tk, char *buffer, int size)
+{
+    return tk->CopyCString(buffer, size);
+}
+
 bool vrvToolkit_edit(Toolkit *tk, const char *editorAction)
 {
     if (!tk->Edit(editorAction)) {
@@ -72,6 +53,11 @@ const char *vrvToolkit_getAvailableOptions(Toolkit *tk)
     return tk->GetCString();
 }
 
+int vrvToolkit_getCStringLength(Toolkit *tk)
+{
+    return tk->GetCStringLength();
+}
+
 const char *vrvToolkit_getElementAttr(Toolkit *tk, const char *xmlId)
 {
     tk->SetCString(tk->GetElementAttr(xmlId));
@@ -102,6 +88,12 @@ const char *vrvToolkit_getMEI(Toolkit *tk, int page_no, bool score_based)
     return tk->GetCString();
 }
 
+const char *vrvToolkit_getMemoryStats(Toolkit *tk)
+{
+    tk->SetCString(tk->GetMemoryStats());
+    return tk->GetCString();
+}
+
 const char *vrvToolkit_getOptions(Toolkit *tk, bool default_values)
 {
     tk->SetCString(tk->GetOptions(default_values));
@@ -142,6 +134,15 @@ const char *vrvToolkit_renderToMIDI(Toolkit *tk, const char *c_options)
     return tk->GetCString();
 }
 
+const char *vrvToolkit_renderMeasureRangeToSVG(
+    Toolkit *tk, const char *startMeasureId, const char *endMeasureId, const char *c_options)
+{
+    tk->ResetLogBuffer();
+    if (c_options && (c_options[0] != 0)) vrvToolkit_setOptions(tk, c_options);
+    tk->SetCString(tk->RenderMeasureRangeToSVG(startMeasureId, endMeasureId, false));
+    return tk->GetCString();
+}
+
 const char *vrvToolkit_renderToSVG(Toolkit *tk, int page_no, const char *c_options)
 {
     tk->ResetLogBuffer();
@@ -182,4 +183,9 @@ void vrvToolkit_setOptions(Toolkit *tk, const char *options)
     }
 }
 
+bool vrvToolkit_setResourcePath(Toolkit *tk, const char *path)
+{
+    return tk->SetResourcePath(path);
+}
+
 } // extern C
@@ -2,6 +2,16 @@
 // Proxy the exported c++ methods
 verovio.vrvToolkit = verovio.vrvToolkit || {};
 
+// Wrap a method returning the C string of the toolkit. The string is read from the pointer returned with its length
+// instead of being scanned for its end, and the toolkit is expected to be the first argument
+verovio.vrvToolkit.cwrapCString = function (name, argTypes) {
+	var method = Module.cwrap(name, 'number', argTypes);
+	return function (tk) {
+		var ptr = method.apply(null, arguments);
+		return Module.UTF8ToString(ptr, verovio.vrvToolkit.getCStringLength(tk));
+	};
+};
+
 // Constructor and destructor
 // Toolkit *constructor()
 verovio.vrvToolkit.constructor = Module.cwrap('vrvToolkit_constructor', 'number', []);
@@ -13,25 +23,31 @@ verovio.vrvToolkit.destructor = Module.cwrap('vrvToolkit_destructor', null, ['nu
 verovio.vrvToolkit.edit = Module.cwrap('vrvToolkit_edit', 'number', ['number', 'string']);
 
 // char *getAvailableOptions(Toolkit *ic)
-verovio.vrvToolkit.getAvailableOptions = Module.cwrap('vrvToolkit_getAvailableOptions', 'string', ['number']);
+verovio.vrvToolkit.getAvailableOptions = verovio.vrvToolkit.cwrapCString('vrvToolkit_getAvailableOptions', ['number']);
+
+// int getCStringLength(Toolkit *ic)
+verovio.vrvToolkit.getCStringLength = Module.cwrap('vrvToolkit_getCStringLength', 'number', ['number']);
 
 // char *getElementAttr(Toolkit *ic, const char *xmlId)
-verovio.vrvToolkit.getElementAttr = Module.cwrap('vrvToolkit_getElementAttr', 'string', ['number', 'string']);
+verovio.vrvToolkit.getElementAttr = verovio.vrvToolkit.cwrapCString('vrvToolkit_getElementAttr', ['number', 'string']);
 
 // char *getElementsAtTime(Toolkit *ic, int time)
-verovio.vrvToolkit.getElementsAtTime = Module.cwrap('vrvToolkit_getElementsAtTime', 'string', ['number', 'number']);
+verovio.vrvToolkit.getElementsAtTime = verovio.vrvToolkit.cwrapCString('vrvToolkit_getElementsAtTime', ['number', 'number']);
 
 // char *getHumdrum(Toolkit *ic)
 verovio.vrvToolkit.getHumdrum = Module.cwrap('vrvToolkit_getHumdrum', 'string');
 
 // char *getLog(Toolkit *ic)
-verovio.vrvToolkit.getLog = Module.cwrap('vrvToolkit_getLog', 'string', ['number']);
+verovio.vrvToolkit.getLog = verovio.vrvToolkit.cwrapCString('vrvToolkit_getLog', ['number']);
 
 // char *getMEI(Toolkit *ic, int pageNo, int scoreBased)
-verovio.vrvToolkit.getMEI = Module.cwrap('vrvToolkit_getMEI', 'string', ['number', 'number', 'number']);
+verovio.vrvToolkit.getMEI = verovio.vrvToolkit.cwrapCString('vrvToolkit_getMEI', ['number', 'number', 'number']);
+
+// char *getMemoryStats(Toolkit *ic)
+verovio.vrvToolkit.getMemoryStats = verovio.vrvToolkit.cwrapCString('vrvToolkit_getMemoryStats', ['number']);
 
 // char *getOptions(Toolkit *ic, int defaultValues)
-verovio.vrvToolkit.getOptions = Module.cwrap('vrvToolkit_getOptions', 'string', ['number', 'number']);
+verovio.vrvToolkit.getOptions = verovio.vrvToolkit.cwrapCString('vrvToolkit_getOptions', ['number', 'number']);
 
 // int getPageCount(Toolkit *ic)
 verovio.vrvToolkit.getPageCount = Module.cwrap('vrvToolkit_getPageCount', 'number', ['number']);
@@ -43,7 +59,7 @@ verovio.vrvToolkit.getPageWithElement = Module.cwrap('vrvToolkit_getPageWithElem
 verovio.vrvToolkit.getTimeForElement = Module.cwrap('vrvToolkit_getTimeForElement', 'number', ['number', 'string']);
 
 // char *getVersion(Toolkit *ic)
-verovio.vrvToolkit.getVersion = Module.cwrap('vrvToolkit_getVersion', 'string', ['number']);
+verovio.vrvToolkit.getVersion = verovio.vrvToolkit.cwrapCString('vrvToolkit_getVersion', ['number']);
 
 // bool loadData(Toolkit *ic, const char *data)
 verovio.vrvToolkit.loadData = Module.cwrap('vrvToolkit_loadData', 'number', ['number', 'string']);
@@ -55,16 +71,19 @@ verovio.vrvToolkit.redoLayout = Module.cwrap('vrvToolkit_redoLayout', null, ['nu
 verovio.vrvToolkit.redoPagePitchPosLayout = Module.cwrap('vrvToolkit_redoPagePitchPosLayout', null, ['number']);
 
 // char *renderData(Toolkit *ic, const char *data, const char *options)
-verovio.vrvToolkit.renderData = Module.cwrap('vrvToolkit_renderData', 'string', ['number', 'string', 'string']);
+verovio.vrvToolkit.renderData = verovio.vrvToolkit.cwrapCString('vrvToolkit_renderData', ['number', 'string', 'string']);
+
+// char *renderMeasureRangeToSVG(Toolkit *ic, const char *startMeasureId, const char *endMeasureId, const char *rendering_options)
+verovio.vrvToolkit.renderMeasureRangeToSVG = verovio.vrvToolkit.cwrapCString('vrvToolkit_renderMeasureRangeToSVG', ['number', 'string', 'string', 'string']);
 
 // char *renderToMidi(Toolkit *ic, const char *rendering_options)
-verovio.vrvToolkit.renderToMIDI = Module.cwrap('vrvToolkit_renderToMIDI', 'string', ['number', 'string']);
+verovio.vrvToolkit.renderToMIDI = verovio.vrvToolkit.cwrapCString('vrvToolkit_renderToMIDI', ['number', 'string']);
 
 // char *renderToSvg(Toolkit *ic, int pageNo, const char *rendering_options)
-verovio.vrvToolkit.renderToSVG = Module.cwrap('vrvToolkit_renderToSVG', 'string', ['number', 'number', 'string']);
+verovio.vrvToolkit.renderToSVG = verovio.vrvToolkit.cwrapCString('vrvToolkit_renderToSVG', ['number', 'number', 'string']);
 
 // char *renderToTimemap(Toolkit *ic)
-verovio.vrvToolkit.renderToTimemap = Module.cwrap('vrvToolkit_renderToTimemap', 'string', ['number']);
+verovio.vrvToolkit.renderToTimemap = verovio.vrvToolkit.cwrapCString('vrvToolkit_renderToTimemap', ['number']);
 
 // void setOptions(Toolkit *ic, const char *options) 
 verovio.vrvToolkit.setOptions = Module.cwrap('vrvToolkit_setOptions', null, ['number', 'string']);
@@ -114,6 +133,10 @@ verovio.toolkit.prototype.getMEI = function (pageNo, scoreBased) {
 	return verovio.vrvToolkit.getMEI(this.ptr, pageNo, scoreBased);
 };
 
+verovio.toolkit.prototype.getMemoryStats = function () {
+	return verovio.vrvToolkit.getMemoryStats(this.ptr);
+};
+
 verovio.toolkit.prototype.getOptions = function (defaultValues) {
 	return JSON.parse(verovio.vrvToolkit.getOptions(this.ptr, defaultValues));
 };
@@ -164,6 +187,10 @@ verovio.toolkit.prototype.renderToMidi = function (options) {
     return verovio.vrvToolkit.renderToMIDI(this.ptr, JSON.stringify(options));
 };
 
+verovio.toolkit.prototype.renderMeasureRangeToSVG = function (startMeasureId, endMeasureId, options) {
+    return verovio.vrvToolkit.renderMeasureRangeToSVG(this.ptr, startMeasureId, endMeasureId, JSON.stringify(options));
+};
+
 verovio.toolkit.prototype.renderToSVG = function (pageNo, options) {
     return verovio.vrvToolkit.renderToSVG(this.ptr, pageNo, JSON.stringify(options));
 };
@@ -114,6 +114,11 @@ public:
      */
     virtual int ResetDrawing(FunctorParams *functorParams);
 
+    /**
+     * See Object::CalcMemoryStats
+     */
+    virtual int CalcMemoryStats(FunctorParams *functorParams);
+
 protected:
     /**
      * Filter the flat list and keep only Note and Chords elements.
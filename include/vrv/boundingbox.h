@@ -242,11 +242,6 @@ private:
      * The font size for the smufl glyph used for calculating the bounding box rectangles.
      */
     int m_smuflGlyphFontSize;
-
-    /**
-     * Buffer for De-Casteljau algorithm
-     */
-    static int s_deCasteljau[4][4];
 };
 
 } // namespace vrv
@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        c_wrapper.h
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRV_C_WRAPPER_H__
+#define __VRV_C_WRAPPER_H__
+
+//----------------------------------------------------------------------------
+// C API of the Toolkit class, used from js and exported by the library (BUILD_AS_LIBRARY).
+// The strings returned are owned by the toolkit and remain valid until the next call returning a string.
+// Their length is given by vrvToolkit_getCStringLength and they can be copied with vrvToolkit_copyCString.
+//----------------------------------------------------------------------------
+
+#ifdef __cplusplus
+namespace vrv {
+class Toolkit;
+}
+typedef vrv::Toolkit Toolkit;
+extern "C" {
+#else
+#include <stdbool.h>
+typedef struct Toolkit Toolkit;
+#endif
+
+void *vrvToolkit_constructor();
+void vrvToolkit_destructor(Toolkit *tk);
+int vrvToolkit_copyCString(Toolkit *tk, char *buffer, int size);
+bool vrvToolkit_edit(Toolkit *tk, const char *editorAction);
+const char *vrvToolkit_getAvailableOptions(Toolkit *tk);
+int vrvToolkit_getCStringLength(Toolkit *tk);
+const char *vrvToolkit_getElementAttr(Toolkit *tk, const char *xmlId);
+const char *vrvToolkit_getElementsAtTime(Toolkit *tk, int millisec);
+const char *vrvToolkit_getHumdrum(Toolkit *tk);
+const char *vrvToolkit_getLog(Toolkit *tk);
+const char *vrvToolkit_getMEI(Toolkit *tk, int page_no, bool score_based);
+const char *vrvToolkit_getMemoryStats(Toolkit *tk);
+const char *vrvToolkit_getOptions(Toolkit *tk, bool default_values);
+int vrvToolkit_getPageCount(Toolkit *tk);
+int vrvToolkit_getPageWithElement(Toolkit *tk, const char *xmlId);
+double vrvToolkit_getTimeForElement(Toolkit *tk, const char *xmlId);
+const char *vrvToolkit_getVersion(Toolkit *tk);
+bool vrvToolkit_loadData(Toolkit *tk, const char *data);
+const char *vrvToolkit_renderMeasureRangeToSVG(
+    Toolkit *tk, const char *startMeasureId, const char *endMeasureId, const char *c_options);
+const char *vrvToolkit_renderToMIDI(Toolkit *tk, const char *c_options);
+const char *vrvToolkit_renderToSVG(Toolkit *tk, int page_no, const char *c_options);
+const char *vrvToolkit_renderToTimemap(Toolkit *tk);
+void vrvToolkit_redoLayout(Toolkit *tk);
+void vrvToolkit_redoPagePitchPosLayout(Toolkit *tk);
+const char *vrvToolkit_renderData(Toolkit *tk, const char *data, const char *options);
+void vrvToolkit_setOptions(Toolkit *tk, const char *options);
+bool vrvToolkit_setResourcePath(Toolkit *tk, const char *path);
+
+#ifdef __cplusplus
+} // extern C
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        displaylistdevicecontext.h
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRV_DISPLAY_LIST_DC_H__
+#define __VRV_DISPLAY_LIST_DC_H__
+
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+#include "devicecontext.h"
+
+namespace vrv {
+
+class Object;
+
+//----------------------------------------------------------------------------
+// DisplayListCommand
+//----------------------------------------------------------------------------
+
+/**
+ * The type of the calls recorded in a DisplayListDeviceContext
+ */
+enum DisplayListCommandType {
+    DL_SET_BACKGROUND = 0,
+    DL_SET_BACKGROUND_IMAGE,
+    DL_SET_BACKGROUND_MODE,
+    DL_SET_TEXT_FOREGROUND,
+    DL_SET_TEXT_BACKGROUND,
+    DL_SET_LOGICAL_ORIGIN,
+    DL_DRAW_COMPLEX_BEZIER_PATH,
+    DL_DRAW_CIRCLE,
+    DL_DRAW_ELLIPSE,
+    DL_DRAW_ELLIPTIC_ARC,
+    DL_DRAW_LINE,
+    DL_DRAW_POLYGON,
+    DL_DRAW_RECTANGLE,
+    DL_DRAW_ROTATED_TEXT,
+    DL_DRAW_ROUNDED_RECTANGLE,
+    DL_DRAW_TEXT,
+    DL_DRAW_MUSIC_TEXT,
+    DL_DRAW_SPLINE,
+    DL_DRAW_SVG_SHAPE,
+    DL_DRAW_BACKGROUND_IMAGE,
+    DL_DRAW_PLACEHOLDER,
+    DL_START_TEXT,
+    DL_END_TEXT,
+    DL_MOVE_TEXT_TO,
+    DL_START_GRAPHIC,
+    DL_END_GRAPHIC,
+    DL_START_CUSTOM_GRAPHIC,
+    DL_END_CUSTOM_GRAPHIC,
+    DL_RESUME_GRAPHIC,
+    DL_END_RESUMED_GRAPHIC,
+    DL_START_TEXT_GRAPHIC,
+    DL_END_TEXT_GRAPHIC,
+    DL_ROTATE_GRAPHIC,
+    DL_START_PAGE,
+    DL_END_PAGE,
+    DL_ADD_DESCRIPTION
+};
+
+/**
+ * This class holds one call recorded in a DisplayListDeviceContext.
+ * The points and the strings are stored in the display list and referenced by their index.
+ * The pen, brush and font are the ones on the top of the stacks when the call was made, also referenced by their
+ * index in the display list (-1 if the stack was empty).
+ */
+class DisplayListCommand {
+public:
+    DisplayListCommandType m_type;
+    int m_values[5];
+    double m_doubleValues[2];
+    void *m_pointer;
+    View *m_view;
+    pugi::xml_node m_svg;
+    int m_pointIdx;
+    int m_stringIdx;
+    int m_wstringIdx;
+    int m_pen;
+    int m_brush;
+    int m_font;
+    bool m_isDeactivatedX;
+    bool m_isDeactivatedY;
+};
+
+//----------------------------------------------------------------------------
+// DisplayListDeviceContext
+//----------------------------------------------------------------------------
+
+/**
+ * This class records the calls made by the View when drawing a page into a display list that can then be replayed
+ * into other device contexts (e.g., SvgDeviceContext or BBoxDeviceContext) without running the View again.
+ * The objects drawn are referenced by pointer. A display list is valid only as long as the layout of the page and
+ * the objects do not change. The text extends are the ones of the DeviceContext base class. Since the View also
+ * depends on DeviceContext::UseGlobalStyling, the value of the device context it will be replayed into has to be
+ * given when creating it.
+ */
+class DisplayListDeviceContext : public DeviceContext {
+public:
+    /**
+     * @name Constructors, destructors, and other standard methods
+     */
+    ///@{
+    DisplayListDeviceContext(bool useGlobalStyling = false);
+    virtual ~DisplayListDeviceContext();
+    virtual ClassId GetClassId() const { return DISPLAY_LIST_DEVICE_CONTEXT; }
+    ///@}
+
+    /**
+     * Replay the recorded calls into the device context.
+     * The width, height and user scale of the device context have to be set before.
+     */
+    void Replay(DeviceContext *dc) const;
+
+    /**
+     * Return the number of calls recorded
+     */
+    int GetCommandCount() const { return (int)m_commands.size(); }
+
+    /**
+     * Return the approximate memory size of the display list in bytes
+     */
+    size_t GetMemorySize() const;
+
+    /**
+     * @name Setters
+     */
+    ///@{
+    virtual void SetBackground(int colour, int style = AxSOLID);
+    virtual void SetBackgroundImage(void *image, double opacity = 1.0);
+    virtual void SetBackgroundMode(int mode);
+    virtual void SetTextForeground(int colour);
+    virtual void SetTextBackground(int colour);
+    virtual void SetLogicalOrigin(int x, int y);
+    ///@}
+
+    /**
+     * @name Getters
+     */
+    ///@{
+    virtual Point GetLogicalOrigin();
+    ///@}
+
+    /**
+     * @name Drawing methods
+     */
+    ///@{
+    virtual void DrawComplexBezierPath(Point bezier1[4], Point bezier2[4]);
+    virtual void DrawCircle(int x, int y, int radius);
+    virtual void DrawEllipse(int x, int y, int width, int height);
+    virtual void DrawEllipticArc(int x, int y, int width, int height, double start, double end);
+    virtual void DrawLine(int x1, int y1, int x2, int y2);
+    virtual void DrawPolygon(int n, Point points[], int xoffset, int yoffset, int fill_style = AxODDEVEN_RULE);
+    virtual void DrawRectangle(int x, int y, int width, int height);
+    virtual void DrawRotatedText(const std::string &text, int x, int y, double angle);
+    virtual void DrawRoundedRectangle(int x, int y, int width, int height, double radius);
+    virtual void DrawText(
+        const std::string &text, const std::wstring wtext = L"", int x = VRV_UNSET, int y = VRV_UNSET);
+    virtual void DrawMusicText(const std::wstring &text, int x, int y, bool setSmuflGlyph = false);
+    virtual void DrawSpline(int n, Point points[]);
+    virtual void DrawSvgShape(int x, int y, int width, int height, pugi::xml_node svg);
+    virtual void DrawBackgroundImage(int x = 0, int y = 0);
+    ///@}
+
+    /**
+     * Special method for forcing bounding boxes to be updated
+     */
+    virtual void DrawPlaceholder(int x, int y);
+
+    /**
+     * @name Method for starting and ending a text
+     */
+    ///@{
+    virtual void StartText(int x, int y, data_HORIZONTALALIGNMENT alignment = HORIZONTALALIGNMENT_left);
+    virtual void EndText();
+
+    /**
+     * Move a text to the specified position
+     */
+    virtual void MoveTextTo(int x, int y, data_HORIZONTALALIGNMENT alignment);
+
+    /**
+     * @name Method for starting and ending a graphic
+     */
+    ///@{
+    virtual void StartGraphic(Object *object, std::string gClass, std::string gId);
+    virtual void EndGraphic(Object *object, View *view);
+    ///@}
+
+    /**
+     * @name Method for starting and ending a graphic custom graphic that do not correspond to an Object
+     */
+    ///@{
+    virtual void StartCustomGraphic(std::string name, std::string gClass = "", std::string gId = "");
+    virtual void EndCustomGraphic();
+    ///@}
+
+    /**
+     * @name Methods for re-starting and ending a graphic for objects drawn in separate steps
+     */
+    ///@{
+    virtual void ResumeGraphic(Object *object, std::string gId);
+    virtual void EndResumedGraphic(Object *object, View *view);
+    ///@}
+
+    /**
+     * @name Method for starting and ending a text graphic
+     */
+    ///@{
+    virtual void StartTextGraphic(Object *object, std::string gClass, std::string gId);
+    virtual void EndTextGraphic(Object *object, View *view);
+    ///@}
+
+    /**
+     * @name Method for rotating a graphic (clockwise).
+     */
+    ///@{
+    virtual void RotateGraphic(Point const &orig, double angle);
+    ///@}
+
+    /**
+     * @name Method for starting and ending page
+     */
+    ///@{
+    virtual void StartPage();
+    virtual void EndPage();
+    ///@}
+
+    /**
+     * @name Method for adding description element
+     */
+    ///@{
+    virtual void AddDescription(const std::string &text);
+    ///@}
+
+    /**
+     * Use the value given to the constructor
+     */
+    virtual bool UseGlobalStyling() { return m_useGlobalStyling; }
+
+private:
+    /**
+     * Add a command of the type with the current pen, brush, font and deactivation flags.
+     * Return a reference to the command for filling the values.
+     */
+    DisplayListCommand &AddCommand(DisplayListCommandType type);
+
+    /**
+     * @name Store points or a string and return the index of the first one
+     * Strings added one after the other for a command are consecutive.
+     */
+    ///@{
+    int AddPoints(int n, Point points[]);
+    int AddString(const std::string &string);
+    ///@}
+
+public:
+    //
+private:
+    /** The value returned by UseGlobalStyling */
+    bool m_useGlobalStyling;
+
+    /** The logical origin as last set */
+    int m_originX, m_originY;
+
+    /**
+     * @name The recorded commands with the values they reference
+     */
+    ///@{
+    std::vector<DisplayListCommand> m_commands;
+    std::vector<Point> m_points;
+    std::vector<std::string> m_strings;
+    std::vector<std::wstring> m_wstrings;
+    std::vector<Pen> m_pens;
+    std::vector<Brush> m_brushes;
+    std::vector<FontInfo> m_fonts;
+    ///@}
+};
+
+} // namespace vrv
+
+#endif // __VRV_DISPLAY_LIST_DC_H__
@@ -19,12 +19,20 @@ namespace vrv {
 class CastOffPagesParams;
 class FontInfo;
 class Glyph;
+class LayoutCache;
+class Measure;
 class Pages;
 class Page;
 class Score;
+class System;
 
 enum DocType { Raw = 0, Rendering, Transcription };
 
+/**
+ * The number of measures per page assumed for the first chunk of a lazy cast off
+ */
+#define LAZY_CAST_OFF_MEASURES_PER_PAGE 16
+
 //----------------------------------------------------------------------------
 // Doc
 //----------------------------------------------------------------------------
@@ -42,6 +50,7 @@ public:
     ///@{
     Doc();
     virtual ~Doc();
+    virtual std::string GetClassName() const { return "Doc"; }
     virtual ClassId GetClassId() const { return DOC; }
     ///@}
 
@@ -66,6 +75,16 @@ public:
     Options *GetOptions() const { return m_options; }
     void SetOptions(Options *options) { (*m_options) = *options; };
 
+    /**
+     * @name Setter and getter for the LayoutCache used when laying out the measures horizontally.
+     * The cache is not owned by the document and is not reset with it (see Toolkit).
+     * It is NULL by default, in which case nothing is cached.
+     */
+    ///@{
+    void SetLayoutCache(LayoutCache *layoutCache) { m_layoutCache = layoutCache; }
+    LayoutCache *GetLayoutCache() const { return m_layoutCache; }
+    ///@}
+
     /**
      * Generate a document scoreDef when none is provided.
      * This only looks at the content first system of the document.
@@ -208,8 +227,17 @@ public:
      * This is necessary for integrating changes that occur within a page.
      * It uses the MusObject::SetPageScoreDef functor method for parsing the file.
      * This will be done only if m_currentScoreDefDone is false or force is true.
+     * With scoreDefMeasure, the scoreDef effective at the beginning of that measure is copied to measureScoreDef.
+     */
+    void CollectScoreDefs(bool force = false, Measure *scoreDefMeasure = NULL, ScoreDef *measureScoreDef = NULL);
+
+    /**
+     * Set the scoreDefs of the pages from startPageIdx to endPageIdx only, starting with startScoreDef, which is the
+     * scoreDef at the beginning of the first page (see Page::m_drawingScoreDef).
+     * Only these pages have to be laid out again. The scoreDefs of the document must have been collected before.
      */
-    void CollectScoreDefs(bool force = false);
+    void CollectScoreDefs(int startPageIdx, int endPageIdx, const ScoreDef &startScoreDef,
+        Measure *scoreDefMeasure = NULL, ScoreDef *measureScoreDef = NULL);
 
     /**
      * Prepare the document for drawing.
@@ -218,11 +246,115 @@ public:
      */
     void PrepareDrawing();
 
+    /**
+     * @name Getter and setter for the drawing preparation being done.
+     * The setter is for documents that have their drawing values restored without PrepareDrawing, i.e., snapshots.
+     */
+    ///@{
+    bool IsDrawingPreparationDone() const { return m_drawingPreparationDone; }
+    void SetDrawingPreparationDone() { m_drawingPreparationDone = true; }
+    ///@}
+
+    /**
+     * Return the index of the object in the objects grouping floating elements, adding it if necessary.
+     * See FloatingObject::SetDrawingGrpObject
+     */
+    int GetDrawingGrpObjectIdx(void *drawingGrpObject);
+
     /**
      * Casts off the entire document.
      * Starting from a single system, create and fill pages and systems.
+     * With useCastOffLayout, the horizontal layout of the content page is not redone and the values stored by the
+     * previous cast off are used instead. This is valid only if the layout options and the content did not change.
+     */
+    void CastOffDoc(bool useCastOffLayout = false);
+
+    /**
+     * Re-flow the cast off document after a change of the page size or of the page margins.
+     * The horizontal layout stored by the previous CastOffDoc is restored instead of being calculated again, and the
+     * system breaking is skipped altogether when the page width (without the margins) did not change.
+     * Return false if the document cannot be re-flowed because it was not cast off with CastOffDoc or because other
+     * options or the content changed since then.
+     */
+    bool ReflowDoc();
+
+    /**
+     * Discard the values stored by CastOffDoc for re-flowing the document.
+     * Needs to be called when the content is edited.
+     */
+    void ResetCastOffLayout() { m_castOffContextHash = 0; }
+
+    /**
+     * Release the layout of all the pages but the one given (if any) with Page::ReleaseLayout.
+     * Used with the low-memory option for keeping only the layout of the page being rendered. This also deletes the
+     * display lists of the pages.
+     */
+    void ReleaseLayouts(Page *activePage = NULL);
+
+    /**
+     * Start a lazy cast off of the entire document.
+     * The content page is kept as the last page of the document and its measures are cast off by chunks only when
+     * the pages are requested with Doc::CastOffLazyPages. Nothing is cast off by this method itself.
+     */
+    void CastOffDocLazy();
+
+    /**
+     * Cast off the pending measures of a lazy cast off until the document has pageCount pages (without the content
+     * page) or until the entire document is cast off (-1).
+     */
+    void CastOffLazyPages(int pageCount = -1);
+
+    /**
+     * Cast off the pending measures of a lazy cast off until the object is on a page that is cast off.
+     */
+    void CastOffLazyPagesUntil(Object *object);
+
+    /**
+     * Return true if the document is cast off lazily and still has measures to be cast off.
+     */
+    bool IsCastOffPending() const { return m_isCastOffPending; }
+
+    /**
+     * Return the number of pages cast off with an estimation of the number of pages for the pending measures of a
+     * lazy cast off. This is the page count when the document is not cast off lazily.
+     */
+    int GetEstimatedPageCount();
+
+    /**
+     * @name Cast off a range of measures as an excerpt and undo it.
+     * CastOffExcerpt moves the content of the systems from startMeasure to endMeasure to a page added at the end of
+     * the document and casts it off into systems. The excerpt page starts with the scoreDef effective at the
+     * beginning of startMeasure and has no header and footer. Only the excerpt page needs to be laid out for
+     * drawing it. Return false if the range is not valid.
+     * UnCastOffExcerpt moves the content back and deletes the excerpt page. The pages the content comes from are
+     * laid out again when they are drawn next.
      */
-    void CastOffDoc();
+    ///@{
+    bool CastOffExcerpt(Measure *startMeasure, Measure *endMeasure);
+    void UnCastOffExcerpt();
+    Page *GetExcerptPage() const { return m_excerptPage; }
+    ///@}
+
+    /**
+     * @name Track the modifications of the document.
+     * The modification count is incremented each time the content or the cast off of the document changes, and
+     * when it is reset. It is not reset to 0 so that a value read before remains different from the current one.
+     */
+    ///@{
+    void SetModified() { ++m_modificationCount; }
+    int GetModificationCount() const { return m_modificationCount; }
+    ///@}
+
+    /**
+     * @name Track the changes of the measures of the document.
+     * The measure generation is incremented each time the document creates or deletes measures, or moves their
+     * content, e.g., when converting mensural music, when their element parts are created again by PrepareDrawing, and
+     * when it is reset. It is not reset to 0 either.
+     */
+    ///@{
+    void SetMeasuresChanged() { ++m_measureGeneration; }
+    int GetMeasureGeneration() const { return m_measureGeneration; }
+    ///@}
 
     /**
      * Casts off the running elements (headers and footer)
@@ -337,6 +469,31 @@ private:
      */
     int CalcMusicFontSize();
 
+    /**
+     * Cast off the systems of the content page into pages and delete the content page.
+     * Called from Doc::CastOffDoc and Doc::ReflowDoc. The document must have no page.
+     */
+    void CastOffContentPage(Page *contentPage);
+
+    /**
+     * Cast off a chunk of measureCount measures from the pending content page of a lazy cast off.
+     * The last system and the last page are moved back to the content page unless the chunk is the last one.
+     * Return the number of pages added, 0 if the chunk was too short for filling one page.
+     */
+    int CastOffLazyChunk(int measureCount);
+
+    /**
+     * Move the content of the systems of the page (from systemIdx) back to the beginning of the pending system and
+     * delete the systems. Called from Doc::CastOffLazyChunk
+     */
+    void UnCastOffLazyPage(Page *page, System *pendingSystem, int systemIdx = 0);
+
+    /**
+     * Set the scoreDef of the excerpt page, starting with the one effective at the beginning of the range.
+     * Called from Doc::CastOffExcerpt
+     */
+    void CollectExcerptScoreDefs();
+
 public:
     /**
      * A copy of the header tree stored as pugi::xml_document
@@ -380,6 +537,66 @@ private:
      */
     Options *m_options;
 
+    /**
+     * The layout cache for the horizontal layout of the measures (not owned)
+     */
+    LayoutCache *m_layoutCache;
+
+    /**
+     * @name The values stored by CastOffDoc for re-flowing the document.
+     * m_castOffContextHash is the LayoutCache context hash of the cast off, 0 if it cannot be re-flowed.
+     * m_castOffPageWidth is the page width without the margins and m_castOffPageHeight the page height used for
+     * the vertical layout of the content page.
+     */
+    ///@{
+    uint64_t m_castOffContextHash;
+    int m_castOffPageWidth;
+    int m_castOffPageHeight;
+    int m_castOffScoreDefWidth;
+    int m_castOffLabelsWidth;
+    int m_castOffAbbrLabelsWidth;
+    ///@}
+
+    /**
+     * @name The values for the lazy cast off of the document.
+     * m_isCastOffPending is true as long as the last page is the content page with measures not cast off yet.
+     * m_lazyLongestActualDur is the longest duration of the entire document, used for the spacing of every chunk.
+     * m_lazyScoreDefWidth is the width of the current scoreDef at the end of the pages cast off.
+     * The height of the running elements is calculated once at the beginning.
+     * The number of measures and pages cast off so far gives the size of the next chunk.
+     * m_lazyScoreDef is the scoreDef at the beginning of the chunk being cast off.
+     */
+    ///@{
+    bool m_isCastOffPending;
+    int m_lazyLongestActualDur;
+    int m_lazyScoreDefWidth;
+    int m_lazyPgHeadHeight;
+    int m_lazyPgFootHeight;
+    int m_lazyPgHead2Height;
+    int m_lazyPgFoot2Height;
+    int m_lazyMeasureCount;
+    int m_lazyPageCount;
+    ScoreDef m_lazyScoreDef;
+    ///@}
+
+    /**
+     * @name The values for the cast off of an excerpt.
+     * m_excerptPage is the page added by CastOffExcerpt, NULL if no excerpt is cast off.
+     * m_excerptScoreDef is the scoreDef effective at the beginning of the range.
+     * The objects moved to the excerpt page are kept with their original parent and position for moving them back.
+     */
+    ///@{
+    Page *m_excerptPage;
+    ScoreDef m_excerptScoreDef;
+    ArrayOfObjects m_excerptObjects;
+    std::vector<std::pair<Object *, int> > m_excerptPositions;
+    ///@}
+
+    /** The modification count of the document */
+    int m_modificationCount;
+    /** The generation of the measures of the document */
+    int m_measureGeneration;
+
     /*
      * The following values are set in the Doc::SetDrawingPage.
      * They are all current values to be used when drawing a page in a View and
@@ -422,6 +639,14 @@ private:
      */
     bool m_drawingPreparationDone;
 
+    /**
+     * A vector for storing object / ids mapping of the groups of floating elements.
+     * When a group is created based on an object address, it is stack on the vector.
+     * The ids of the group is then the position in the vector + GRPS_BASE_ID.
+     * Groups coded in MEI have negative ids (-@vgrp value)
+     */
+    std::vector<void *> m_drawingGrpObjects;
+
     /**
      * A flag to indicate that the MIDI timemap has been calculated.  The
      * timemap needs to be prepared before MIDI files or timemap JSON files
@@ -124,14 +124,6 @@ private:
 
     /* Drawing Id to group floating elements horizontally */
     int m_drawingGrpId;
-
-    /**
-     * A vector for storing object / ids mapping.
-     * When a group is created based on an object address, it is stack on the vector.
-     * The ids of the group is then the position in the vector + GRPS_BASE_ID.
-     * Groups coded in MEI have negative ids (-@vgrp value)
-     */
-    static std::vector<void *> s_drawingObjectIds;
 };
 
 //----------------------------------------------------------------------------
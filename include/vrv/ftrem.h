@@ -72,6 +72,11 @@ public:
      */
     virtual int ResetDrawing(FunctorParams *functorParams);
 
+    /**
+     * See Object::CalcMemoryStats
+     */
+    virtual int CalcMemoryStats(FunctorParams *functorParams);
+
 private:
     //
 protected:
@@ -28,10 +28,12 @@ class FileOutputStream;
 class Hairpin;
 class Harm;
 class KeySig;
+class LayoutCache;
 class Layer;
 class LayerElement;
 class Measure;
 class MeasureAligner;
+class MemoryStats;
 class Mensur;
 class MeterSig;
 class MRpt;
@@ -510,6 +512,35 @@ public:
     Page *m_page;
 };
 
+//----------------------------------------------------------------------------
+// CacheHorizontalLayoutParams
+//----------------------------------------------------------------------------
+
+/**
+ * member 0: the layout cache
+ * member 1: the hash of the document-wide layout context (see LayoutCache::CalcContextHash)
+ * member 2: a flag indicating if we are restoring (true) or storing (false) the horizontal layout
+ * member 3: the number of measures restored from the cache
+ * member 4: the doc
+ **/
+
+class CacheHorizontalLayoutParams : public FunctorParams {
+public:
+    CacheHorizontalLayoutParams(LayoutCache *layoutCache, uint64_t contextHash, Doc *doc)
+    {
+        m_layoutCache = layoutCache;
+        m_contextHash = contextHash;
+        m_restore = true;
+        m_restoredCount = 0;
+        m_doc = doc;
+    }
+    LayoutCache *m_layoutCache;
+    uint64_t m_contextHash;
+    bool m_restore;
+    int m_restoredCount;
+    Doc *m_doc;
+};
+
 //----------------------------------------------------------------------------
 // CalcArticParams
 //----------------------------------------------------------------------------
@@ -522,6 +553,20 @@ public:
 
 // Use FunctorDocParams
 
+//----------------------------------------------------------------------------
+// CalcContentHashParams
+//----------------------------------------------------------------------------
+
+/**
+ * member 0: the hash being calculated
+ **/
+
+class CalcContentHashParams : public FunctorParams {
+public:
+    CalcContentHashParams(uint64_t hash) { m_hash = hash; }
+    uint64_t m_hash;
+};
+
 //----------------------------------------------------------------------------
 // CalcDotsParams
 //----------------------------------------------------------------------------
@@ -579,6 +624,20 @@ public:
     int m_currentTempo;
 };
 
+//----------------------------------------------------------------------------
+// CalcMemoryStatsParams
+//----------------------------------------------------------------------------
+
+/**
+ * member 0: a pointer to the MemoryStats being filled
+ **/
+
+class CalcMemoryStatsParams : public FunctorParams {
+public:
+    CalcMemoryStatsParams(MemoryStats *memoryStats) { m_memoryStats = memoryStats; }
+    MemoryStats *m_memoryStats;
+};
+
 //----------------------------------------------------------------------------
 // CalcOnsetOffset
 //----------------------------------------------------------------------------
@@ -1179,6 +1238,20 @@ public:
     std::map<std::string, Harm *> m_harms;
 };
 
+//----------------------------------------------------------------------------
+// PrepareMeasureContentParams
+//----------------------------------------------------------------------------
+
+/**
+ * member 0: a pointer to the current measure
+ **/
+
+class PrepareMeasureContentParams : public FunctorParams {
+public:
+    PrepareMeasureContentParams() { m_currentMeasure = NULL; }
+    Measure *m_currentMeasure;
+};
+
 //----------------------------------------------------------------------------
 // PrepareCrossStaffParams
 //----------------------------------------------------------------------------
@@ -1458,6 +1531,9 @@ public:
  * member 4: the current system (for setting the system scoreDef)
  * member 5: the flag indicating whereas full labels have to be drawn
  * member 6: the doc
+ * member 7: the measure for which the effective scoreDef is retrieved (optional)
+ * member 8: the scoreDef to which the upcoming scoreDef is copied when reaching that measure
+ * member 9: the flag indicating whereas the cautionary scoreDef of the previous measure is already set
  **/
 
 class SetCurrentScoreDefParams : public FunctorParams {
@@ -1471,6 +1547,9 @@ public:
         m_currentSystem = NULL;
         m_drawLabels = false;
         m_doc = doc;
+        m_scoreDefMeasure = NULL;
+        m_measureScoreDef = NULL;
+        m_cautionaryScoreDefDone = false;
     }
     ScoreDef *m_currentScoreDef;
     StaffDef *m_currentStaffDef;
@@ -1479,6 +1558,9 @@ public:
     System *m_currentSystem;
     bool m_drawLabels;
     Doc *m_doc;
+    Measure *m_scoreDefMeasure;
+    ScoreDef *m_measureScoreDef;
+    bool m_cautionaryScoreDefDone;
 };
 
 //----------------------------------------------------------------------------
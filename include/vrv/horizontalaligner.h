@@ -76,6 +76,7 @@ public:
     Alignment(double time, AlignmentType type = ALIGNMENT_DEFAULT);
     virtual ~Alignment();
     virtual void Reset();
+    virtual std::string GetClassName() const { return "Alignment"; }
     virtual ClassId GetClassId() const { return ALIGNMENT; }
     ///@}
     
@@ -143,6 +144,11 @@ public:
      */
     bool HasGraceAligner(int id) const;
 
+    /**
+     * Return the map of GraceAligner objects of the Alignment (if any)
+     */
+    const MapOfIntGraceAligners *GetGraceAligners() const { return &m_graceAligners; }
+
     /**
      * Return the AlignmentReference holding the element.
      * If staffN is provided, uses the AlignmentReference->GetN() to accelerate the search.
@@ -278,6 +284,7 @@ public:
     AlignmentReference(int staffN);
     virtual ~AlignmentReference();
     virtual void Reset();
+    virtual std::string GetClassName() const { return "AlignmentReference"; }
     virtual ClassId GetClassId() const { return ALIGNMENT_REFERENCE; }
     ///@}
 
@@ -404,6 +411,7 @@ public:
     ///@(
     MeasureAligner();
     virtual ~MeasureAligner();
+    virtual std::string GetClassName() const { return "MeasureAligner"; }
     virtual ClassId GetClassId() const { return MEASURE_ALIGNER; }
     virtual void Reset();
     ///@}
@@ -526,6 +534,7 @@ public:
     ///@(
     GraceAligner();
     virtual ~GraceAligner();
+    virtual std::string GetClassName() const { return "GraceAligner"; }
     virtual ClassId GetClassId() const { return GRACE_ALIGNER; }
     virtual void Reset();
     ///@}
@@ -607,6 +616,7 @@ public:
     // constructors and destructors
     TimestampAligner();
     virtual ~TimestampAligner();
+    virtual std::string GetClassName() const { return "TimestampAligner"; }
     virtual ClassId GetClassId() const { return TIMESTAMP_ALIGNER; }
 
     /**
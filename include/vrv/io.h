@@ -14,6 +14,7 @@
 namespace vrv {
 
 class Doc;
+class MemoryStats;
 class Object;
 
 //----------------------------------------------------------------------------
@@ -81,6 +82,11 @@ public:
      */
     bool HasLayoutInformation() { return m_hasLayoutInformation; }
 
+    /**
+     * Set the MemoryStats in which the size of the XML DOM (if any) is recorded during the import
+     */
+    void SetMemoryStats(MemoryStats *memoryStats) { m_memoryStats = memoryStats; }
+
 private:
     /**
      * Init values (called by the constructors)
@@ -100,6 +106,11 @@ protected:
      */
     bool m_hasLayoutInformation;
 
+    /**
+     * The MemoryStats for the XML DOM (NULL by default)
+     */
+    MemoryStats *m_memoryStats;
+
     std::string m_outformat = "mei";
 };
 
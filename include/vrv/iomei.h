@@ -595,6 +595,11 @@ private:
      */
     bool IsEditorialElementName(std::string elementName);
 
+    /**
+     * Returns true if the <mdiv> is the selected one or one of its ancestors
+     */
+    bool IsSelectedMdiv(pugi::xml_node mdiv);
+
     /**
      * Read score-based MEI.
      * The data is read into an object, which is then converted to page-based MEI.
@@ -655,7 +660,7 @@ private:
     /**
      * A static array for storing the implemented editorial elements
      */
-    static std::vector<std::string> s_editorialElementNames;
+    static const std::vector<std::string> s_editorialElementNames;
 
     /**
      * The selected <mdiv>.
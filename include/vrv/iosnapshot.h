@@ -0,0 +1,383 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        iosnapshot.h
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRV_IOSNAPSHOT_H__
+#define __VRV_IOSNAPSHOT_H__
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+#include "io.h"
+#include "vrvdef.h"
+
+namespace vrv {
+
+/**
+ * The flags of the document in a snapshot
+ */
+enum SnapshotDocFlag {
+    SNAPSHOT_DOC_CAST_OFF_PAGES = 1,
+    SNAPSHOT_DOC_LAYOUT_INFORMATION = 2,
+    SNAPSHOT_DOC_PREPARED = 4
+};
+
+/**
+ * The flags of the objects in a snapshot
+ */
+enum SnapshotObjectFlag {
+    SNAPSHOT_OBJECT_ATTRIBUTE = 1,
+    SNAPSHOT_OBJECT_GENERATED = 2,
+    SNAPSHOT_OBJECT_HIDDEN = 4,
+    SNAPSHOT_OBJECT_UNMEASURED = 8,
+    SNAPSHOT_OBJECT_COMMENT = 16
+};
+
+/**
+ * The flags of the drawing values set by Doc::PrepareDrawing for an object in a snapshot
+ */
+enum SnapshotPreparedFlag {
+    SNAPSHOT_PREPARED_START = 1,
+    SNAPSHOT_PREPARED_END = 2,
+    SNAPSHOT_PREPARED_REFERENCES = 4,
+    SNAPSHOT_PREPARED_CROSS_STAFF = 8,
+    SNAPSHOT_PREPARED_CUE_SIZE = 16,
+    SNAPSHOT_PREPARED_STEM = 32,
+    SNAPSHOT_PREPARED_DOT = 64,
+    SNAPSHOT_PREPARED_VERSE = 128,
+    SNAPSHOT_PREPARED_MEASURE_COUNT = 256,
+    SNAPSHOT_PREPARED_MEASURE = 512,
+    SNAPSHOT_PREPARED_ENDING = 1024,
+    SNAPSHOT_PREPARED_GRP_ID = 2048,
+    SNAPSHOT_PREPARED_LINKS = 4096,
+    SNAPSHOT_PREPARED_TIME_SPANNING = 8192,
+    SNAPSHOT_PREPARED_CONTENT = 16384
+};
+
+//----------------------------------------------------------------------------
+// SnapshotCacheEntry
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds a measure encoded by SnapshotOutput with the number of objects in it.
+ */
+class SnapshotCacheEntry {
+public:
+    std::string m_data;
+    int m_objectCount;
+};
+
+//----------------------------------------------------------------------------
+// SnapshotCache
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds the measures encoded by SnapshotOutput for reusing them in the next snapshots.
+ * Since the measures are encoded independently from the rest of the snapshot, only the measures modified since the
+ * previous snapshot have to be encoded again. The measures are identified by their uuid and the cache is cleared when
+ * the measure generation of the document changes, i.e., when the document deletes or re-creates measures. The owner of
+ * the cache still has to invalidate the measures it modifies.
+ */
+class SnapshotCache {
+public:
+    /** @name Constructors and destructor */
+    ///@{
+    SnapshotCache() { m_measureGeneration = -1; }
+    virtual ~SnapshotCache() {}
+    ///@}
+
+    /**
+     * Clear the cache if the measure generation of the document is not the one of the measures in it
+     */
+    void Synchronize(int measureGeneration);
+
+    /**
+     * Invalidate the measure of the object - nothing is done if it is not within a measure
+     */
+    void Invalidate(Object *object);
+
+    /**
+     * Clear the cache
+     */
+    void Clear()
+    {
+        m_measures.clear();
+        m_measureGeneration = -1;
+    }
+
+    /**
+     * @name Getter and setter for the encoded measures
+     * GetMeasure returns NULL if the measure is not in the cache
+     */
+    ///@{
+    const SnapshotCacheEntry *GetMeasure(Object *measure) const;
+    const SnapshotCacheEntry *SetMeasure(Object *measure, const SnapshotCacheEntry &entry);
+    ///@}
+
+    /**
+     * @name Return the number of measures and the approximate memory size of the cache in bytes
+     */
+    ///@{
+    int GetMeasureCount() const { return (int)m_measures.size(); }
+    size_t GetMemorySize() const;
+    ///@}
+
+private:
+    //
+public:
+    //
+private:
+    /** The encoded measures by uuid */
+    std::map<std::string, SnapshotCacheEntry> m_measures;
+    /** The measure generation of the document the measures were encoded from */
+    int m_measureGeneration;
+};
+
+//----------------------------------------------------------------------------
+// SnapshotOutput
+//----------------------------------------------------------------------------
+
+/**
+ * This class is an output stream for writing a binary snapshot of a prepared document.
+ * The snapshot holds the object tree with the attributes, the values that are not attributes (e.g., the text or the
+ * visibility of editorial elements) and the pointers to other objects stored as the index of the object in the
+ * snapshot. The strings are stored only once. For a document prepared for drawing, the element parts are part of the
+ * tree and the drawing values set by Doc::PrepareDrawing (e.g., the start and end of the time spanning elements or the
+ * cross-staff pointers) are written after it, so that the document can be loaded without preparing it again. With
+ * cast-off pages, the pages and systems are kept as they are with the hash of the options they were cast off with.
+ * Otherwise, the content of the pages is written in one single page and system, as for a document that is not cast
+ * off.
+ * The measures are written as chunks with their own shared strings and can be taken from a SnapshotCache.
+ * Snapshots are specific to the version of Verovio that wrote them. Transcription documents and mensural music that
+ * is not converted to a cast-off document yet are not supported.
+ */
+class SnapshotOutput : public FileOutputStream {
+public:
+    /** @name Constructors and destructor */
+    ///@{
+    SnapshotOutput(Doc *doc, std::string filename);
+    virtual ~SnapshotOutput();
+    ///@}
+
+    /**
+     * The main method for exporting the snapshot to the file.
+     */
+    virtual bool ExportFile();
+
+    /**
+     * Return the snapshot as a (binary) string - empty if the document is not supported.
+     */
+    std::string GetOutput();
+
+    /**
+     * Setter for keeping the cast-off pages with the hash of the options they were cast off with
+     */
+    void SetCastOffPages(bool castOffPages, uint64_t optionsHash);
+
+    /**
+     * Setter for the cache of the encoded measures
+     */
+    void SetCache(SnapshotCache *cache) { m_cache = cache; }
+
+private:
+    /**
+     * Write the document to m_output
+     */
+    bool WriteDoc();
+
+    /**
+     * Write the object and its descendants.
+     * With the children parameter, the children given are written instead of the ones of the object.
+     * WriteObjectRecord writes it without the class id and WriteObjectContent without the class id and the children.
+     */
+    ///@{
+    bool WriteObject(Object *object, const ArrayOfObjects *children = NULL);
+    bool WriteObjectRecord(Object *object, const ArrayOfObjects *children = NULL);
+    bool WriteObjectContent(Object *object);
+    ///@}
+
+    /**
+     * Write the measure as a chunk, from the cache if it is there
+     */
+    bool WriteMeasureChunk(Object *measure);
+
+    /**
+     * Index the object and its descendants as they are in a measure chunk taken from the cache
+     */
+    void IndexObjects(Object *object);
+
+    /**
+     * Fill the children of the object to write in the order they have to be read
+     */
+    void GetChildrenToWrite(Object *object, ArrayOfObjects &children);
+
+    /**
+     * Write the drawing values of the objects set by Doc::PrepareDrawing.
+     * Each object with values is written with the difference from the index of the previous one and the flags of
+     * the values. The list ends with 0.
+     */
+    bool WritePreparedValues();
+
+    /**
+     * Write a pointer to another object - 0 for NULL, an odd value for the index and an even value followed by the
+     * time for a timestamp of a measure
+     */
+    bool WriteReference(Object *object);
+
+    /**
+     * Write the pages of the document in one single page and system
+     */
+    bool WriteContentPages(Object *pages);
+
+    /**
+     * @name Write values to m_output
+     */
+    ///@{
+    void WriteUInt(uint64_t value);
+    void WriteInt(int64_t value);
+    void WriteDouble(double value);
+    void WriteString(const std::string &value);
+    void WriteSharedString(const std::string &value);
+    ///@}
+
+public:
+    //
+private:
+    std::string m_filename;
+    std::string m_output;
+    SnapshotCache *m_cache;
+    bool m_castOffPages;
+    uint64_t m_optionsHash;
+    /** True when the document is prepared for drawing and the prepared values are written */
+    bool m_prepared;
+    /** The number of objects written so far, which is the index of the next one */
+    int m_objectCount;
+    /** The index of the objects written and the objects by index */
+    std::unordered_map<Object *, int> m_objectIndexes;
+    std::vector<Object *> m_indexedObjects;
+    /** The index of the strings written as shared strings */
+    std::map<std::string, int> m_sharedStrings;
+};
+
+//----------------------------------------------------------------------------
+// SnapshotInput
+//----------------------------------------------------------------------------
+
+/**
+ * This class is an input stream for reading a snapshot written by SnapshotOutput.
+ * The document does not need to be cast off again when the snapshot has cast-off pages and the options have the same
+ * hash as the ones they were cast off with. Otherwise, the pages are read into one single page and system.
+ */
+class SnapshotInput : public FileInputStream {
+public:
+    // constructors and destructors
+    SnapshotInput(Doc *doc, std::string filename);
+    virtual ~SnapshotInput();
+
+    virtual bool ImportFile();
+    virtual bool ImportString(std::string const &snapshot);
+
+    /**
+     * Setter for the hash of the current options, compared to the one of the cast-off pages of the snapshot
+     */
+    void SetOptionsHash(uint64_t optionsHash) { m_optionsHash = optionsHash; }
+
+    /**
+     * Return true if the cast-off pages of the snapshot were read
+     */
+    bool HasCastOffPages() const { return m_hasCastOffPages; }
+
+    /**
+     * Return true if the drawing values were read and the document does not need to be prepared for drawing
+     */
+    bool IsPrepared() const { return m_isPrepared; }
+
+    /**
+     * Return true if the data starts like a snapshot
+     */
+    static bool IsSnapshot(const std::string &data);
+
+private:
+    bool ReadDoc();
+
+    /**
+     * Read an object and its descendants and add it to the parent.
+     * The children of the pages and of the systems are added to the first one of the parent when flattening the pages.
+     * ReadObjectRecord reads it once the class id is read and ReadObjectContent without the children.
+     */
+    ///@{
+    bool ReadObject(Object *parent);
+    bool ReadObjectRecord(Object *parent, ClassId classId);
+    bool ReadObjectContent(Object *object, int flags);
+    ///@}
+
+    /**
+     * Read a measure chunk with its own shared strings
+     */
+    bool ReadMeasureChunk(Object *parent);
+
+    /**
+     * Read the drawing values written by SnapshotOutput::WritePreparedValues
+     */
+    bool ReadPreparedValues();
+
+    /**
+     * Read a pointer written by SnapshotOutput::WriteReference
+     */
+    bool ReadReference(Object *&object);
+
+    /**
+     * Create an object of the class - NULL if it is not supported
+     */
+    Object *CreateObject(ClassId classId, int flags);
+
+    /**
+     * Set the attribute through the attribute classes or as an unsupported attribute.
+     * The nameId is the id of the name in the shared strings.
+     */
+    void SetAttribute(Object *object, int nameId, const std::string &name, const std::string &value);
+
+    /**
+     * @name Read values from m_input - they return false if the end of the input is reached
+     */
+    ///@{
+    bool ReadUInt(uint64_t &value);
+    bool ReadInt(int64_t &value);
+    bool ReadInt(int &value);
+    bool ReadDouble(double &value);
+    bool ReadString(std::string &value);
+    bool ReadSharedString(std::string &value, int *id = NULL);
+    ///@}
+
+public:
+    //
+private:
+    std::string m_filename;
+    const std::string *m_input;
+    size_t m_position;
+    uint64_t m_optionsHash;
+    bool m_hasCastOffPages;
+    bool m_isPrepared;
+    /** True when the cast-off pages are read into one page and one system */
+    bool m_flattenPages;
+    /** The objects read so far by index (the first page or system for the ones that were merged into it) */
+    std::vector<Object *> m_objects;
+    std::vector<std::string> m_sharedStrings;
+    /** The id of the shared strings, which remains the same across the measure chunks */
+    std::vector<int> m_sharedStringIds;
+    std::map<std::string, int> m_stringIds;
+    /** The index of the attribute setter for a class and the id of an attribute name (-1 for unsupported) */
+    std::map<std::pair<int, int>, int> m_attSetters;
+};
+
+} // namespace vrv
+
+#endif // __VRV_IOSNAPSHOT_H__
@@ -92,6 +92,11 @@ public:
     Beam *IsInBeam();
     ///@}
 
+    /**
+     * Setter for the drawing cue size, e.g., when restoring it from a snapshot (see Object::PrepareDrawingCueSize)
+     */
+    void SetDrawingCueSize(bool drawingCueSize) { m_drawingCueSize = drawingCueSize; }
+
     /**
      * @name Get and set the layerN drawing value
      */
@@ -0,0 +1,129 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        layoutcache.h
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRV_LAYOUT_CACHE_H__
+#define __VRV_LAYOUT_CACHE_H__
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+#include "vrvdef.h"
+
+namespace vrv {
+
+class Doc;
+
+/**
+ * The maximum number of measures kept in the LayoutCache - the least recently used ones are evicted first
+ */
+#define LAYOUT_CACHE_MAX_ENTRIES 50000
+
+//----------------------------------------------------------------------------
+// LayoutCacheEntry
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds the horizontal layout of one measure, that is the x positions of its
+ * Alignment objects (including the ones of the GraceAligner) and the x positions of the
+ * LayerElement objects they reference, both in the order given by Measure::GetHorizontalLayoutObjects.
+ */
+class LayoutCacheEntry {
+public:
+    std::vector<int> m_alignmentXRels;
+    std::vector<int> m_elementXRels;
+};
+
+//----------------------------------------------------------------------------
+// LayoutCache
+//----------------------------------------------------------------------------
+
+/**
+ * This class stores the result of the horizontal adjustment of measures (AdjustLayers, AdjustAccidX,
+ * AdjustXPos and AdjustGraceXPos) under a key built from the content hash of the measure and from
+ * its layout context. See Measure::CacheHorizontalLayout.
+ * It is owned by the Toolkit and survives the loading of new data. It can be saved to and loaded
+ * from a file. It is used only with the layoutCache option.
+ */
+class LayoutCache {
+public:
+    /**
+     * @name Constructors, destructors, and other standard methods
+     */
+    ///@{
+    LayoutCache();
+    virtual ~LayoutCache();
+    void Reset();
+    ///@}
+
+    /**
+     * @name Load and save the cache from / to a file
+     */
+    ///@{
+    bool Load(const std::string &filename);
+    bool Save(const std::string &filename);
+    ///@}
+
+    /**
+     * Return true if entries have been added since the last Load, Save or Reset
+     */
+    bool IsModified() const { return m_isModified; }
+
+    /**
+     * Return the number of measures stored in the cache
+     */
+    int GetEntryCount() const { return (int)m_entries.size(); }
+
+    /**
+     * Return the approximate memory size of the cache in bytes, including the list of the keys
+     */
+    size_t GetMemorySize() const;
+
+    /**
+     * @name Get and set the entry for a key.
+     * GetEntry returns NULL if no entry is available for the key. Both mark the entry as the most recently used one.
+     */
+    ///@{
+    const LayoutCacheEntry *GetEntry(uint64_t key);
+    void SetEntry(uint64_t key, const LayoutCacheEntry &entry);
+    ///@}
+
+    /**
+     * @name Mix a value into a hash (64-bit FNV-1a).
+     * The hash is independent from the platform and can be stored in a file.
+     */
+    ///@{
+    static void Hash(uint64_t &hash, int value);
+    static void Hash(uint64_t &hash, uint64_t value);
+    static void Hash(uint64_t &hash, const std::string &value);
+    ///@}
+
+    /**
+     * Calculate the hash of the document-wide values the horizontal layout depends on (options, drawing unit)
+     */
+    static uint64_t CalcContextHash(Doc *doc);
+
+public:
+    /** The initial value of a hash */
+    static const uint64_t s_hashInit;
+
+private:
+    typedef std::list<uint64_t> ListOfKeys;
+
+    /** The entries with their position in m_keys */
+    std::map<uint64_t, std::pair<LayoutCacheEntry, ListOfKeys::iterator> > m_entries;
+    /** The keys from the least to the most recently used */
+    ListOfKeys m_keys;
+    bool m_isModified;
+};
+
+} // namespace vrv
+
+#endif
@@ -8,10 +8,15 @@
 #ifndef __VRV_MEASURE_H__
 #define __VRV_MEASURE_H__
 
+#include <bitset>
+
+//----------------------------------------------------------------------------
+
 #include "atts_cmn.h"
 #include "atts_shared.h"
 #include "barline.h"
 #include "horizontalaligner.h"
+#include "layoutcache.h"
 #include "object.h"
 
 namespace vrv {
@@ -154,6 +159,22 @@ public:
      */
     int GetInnerCenterX() const;
 
+    /**
+     * @name Store and restore the horizontal layout of the measure in the content page.
+     * It is stored by Doc::CastOffDoc and restored by Page::LayOutHorizontally when the document is re-flowed
+     * (see Doc::ReflowDoc). RestoreCastOffLayout returns false if the content does not match the stored layout.
+     */
+    ///@{
+    void StoreCastOffLayout();
+    bool RestoreCastOffLayout(bool checkOnly);
+    ///@}
+
+    /**
+     * Delete the alignments of the measure aligner. The duration of the measure is kept since it is needed for the
+     * MIDI timemap. Called from Page::ReleaseLayout after the horizontal alignment was reset.
+     */
+    void ReleaseAlignments();
+
     /**
      * @name Setter and getter of the drawing scoreDef
      */
@@ -170,6 +191,40 @@ public:
     void SetDrawingEnding(Ending *ending) { m_drawingEnding = ending; }
     ///@}
 
+    /**
+     * @name Set and check the content of the measure.
+     * The content flags are filled by Object::PrepareMeasureContent at the end of Doc::PrepareDrawing.
+     * They make it possible to check if the measure contains an element of a given type without looking for it in the
+     * subtree. If the flags are not set, HasContentOfType falls back to FindChildByType.
+     */
+    ///@{
+    void ResetContent();
+    void AddContent(Object *object);
+    bool HasContentOfType(ClassId classId);
+    ///@}
+
+    /**
+     * @name Getters and setter of the content flags for restoring them without PrepareDrawing, i.e., from a snapshot
+     */
+    ///@{
+    bool IsContentDone() const { return m_contentDone; }
+    bool HasCrossStaffContent() const { return m_hasCrossStaffContent; }
+    const std::bitset<UNSPECIFIED> &GetContentClassIds() const { return m_contentClassIds; }
+    void SetContent(const std::bitset<UNSPECIFIED> &contentClassIds, bool hasCrossStaffContent);
+    ///@}
+
+    /**
+     * Return the hash of the content of the measure (see Object::CalcContentHash).
+     * The hash is calculated on the first call and reset with the content flags.
+     */
+    uint64_t GetContentHash();
+
+    /**
+     * Return false if the horizontal layout was restored from the LayoutCache and if the measure has no content
+     * adjusted afterwards with the bounding boxes (syl and arpeg)
+     */
+    bool NeedsHorizontalBoundingBoxes();
+
     /*
      * Return the first staff of each staffGrp according to the scoreDef
      */
@@ -210,6 +265,11 @@ public:
      */
     virtual int ConvertToUnCastOffMensural(FunctorParams *params);
 
+    /**
+     * See Object::CalcMemoryStats
+     */
+    virtual int CalcMemoryStats(FunctorParams *functorParams);
+
     /**
      * See Object::Save
      */
@@ -274,6 +334,11 @@ public:
      */
     virtual int AdjustXPos(FunctorParams *functorParams);
 
+    /**
+     * See Object::CacheHorizontalLayout
+     */
+    virtual int CacheHorizontalLayout(FunctorParams *functorParams);
+
     /**
      * See Object::AdjustSylSpacing
      */
@@ -314,6 +379,14 @@ public:
      */
     virtual int PrepareCrossStaff(FunctorParams *functorParams);
 
+    /**
+     * @name See Object::PrepareMeasureContent
+     */
+    ///@{
+    virtual int PrepareMeasureContent(FunctorParams *functorParams);
+    virtual int PrepareMeasureContentEnd(FunctorParams *functorParams);
+    ///@}
+
     /**
      * @name See Object::PrepareFloatingGrps
      */
@@ -392,6 +465,23 @@ protected:
      */
     int m_drawingXRel;
 
+private:
+    /**
+     * Fill the Alignment objects of the MeasureAligner (including the ones of the GraceAligner objects) and
+     * the LayerElement objects they reference. This is the order in which they are stored in the LayoutCache.
+     */
+    void GetHorizontalLayoutObjects(std::vector<Alignment *> &alignments, std::vector<LayerElement *> &elements);
+
+    /**
+     * Calculate the key of the measure in the LayoutCache.
+     * The key combines the content hash, the current drawing staffDef values, and the positions of the content
+     * before the bounding boxes are calculated. It does not depend on the position of the measure in the system.
+     */
+    uint64_t CalcHorizontalLayoutKey(uint64_t contextHash, const std::vector<Alignment *> &alignments,
+        const std::vector<LayerElement *> &elements);
+
+public:
+    //
 private:
     bool m_measuredMusic;
 
@@ -422,6 +512,35 @@ private:
      */
     bool m_hasAlignmentRefWithMultipleLayers;
 
+    /**
+     * @name The ClassIds of the content of the measure and flags for them being set and having cross-staff content.
+     * Filled by Object::PrepareMeasureContent
+     */
+    ///@{
+    std::bitset<UNSPECIFIED> m_contentClassIds;
+    bool m_contentDone;
+    bool m_hasCrossStaffContent;
+    ///@}
+
+    /**
+     * The hash of the content of the measure (0 if not calculated yet)
+     */
+    uint64_t m_contentHash;
+
+    /**
+     * @name The key of the measure in the LayoutCache (0 if it cannot be cached) and a flag
+     * indicating that the horizontal layout was restored from it. Reset by ResetHorizontalAlignment.
+     */
+    ///@{
+    uint64_t m_horizontalLayoutKey;
+    bool m_horizontalLayoutCached;
+    ///@}
+
+    /**
+     * The horizontal layout in the content page stored by StoreCastOffLayout
+     */
+    LayoutCacheEntry m_castOffLayout;
+
     /**
      * Start time state variables.
      */
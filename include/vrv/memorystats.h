@@ -0,0 +1,133 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        memorystats.h
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRV_MEMORY_STATS_H__
+#define __VRV_MEMORY_STATS_H__
+
+#include <map>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "vrvdef.h"
+
+namespace pugi {
+class xml_node;
+}
+
+namespace vrv {
+
+class Object;
+
+/**
+ * The groups of the entries in MemoryStats
+ */
+enum MemoryStatsGroup {
+    MEMORY_STATS_DOC = 0, // The objects of the Doc tree
+    MEMORY_STATS_LAYOUT, // The layout-only structures (aligners, positioners, ledger lines, beam coordinates)
+    MEMORY_STATS_XML, // The pugixml DOMs held during the import and the SVG rendering
+    MEMORY_STATS_CACHE, // The caches of the Toolkit and the Doc (display lists, SVG, layout, snapshot, trace events)
+    MEMORY_STATS_GROUP_COUNT
+};
+
+/**
+ * The approximate size of the node of a std::map or std::list without its value (the allocator header and pointers)
+ */
+#define MEMORY_STATS_NODE_SIZE (4 * sizeof(void *))
+
+//----------------------------------------------------------------------------
+// MemoryStatsEntry
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds the number of items and their approximate size in bytes for one entry of MemoryStats
+ */
+class MemoryStatsEntry {
+public:
+    MemoryStatsEntry()
+    {
+        m_count = 0;
+        m_bytes = 0;
+    }
+    int m_count;
+    size_t m_bytes;
+};
+
+typedef std::map<std::string, MemoryStatsEntry> MapOfStrMemoryStatsEntries;
+
+//----------------------------------------------------------------------------
+// MemoryStats
+//----------------------------------------------------------------------------
+
+/**
+ * This class accumulates the number and the approximate size of the objects and structures held by a Toolkit.
+ * The entries are grouped (see MemoryStatsGroup) and named by class. The sizes are approximate: for an Object, it is
+ * the size of the class and of its array of children, and the strings and containers of the attribute classes are
+ * not counted. For XML DOMs, it is the size of the nodes and attributes and of their names and values as stored by
+ * pugixml, without the allocator overhead. It is filled by the Object::CalcMemoryStats functor.
+ */
+class MemoryStats {
+public:
+    /**
+     * @name Constructors, destructors, and other standard methods
+     */
+    ///@{
+    MemoryStats();
+    virtual ~MemoryStats();
+    void Reset();
+    ///@}
+
+    /**
+     * Add the items to the entry with the name in the group
+     */
+    void Add(MemoryStatsGroup group, const std::string &name, int count, size_t bytes);
+
+    /**
+     * Add the object to the entry of its class in the group
+     */
+    void AddObject(MemoryStatsGroup group, const Object *object);
+
+    /**
+     * Add the object and all its descendants to the entries of their class in the group.
+     * The children of reference objects are not added since they are not owned by them.
+     * This includes the GraceAligner objects of the Alignment objects and the FloatingPositioner objects
+     * of the StaffAlignment objects that are not children.
+     */
+    void AddObjectTree(MemoryStatsGroup group, const Object *object);
+
+    /**
+     * Replace the entry with the name in the XML group with the size of the DOM of the node
+     */
+    void SetXml(const std::string &name, const pugi::xml_node &node);
+
+    /**
+     * Merge the entries of another MemoryStats
+     */
+    void Merge(const MemoryStats &memoryStats);
+
+    /**
+     * Return the entries of the group
+     */
+    const MapOfStrMemoryStatsEntries *GetEntries(MemoryStatsGroup group) const { return &m_entries[group]; }
+
+    /**
+     * Return the size of the class of the ClassId.
+     * All the classes derived from Object have to be listed.
+     */
+    static size_t GetClassSize(ClassId classId);
+
+private:
+    //
+public:
+    //
+private:
+    MapOfStrMemoryStatsEntries m_entries[MEMORY_STATS_GROUP_COUNT];
+};
+
+} // namespace vrv
+
+#endif // __VRV_MEMORY_STATS_H__
@@ -63,17 +63,7 @@ public:
 private:
     //
 public:
-    /**
-     * Static member for setting a value from a controller.
-     * Used for example in SetValue
-     */
-    static int s_num;
-    /**
-     * Static member for setting a value from a controller.
-     * Used for examle in SetValue.
-     */
-    static int s_numBase;
-
+    //
 private:
 };
 
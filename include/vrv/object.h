@@ -13,6 +13,7 @@
 #include <iterator>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 //----------------------------------------------------------------------------
 
@@ -229,7 +230,15 @@ public:
     void SetUuid(std::string uuid);
     void SwapUuid(Object *other);
     void ResetUuid();
+
+    /**
+     * @name Seed the generator of the current thread used for the uuids and generate a number with it.
+     * The generator is seeded with the time (and the thread) when SeedUuid is called with 0 or when it is used first.
+     */
+    ///@{
     static void SeedUuid(unsigned int seed = 0);
+    static int GenerateUuidNumber();
+    ///@}
 
     std::string GetComment() const { return m_comment; }
     void SetComment(std::string comment) { m_comment = comment; }
@@ -245,6 +254,15 @@ public:
     int GetChildCount(const ClassId classId) const;
     ///@}
 
+    /**
+     * @name Descendant count, with or without a ClassId.
+     * The methods count at all levels, the object itself excluded.
+     */
+    ///@{
+    int GetDescendantCount() const;
+    int GetDescendantCount(const ClassId classId) const;
+    ///@}
+
     /**
      * Child access (generic)
      */
@@ -304,6 +322,7 @@ public:
 
     /**
      * Return the index position of the object in its parent (-1 if not found)
+     * The position is cached (see Object::GetChildIndex)
      */
     int GetIdx() const;
 
@@ -326,6 +345,8 @@ public:
 
     /**
      * Look for the Object in the children and return its position (-1 if not found)
+     * The position cached in the child is used if it is still valid. Otherwise, the positions of all the children are
+     * cached again, which means that the children array is looked at only after a structural change.
      */
     int GetChildIndex(const Object *child);
 
@@ -661,6 +682,12 @@ public:
     virtual int AdjustXPosEnd(FunctorParams *) { return FUNCTOR_CONTINUE; }
     ///@}
 
+    /**
+     * Restore the horizontal adjustment of the measures from the LayoutCache or store it into it.
+     * When restored, AdjustLayers, AdjustAccidX, AdjustXPos and AdjustGraceXPos are skipped for the measure.
+     */
+    virtual int CacheHorizontalLayout(FunctorParams *) { return FUNCTOR_CONTINUE; }
+
     /**
      * Adjust the spacing of the syl processing verse by verse
      */
@@ -817,6 +844,29 @@ public:
     virtual int PrepareCrossStaffEnd(FunctorParams *) { return FUNCTOR_CONTINUE; }
     ///@}
 
+    /**
+     * Calculate a hash of the content of a subtree, that is the classes, the attributes, the stem directions and the
+     * texts but not the xml:ids. See Measure::GetContentHash
+     */
+    ///@{
+    virtual int CalcContentHash(FunctorParams *functorParams);
+    virtual int CalcContentHashEnd(FunctorParams *functorParams);
+    ///@}
+
+    /**
+     * Add the objects to a MemoryStats, with the layout-only structures they hold.
+     * See Toolkit::GetMemoryStats
+     */
+    virtual int CalcMemoryStats(FunctorParams *functorParams);
+
+    /**
+     * Fill the content flags of each Measure with the ClassIds of the objects it contains.
+     */
+    ///@{
+    virtual int PrepareMeasureContent(FunctorParams *functorParams);
+    virtual int PrepareMeasureContentEnd(FunctorParams *) { return FUNCTOR_CONTINUE; }
+    ///@}
+
     /**
      * Builds a tree of ints (IntTree) with the staff/layer/verse numbers and for staff/layer to be then processed.
      */
@@ -1061,6 +1111,13 @@ private:
      */
     mutable bool m_isModified;
 
+    /**
+     * The cached position of the object in its parent children.
+     * It is validated against the parent children before being used and only set by the parent, through its non-const
+     * children (see Object::GetChildIndex)
+     */
+    int m_cachedIdx;
+
     /**
      * Members used for caching iterator values.
      * See Object::IterGetFirst, Object::IterGetNext and Object::IterIsNotEnd
@@ -1092,11 +1149,6 @@ private:
      * For example, a Artic child in Note for an original @artic
      */
     bool m_isAttribute;
-
-    /**
-     * A static counter for uuid generation.
-     */
-    static unsigned long s_objectCounter;
 };
 
 //----------------------------------------------------------------------------
@@ -1119,6 +1171,7 @@ public:
 
     /**
      * Look for the Object in the list and return its position (-1 if not found)
+     * The position is looked up in an index built in ResetList.
      */
     int GetListIndex(const Object *listElement);
 
@@ -1135,6 +1188,8 @@ public:
 
     /**
      * Returns the next object in the list (NULL if not found)
+     * The object is looked for from the end of the list, that is, its last position is used if it appears more than
+     * once.
      */
     Object *GetListNext(Object *listElement);
 
@@ -1149,6 +1204,14 @@ public:
 private:
     mutable ListOfObjects m_list;
     ListOfObjects::iterator m_iteratorCurrent;
+    /**
+     * The position of the objects in m_list, rebuilt in ResetList
+     */
+    std::unordered_map<const Object *, int> m_listIndex;
+    /**
+     * The last position of the objects that appear more than once in m_list
+     */
+    std::unordered_map<const Object *, int> m_listLastIndex;
 
 protected:
     /**
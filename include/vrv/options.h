@@ -109,8 +109,8 @@ public:
     /**
      * Static maps used my OptionIntMap objects. Set in OptIntMap::Init
      */
-    static std::map<int, std::string> s_breaks;
-    static std::map<int, std::string> s_measureNumber;
+    static const std::map<int, std::string> s_breaks;
+    static const std::map<int, std::string> s_measureNumber;
 
 protected:
     std::string m_title;
@@ -307,7 +307,7 @@ public:
     OptionIntMap();
     virtual ~OptionIntMap() {}
     virtual void CopyTo(Option *option);
-    void Init(int defaultValue, std::map<int, std::string> *values);
+    void Init(int defaultValue, const std::map<int, std::string> *values);
 
     virtual bool SetValue(std::string value);
     virtual std::string GetStrValue() const;
@@ -325,7 +325,7 @@ private:
 public:
     //
 private:
-    std::map<int, std::string> *m_values;
+    const std::map<int, std::string> *m_values;
     int m_value;
     int m_defaultValue;
 };
@@ -467,6 +467,7 @@ public:
     OptionBool m_evenNoteSpacing;
     OptionBool m_humType;
     OptionBool m_landscape;
+    OptionInt m_logMaxCount;
     OptionBool m_mensuralToMeasure;
     OptionBool m_mmOutput;
     OptionBool m_noFooter;
@@ -518,6 +519,7 @@ public:
     OptionArray m_appXPathQuery;
     OptionArray m_choiceXPathQuery;
     OptionString m_mdivXPathQuery;
+    OptionBool m_mdivSelectedOnly;
 
     /**
      * Element margins
@@ -561,6 +563,20 @@ public:
     OptionDbl m_rightMarginRest;
     OptionDbl m_rightMarginRightBarLine;
 
+    /**
+     * Performance - not included in the hash of the options (see Toolkit::CalcOptionsHash)
+     */
+    OptionGrp m_performance;
+
+    OptionBool m_displayList;
+    OptionBool m_layoutCache;
+    OptionString m_layoutCacheFile;
+    OptionBool m_lazyLayout;
+    OptionInt m_lazyLayoutLookAhead;
+    OptionBool m_lowMemory;
+    OptionInt m_renderCacheSize;
+    OptionString m_traceFile;
+
 private:
     /** The array of style parameters */
     MapOfStrOptions m_items;
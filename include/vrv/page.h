@@ -14,6 +14,7 @@
 namespace vrv {
 
 class DeviceContext;
+class DisplayListDeviceContext;
 class PrepareProcessingListsParams;
 class RunningElement;
 class Staff;
@@ -88,6 +89,31 @@ public:
      */
     void LayOut(bool force = false);
 
+    /**
+     * Mark the layout of the page as to be done again by the next call of Page::LayOut.
+     */
+    void ResetLayout();
+
+    /**
+     * Reset the layout of the page and delete the structures it uses (the measure and system aligners, the ledger
+     * lines and the display list). Only the values needed by Doc::CastOffPages are kept. The layout is done again by
+     * the next call of Page::LayOut. Nothing is done if the layout was already released. See Doc::ReleaseLayouts.
+     */
+    void ReleaseLayout();
+
+    /**
+     * @name Get and set the display list recorded when drawing the page.
+     * The display list is recorded only with the displayList option. It is owned by the page and is deleted when
+     * the page is laid out again or when its layout is released.
+     * GetDisplayList returns NULL if no display list was recorded with the key, which identifies the options
+     * and the device context type it was recorded for.
+     */
+    ///@{
+    DisplayListDeviceContext *GetDisplayList(uint64_t key) const;
+    void SetDisplayList(DisplayListDeviceContext *displayList, uint64_t key);
+    void ResetDisplayList();
+    ///@}
+
     /**
      * Do the layout for a transcription page (with layout information).
      * This only calculates positioning or layer element parts using provided layout of parents.
@@ -95,9 +121,12 @@ public:
     void LayOutTranscription(bool force = false);
 
     /**
-     * Lay out the content of the page (measures and their content) horizontally
+     * Lay out the content of the page (measures and their content) horizontally.
+     * With useCastOffLayout, the positions stored by Doc::CastOffDoc are restored instead of being calculated
+     * again when they match the content (see Doc::ReflowDoc).
+     * The longest duration used for the spacing is the one of the page unless longestActualDur is given.
      */
-    void LayOutHorizontally();
+    void LayOutHorizontally(bool useCastOffLayout = false, int longestActualDur = VRV_UNSET);
 
     /**
      * Justifiy the content of the page (measures and their content) horizontally
@@ -134,6 +163,12 @@ public:
      */
     int GetContentWidth() const;
 
+    /**
+     * Return the longest actual duration (DUR_*) of the content of the page, DUR_4 if none.
+     * This is used for the duration-based spacing in Page::LayOutHorizontally.
+     */
+    int GetLongestActualDur();
+
     //----------//
     // Functors //
     //----------//
@@ -160,12 +195,29 @@ public:
      */
     virtual int AlignSystems(FunctorParams *functorParams);
 
+    /**
+     * See Object::CalcMemoryStats
+     */
+    virtual int CalcMemoryStats(FunctorParams *functorParams);
+
 private:
     /**
      * Adjust the horizontal postition of the syl processing verse by verse
      */
     void AdjustSylSpacingByVerse(PrepareProcessingListsParams &listsParams, Doc *doc);
 
+    /**
+     * Restore the horizontal layout stored by Doc::CastOffDoc in all the measures of the page.
+     * Nothing is restored and false is returned if it does not match the content of one of the measures.
+     */
+    bool RestoreCastOffLayout();
+
+    /**
+     * Return the page number (one-based) for the trace events.
+     * Return 0 when no trace is recorded or when the page is detached.
+     */
+    int GetTracePageNumber() const;
+
     //
 public:
     /** Page width (MEI scoredef@page.width). Saved if != -1 */
@@ -206,6 +258,20 @@ private:
      * the force parameter is set.
      */
     bool m_layoutDone;
+
+    /**
+     * A flag indicating that the layout structures were deleted by Page::ReleaseLayout and that nothing was laid out
+     * since then.
+     */
+    bool m_layoutReleased;
+
+    /**
+     * The display list recorded for drawing the page and its key
+     */
+    ///@{
+    DisplayListDeviceContext *m_displayList;
+    uint64_t m_displayListKey;
+    ///@}
 };
 
 } // namespace vrv
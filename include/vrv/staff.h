@@ -132,6 +132,11 @@ public:
      */
     virtual int ApplyPPUFactor(FunctorParams *functorParams);
 
+    /**
+     * See Object::CalcMemoryStats
+     */
+    virtual int CalcMemoryStats(FunctorParams *functorParams);
+
     /**
      * See Object::AlignHorizontally
      */
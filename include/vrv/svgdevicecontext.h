@@ -23,6 +23,8 @@
 
 namespace vrv {
 
+class MemoryStats;
+
 //----------------------------------------------------------------------------
 // SvgDeviceContext
 //----------------------------------------------------------------------------
@@ -68,6 +70,11 @@ public:
      */
     std::string GetStringSVG(bool xml_declaration = false);
 
+    /**
+     * Set the MemoryStats in which the size of the SVG DOM is recorded when the device context is deleted
+     */
+    void SetMemoryStats(MemoryStats *memoryStats) { m_memoryStats = memoryStats; }
+
     /**
      * @name Drawing methods
      */
@@ -226,6 +233,9 @@ private:
 
     // output as mm (for pdf generation with a 72 dpi)
     bool m_mmOutput;
+
+    // the MemoryStats for the SVG DOM (NULL by default)
+    MemoryStats *m_memoryStats;
 };
 
 } // namespace vrv
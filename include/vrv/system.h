@@ -86,6 +86,13 @@ public:
      */
     int GetHeight() const;
 
+    /**
+     * Store the Y relative position and the height of the system in the content page.
+     * They are stored by Doc::CastOffDoc after the vertical layout and used by CastOffPages, including when
+     * the document is re-flowed without redoing the layout (see Doc::ReflowDoc).
+     */
+    void StoreCastOffLayout();
+
     /**
      * Return the index position of the system in its page parent
      */
@@ -132,6 +139,11 @@ public:
      */
     virtual int ApplyPPUFactor(FunctorParams *functorParams);
 
+    /**
+     * See Object::CalcMemoryStats
+     */
+    virtual int CalcMemoryStats(FunctorParams *functorParams);
+
     /**
      * See Object::AlignHorizontally
      */
@@ -239,6 +251,14 @@ protected:
 
 private:
     ScoreDef *m_drawingScoreDef;
+
+    /**
+     * @name The Y relative position and the height in the content page
+     */
+    ///@{
+    int m_castOffYRel;
+    int m_castOffHeight;
+    ///@}
 };
 
 } // namespace vrv
@@ -8,22 +8,57 @@
 #ifndef __VRV_TOOLKIT_H__
 #define __VRV_TOOLKIT_H__
 
+#include <map>
+#include <mutex>
 #include <string>
 
 //----------------------------------------------------------------------------
 
 #include "doc.h"
+#include "iosnapshot.h"
+#include "layoutcache.h"
+#include "memorystats.h"
 #include "view.h"
+#include "vrv.h"
 
 //----------------------------------------------------------------------------
 
 #ifdef USE_EMSCRIPTEN
 #include "jsonxx.h"
+#else
+#include <future>
 #endif
 
 namespace vrv {
 
-enum FileFormat { UNKNOWN = 0, AUTO, MEI, HUMDRUM, PAE, DARMS, MUSICXML, MUSICXMLHUM, MEIHUM, ESAC, MIDI, TIMEMAP };
+enum FileFormat {
+    UNKNOWN = 0,
+    AUTO,
+    MEI,
+    HUMDRUM,
+    PAE,
+    DARMS,
+    MUSICXML,
+    MUSICXMLHUM,
+    MEIHUM,
+    ESAC,
+    MIDI,
+    TIMEMAP,
+    SNAPSHOT
+};
+
+//----------------------------------------------------------------------------
+// RenderCacheEntry
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds the SVG of a page in the render cache of the Toolkit with the last time it was used.
+ */
+class RenderCacheEntry {
+public:
+    std::string m_svg;
+    int m_lastUse;
+};
 
 //----------------------------------------------------------------------------
 // Toolkit
@@ -35,7 +70,7 @@ public:
      * @name Constructors and destructors
      */
     ///@{
-    /** If initFont is set to false, Resources::InitFonts will have to be called explicitely */
+    /** If initFont is set to false, the fonts are loaded by Toolkit::SetResourcePath or when loading data */
     Toolkit(bool initFont = true);
     virtual ~Toolkit();
     ///@}
@@ -67,6 +102,21 @@ public:
      */
     bool SaveFile(const std::string &filename);
 
+    /**
+     * @name Get a binary snapshot of the loaded document or save it to a file.
+     * The snapshot can be loaded back with Toolkit::LoadData or Toolkit::LoadFile without parsing the input format
+     * and without preparing the document for drawing again. With withPages, the cast-off pages are kept and are not
+     * cast off again when the snapshot is loaded with the same options.
+     * The snapshot is a serialized copy of the document as bytes and does not share anything with it. It can be loaded
+     * into other toolkits, e.g., for rendering in other threads while the document is edited, but each of them reloads
+     * the whole document from the bytes. Only writing it is incremental: the measures modified since the previous
+     * snapshot are encoded again and the other ones are copied from the cache.
+     */
+    ///@{
+    std::string GetSnapshot(bool withPages = true);
+    bool SaveSnapshotFile(const std::string &filename, bool withPages = true);
+    ///@}
+
     /**
      * @name Getter and setter for options as JSON string
      */
@@ -91,12 +141,19 @@ public:
     bool Edit(const std::string &json_editorAction);
 
     /**
-     * Concatenates the vrv::logBuffer into a string an returns it.
-     * This is used only for Emscripten-based compilation.
-     * The vrv::logBuffer is filled by the vrv::LogXXX functions.
+     * Concatenates the messages logged by the toolkit into a string an returns it.
+     * The messages are the ones of the vrv::LogXXX functions called from the toolkit methods.
      */
     std::string GetLog();
 
+    /**
+     * Return the number and the approximate size in bytes of the objects held by the toolkit as JSON.
+     * The objects of the document are given by class, then the layout-only structures (aligners, positioners,
+     * ledger lines and beam coordinates), the XML DOMs of the last import and of the last SVG rendering, and the
+     * caches (page display lists, rendered SVG, layout cache, snapshot cache and trace events not saved yet).
+     */
+    std::string GetMemoryStats();
+
     /**
      * Returns the version number as a string.
      * This is used only for Emscripten-based compilation.
@@ -104,8 +161,7 @@ public:
     std::string GetVersion();
 
     /**
-     * Resets the vrv::logBuffer.
-     * This is used only for Emscripten-based compilation.
+     * Resets the messages logged by the toolkit. They are also reset when new data is loaded.
      */
     void ResetLogBuffer();
 
@@ -121,12 +177,40 @@ public:
      */
     std::string RenderToSVG(int pageNo = 1, bool xml_declaration = false);
 
+    /**
+     * Render the measures from startMeasureId to endMeasureId in SVG and returns it as a string.
+     * Only the measures of the range are laid out, starting with the scoreDef effective at the first one.
+     * The page height is adjusted to the content and there is no header and footer.
+     * With the lazyLayout option, the document does not have to be cast off entirely before.
+     */
+    std::string RenderMeasureRangeToSVG(
+        const std::string &startMeasureId, const std::string &endMeasureId, bool xml_declaration = false);
+
     /**
      * Render the page in SVG and save it to the file.
      * Page number is 1-based.
      */
     bool RenderToSVGFile(const std::string &filename, int pageNo = 1);
 
+#ifndef USE_EMSCRIPTEN
+    /**
+     * @name Asynchronous versions of LoadData, RedoLayout and RenderToSVG.
+     * The method is run in another thread with the token as current cancellation token. The token can be NULL and
+     * otherwise has to remain valid until the future is ready. When the operation is cancelled (explicitly or with
+     * the deadline of the token), the future returns false (or an empty string). A cancelled LoadData resets the
+     * document. A cancelled RedoLayout or RenderToSVG keeps it in a consistent state: the layout that was
+     * interrupted is done again by the next RedoLayout or when the page is rendered.
+     * The methods of a toolkit are serialized, so calling another one waits until the operation is finished or
+     * cancelled.
+     */
+    ///@{
+    std::future<bool> LoadDataAsync(const std::string &data, CancellationToken *token = NULL);
+    std::future<bool> RedoLayoutAsync(CancellationToken *token = NULL);
+    std::future<std::string> RenderToSVGAsync(
+        int pageNo = 1, bool xml_declaration = false, CancellationToken *token = NULL);
+    ///@}
+#endif
+
     /**
      * Creates a midi file, opens it, and writes to it.
      * currently generates a dummy midi file.
@@ -138,6 +222,11 @@ public:
      */
     std::string RenderToMIDI();
 
+    /**
+     * Creates a midi file and returns its binary content (not base64 encoded).
+     */
+    std::string RenderToMIDIRaw();
+
     /**
      * Creates a timemap file, and return it as a JSON string.
      */
@@ -241,6 +330,7 @@ public:
     /**
      * @name Get the pages for a loaded file
      * The SetFormat with FileFormat does not perform any validation
+     * With the lazy layout, the page count is estimated until all the pages are cast off
      */
     ///@{
     int GetPageCount();
@@ -257,18 +347,64 @@ public:
 
     /**
      * @name Set and get a std::string into a char * buffer.
-     * This is used for returning a string buffer to emscripten.
-     * The buffer is freed when reset or in MusController destructor.
+     * This is used for returning a string buffer to emscripten or through a C API.
+     * The buffer is owned by the toolkit and remains valid until the next call to SetCString.
+     * The string is moved into the buffer when possible, e.g., for SetCString(RenderToSVG()).
+     * CopyCString copies it into a buffer given by the caller, with a terminating null character, and returns the
+     * length of the string (which can be larger than the size of the buffer).
      */
     ///@{
     void SetCString(const std::string &data);
+    void SetCString(std::string &&data);
     const char *GetCString();
+    int GetCStringLength() const { return (int)m_cString.size(); }
+    int CopyCString(char *buffer, int size) const;
     ///@}
 
 private:
     bool IsUTF16(const std::string &filename);
     bool LoadUTF16File(const std::string &filename);
 
+    /**
+     * Render the page (0-based) to the deviceContext, with the page size set according to the options.
+     * Called from Toolkit::RenderToDeviceContext and Toolkit::RenderMeasureRangeToSVG
+     */
+    void RenderPage(int pageIdx, DeviceContext *deviceContext, bool adjustPageHeight);
+
+    /**
+     * Reset the document after a CancellationException in LoadData since it can be partially loaded
+     */
+    void ResetCancelledDoc();
+
+    /**
+     * Return the trace recorder with the file of the traceFile option, or NULL without one
+     */
+    TraceRecorder *GetTraceRecorder();
+
+    /**
+     * Release the layout of all the pages but the one (0-based) about to be rendered (-1 for all) with the
+     * lowMemory option. This also deletes their display lists. Nothing is done when the document is still being
+     * cast off lazily.
+     */
+    void ReleaseLayouts(int pageIdx);
+
+    /**
+     * Calculate a hash of the values of all the options but the performance ones.
+     * Used for the keys of the display lists of the pages and of the render cache.
+     */
+    uint64_t CalcOptionsHash() const;
+
+    /**
+     * @name Methods for the render cache
+     * ValidateRenderCache clears it if the options, the scale or the document changed since it was filled.
+     * AddToRenderCache removes the entries used least recently until the SVG fits in the memory budget.
+     */
+    ///@{
+    void ValidateRenderCache();
+    void AddToRenderCache(int key, const std::string &svg);
+    void ResetRenderCache();
+    ///@}
+
 protected:
 #ifdef USE_EMSCRIPTEN
     /**
@@ -291,14 +427,69 @@ private:
     FileFormat m_outformat;
     bool m_scoreBasedMei;
 
-    static char *m_humdrumBuffer;
+    char *m_humdrumBuffer;
 
     Options *m_options;
 
+    /**
+     * The cache of the horizontal layout of the measures.
+     * It is kept when new data is loaded and saved to m_layoutCacheFile (if any) when the toolkit is deleted.
+     */
+    LayoutCache m_layoutCache;
+    std::string m_layoutCacheFile;
+
+    /**
+     * @name The cache of the SVG of the pages rendered, with the page and the xml declaration flag as key.
+     * It is valid for the hash of the options and scale and for the modification count of the document it was
+     * filled with. It is used only with a renderCacheSize option.
+     */
+    ///@{
+    std::map<int, RenderCacheEntry> m_renderCache;
+    int m_renderCacheSize;
+    int m_renderCacheUse;
+    uint64_t m_renderCacheOptionsHash;
+    int m_renderCacheModificationCount;
+    ///@}
+
+    /**
+     * The cache of the measures encoded in the snapshots.
+     * The measures modified by the editor methods are invalidated and it is cleared when new data is loaded or when
+     * the document re-creates its measures.
+     */
+    SnapshotCache m_snapshotCache;
+
+    /**
+     * The log sink set as current in the toolkit methods.
+     */
+    LogSink m_logSink;
+
+    /**
+     * The resources (path and fonts) set as current in the toolkit methods.
+     * They are initialized from the current resources of the thread when the toolkit is created.
+     */
+    Resources m_resources;
+
+    /**
+     * The mutex locked by the toolkit methods so that only one of them runs at a time.
+     * It is recursive because the methods call each other.
+     */
+    std::recursive_mutex m_mutex;
+
+    /**
+     * The trace recorder set as current in the toolkit methods when a traceFile option is given.
+     */
+    TraceRecorder m_traceRecorder;
+
+    /**
+     * The size of the XML DOMs of the last import and of the last SVG rendering.
+     * See Toolkit::GetMemoryStats
+     */
+    MemoryStats m_xmlMemoryStats;
+
     /**
      * The C buffer string.
      */
-    char *m_cString;
+    std::string m_cString;
 };
 
 } // namespace vrv
@@ -31,6 +31,7 @@ public:
     // constructors and destructors
     SystemAligner();
     virtual ~SystemAligner();
+    virtual std::string GetClassName() const { return "SystemAligner"; }
     virtual ClassId GetClassId() const { return SYSTEM_ALIGNER; }
 
     /**
@@ -70,6 +71,60 @@ private:
     StaffAlignment *m_bottomAlignment;
 };
 
+//----------------------------------------------------------------------------
+// OverflowBBoxes
+//----------------------------------------------------------------------------
+
+/**
+ * This class stores the overflowing bounding boxes of a StaffAlignment.
+ * The boxes are kept in insertion order together with an index sorted by their left content position.
+ * This makes it possible to look for the boxes horizontally overlapping a given one without going through all of them.
+ * The horizontal position of the boxes is expected not to change once they have been added.
+ */
+class OverflowBBoxes {
+public:
+    OverflowBBoxes() { Clear(); }
+
+    /**
+     * Add a bounding box (at the end of the insertion order)
+     */
+    void Add(BoundingBox *box);
+
+    /**
+     * Remove all the bounding boxes
+     */
+    void Clear();
+
+    /**
+     * Return all the bounding boxes in insertion order
+     */
+    const ArrayOfBoundingBoxes *GetBBoxes() const { return &m_bboxes; }
+
+    /**
+     * Fill the array with the bounding boxes having a horizontal content overlap with box.
+     * The boxes are returned in insertion order.
+     */
+    void FindHorizontalContentOverlaps(const BoundingBox *box, ArrayOfBoundingBoxes *overlaps) const;
+
+private:
+    //
+public:
+    //
+private:
+    /**
+     * The bounding boxes in insertion order
+     */
+    ArrayOfBoundingBoxes m_bboxes;
+    /**
+     * The content left position and the insertion index of the boxes with a content bounding box, sorted by position
+     */
+    std::vector<std::pair<int, int> > m_leftIndex;
+    /**
+     * The maximum content width of the indexed boxes, which bounds the search window
+     */
+    int m_maxWidth;
+};
+
 //----------------------------------------------------------------------------
 // StaffAlignment
 //----------------------------------------------------------------------------
@@ -86,6 +141,7 @@ public:
     ///@{
     StaffAlignment();
     virtual ~StaffAlignment();
+    virtual std::string GetClassName() const { return "StaffAlignment"; }
     virtual ClassId GetClassId() const { return STAFF_ALIGNMENT; }
     ///@}
 
@@ -115,6 +171,11 @@ public:
      */
     FloatingPositioner *GetCorrespFloatingPositioner(FloatingObject *object);
 
+    /**
+     * Return the FloatingPositioner objects of the staff
+     */
+    const ArrayOfFloatingPositioners *GetFloatingPositioners() const { return &m_floatingPositioners; }
+
     /**
      * @name Setter and getter of the staff from which the alignment is created alignment.
      * Used for accessing the staff @n, the size, etc.
@@ -156,8 +217,8 @@ public:
      * @name Adds a bounding box to the array of overflowing objects above or below
      */
     ///@{
-    void AddBBoxAbove(BoundingBox *box) { m_overflowAboveBBoxes.push_back(box); }
-    void AddBBoxBelow(BoundingBox *box) { m_overflowBelowBBoxes.push_back(box); }
+    void AddBBoxAbove(BoundingBox *box) { m_overflowAboveBBoxes.Add(box); }
+    void AddBBoxBelow(BoundingBox *box) { m_overflowBelowBBoxes.Add(box); }
     ///@}
 
     /**
@@ -231,8 +292,8 @@ private:
     /**
      * The list of overflowing bounding boxes (e.g, LayerElement or FloatingPositioner)
      */
-    std::vector<BoundingBox *> m_overflowAboveBBoxes;
-    std::vector<BoundingBox *> m_overflowBelowBBoxes;
+    OverflowBBoxes m_overflowAboveBBoxes;
+    OverflowBBoxes m_overflowBelowBBoxes;
 };
 
 } // namespace vrv
@@ -537,13 +537,6 @@ protected:
      * modified appropriately when going through the page.
      */
     ScoreDef m_drawingScoreDef;
-
-private:
-    /** @name Internal values for storing temporary values for ligatures */
-    ///@{
-    static int s_drawingLigX[2], s_drawingLigY[2];
-    static bool s_drawingLigObliqua;
-    ///@}
 };
 
 } // namespace vrv
@@ -8,11 +8,18 @@
 #ifndef __VRV_H__
 #define __VRV_H__
 
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <exception>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #ifndef _WIN32
@@ -35,17 +42,344 @@ void LogDebug(const char *fmt, ...);
 void LogError(const char *fmt, ...);
 void LogMessage(const char *fmt, ...);
 void LogWarning(const char *fmt, ...);
-void DisableLog();
 
 /**
- * Member and functions specific to emscripten loging that uses a vector of string to buffer the logs.
+ * Disable the log for the current thread
  */
-#ifdef EMSCRIPTEN
+void DisableLog();
+
 enum consoleLogLevel { CONSOLE_LOG = 0, CONSOLE_INFO, CONSOLE_WARN, CONSOLE_ERROR };
-extern std::vector<std::string> logBuffer;
-bool LogBufferContains(std::string s);
-void AppendLogBuffer(bool checkDuplicate, std::string message, consoleLogLevel level);
-#endif
+
+//----------------------------------------------------------------------------
+// LogSink
+//----------------------------------------------------------------------------
+
+/**
+ * This class buffers the messages of the vrv::LogXXX functions called while it is the current sink of the thread.
+ * Each Toolkit owns one and sets it as current in its methods (see LogSinkScope), which keeps the logs of several
+ * Toolkit instances separate. Messages already in the buffer are ignored and the number of messages is limited
+ * by the max count (0 for no limit), except for errors that are always kept. The messages over the limit are only
+ * counted and reported with a single line at the end of the log, which is printed when the sink is reset or deleted.
+ * The messages are also printed to stderr (or to the console with emscripten). Without a max count, duplicates are
+ * still printed to stderr, as they are without a current sink.
+ */
+class LogSink {
+public:
+    LogSink();
+    virtual ~LogSink();
+
+    /**
+     * Add the message unless it is already in the buffer or the max count is reached for a message that is not an
+     * error
+     */
+    void Append(consoleLogLevel level, const std::string &message);
+
+    /**
+     * Return the messages in the buffer concatenated, followed by the number of suppressed messages if any
+     */
+    std::string GetLog() const;
+
+    /**
+     * Clear the buffer and the suppressed messages
+     */
+    void Reset();
+
+    /**
+     * Set the maximum number of messages in the buffer
+     */
+    void SetMaxCount(int maxCount);
+
+    /**
+     * @name Get and set the current sink of the thread.
+     * SetCurrent returns the previous one.
+     */
+    ///@{
+    static LogSink *GetCurrent();
+    static LogSink *SetCurrent(LogSink *sink);
+    ///@}
+
+private:
+    /**
+     * Return the line reporting the suppressed messages (empty if there is none)
+     */
+    std::string GetSuppressedLine() const;
+
+public:
+    //
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::string> m_buffer;
+    /** The messages in the buffer for detecting duplicates */
+    std::unordered_set<std::string> m_messages;
+    int m_maxCount;
+    /** The number of messages that were not added because of the max count */
+    int m_suppressedCount;
+};
+
+//----------------------------------------------------------------------------
+// LogSinkScope
+//----------------------------------------------------------------------------
+
+/**
+ * This class sets a sink as the current one of the thread for its lifetime and restores the previous one.
+ */
+class LogSinkScope {
+public:
+    LogSinkScope(LogSink *sink) { m_previous = LogSink::SetCurrent(sink); }
+    ~LogSinkScope() { LogSink::SetCurrent(m_previous); }
+
+private:
+    LogSink *m_previous;
+};
+
+/**
+ * The number of objects processed between two checks of the deadline of a CancellationToken
+ */
+#define CANCELLATION_CHECK_INTERVAL 256
+
+//----------------------------------------------------------------------------
+// CancellationToken
+//----------------------------------------------------------------------------
+
+/**
+ * This class allows an operation running in another thread to be cancelled, either explicitly or when a deadline
+ * is passed. The token is checked by Object::Process for the current token of the thread (see CancellationScope).
+ * A CancellationException is then thrown since the code calling Object::Process expects the tree processing to be
+ * complete. The operations that modify the structure of the document (e.g., the cast off) are not cancelled while
+ * objects are detached from the tree (see CancellationDeferralScope), so the document remains consistent and only
+ * its layout has to be done again after a cancellation.
+ */
+class CancellationToken {
+public:
+    CancellationToken();
+    virtual ~CancellationToken();
+
+    /**
+     * Cancel the operation (from any thread)
+     */
+    void Cancel() { m_isCancelled = true; }
+
+    /**
+     * Set the deadline to the given number of milliseconds from now
+     */
+    void SetTimeout(int milliseconds);
+
+    /**
+     * Return true if the operation was cancelled or if the deadline is passed
+     */
+    bool IsCancelled();
+
+    /**
+     * @name Get and set the current token of the thread.
+     * SetCurrent returns the previous one.
+     */
+    ///@{
+    static CancellationToken *GetCurrent();
+    static CancellationToken *SetCurrent(CancellationToken *token);
+    ///@}
+
+    /**
+     * Return true if the current token of the thread is cancelled and the cancellation is not deferred.
+     * The deadline is checked only every CANCELLATION_CHECK_INTERVAL calls.
+     * Called from Object::Process for each object.
+     */
+    static bool IsCurrentCancelled();
+
+    /**
+     * @name Defer and resume the cancellation for the current thread (see CancellationDeferralScope)
+     */
+    ///@{
+    static void DeferCancellation();
+    static void ResumeCancellation();
+    ///@}
+
+private:
+    std::atomic<bool> m_isCancelled;
+    std::atomic<bool> m_hasDeadline;
+    /** The deadline as a count of std::chrono::steady_clock ticks, since it can be set from another thread */
+    std::atomic<int64_t> m_deadline;
+};
+
+//----------------------------------------------------------------------------
+// CancellationException
+//----------------------------------------------------------------------------
+
+/**
+ * The exception thrown by Object::Process when the current CancellationToken is cancelled.
+ */
+class CancellationException : public std::exception {
+public:
+    virtual const char *what() const noexcept { return "Operation cancelled"; }
+};
+
+//----------------------------------------------------------------------------
+// CancellationScope
+//----------------------------------------------------------------------------
+
+/**
+ * This class sets a token as the current one of the thread for its lifetime and restores the previous one.
+ */
+class CancellationScope {
+public:
+    CancellationScope(CancellationToken *token) { m_previous = CancellationToken::SetCurrent(token); }
+    ~CancellationScope() { CancellationToken::SetCurrent(m_previous); }
+
+private:
+    CancellationToken *m_previous;
+};
+
+//----------------------------------------------------------------------------
+// CancellationDeferralScope
+//----------------------------------------------------------------------------
+
+/**
+ * This class defers the cancellation of the current thread for its lifetime, e.g., while objects are detached from
+ * the document. The cancellation then happens in the next tree processing after the scope. The scopes can be nested.
+ */
+class CancellationDeferralScope {
+public:
+    CancellationDeferralScope() { CancellationToken::DeferCancellation(); }
+    ~CancellationDeferralScope() { CancellationToken::ResumeCancellation(); }
+};
+
+//----------------------------------------------------------------------------
+// TraceRecorder
+//----------------------------------------------------------------------------
+
+/**
+ * This class records the spans (see TraceSpan) and the counters (see TraceCounter) of the current thread while it
+ * is its current recorder. Each Toolkit owns one and sets it as current when the traceFile option is given (see
+ * TraceRecorderScope). The events are saved in the Chrome trace event format that can be opened in Perfetto or in
+ * chrome://tracing. The names of the events are expected to be identifiers and are not escaped.
+ */
+class TraceRecorder {
+public:
+    TraceRecorder();
+    virtual ~TraceRecorder();
+
+    /**
+     * @name Set and get the file the events are saved to.
+     * Changing the file clears the events recorded so far and the new file is rewritten by the next Save.
+     */
+    ///@{
+    void SetFilename(const std::string &filename);
+    std::string GetFilename() const { return m_filename; }
+    ///@}
+
+    /**
+     * Return true if a file is given
+     */
+    bool IsEnabled() const { return !m_filename.empty(); }
+
+    /**
+     * Add a complete event for a span started at the given time.
+     * The argument is added only if a name is given.
+     */
+    void AddSpan(const char *name, std::chrono::steady_clock::time_point start, const char *argName, int argValue);
+
+    /**
+     * Add a counter event with the value at the current time
+     */
+    void AddCounter(const char *name, int value);
+
+    /**
+     * Append the events recorded since the previous call to the file and clear them.
+     * The file uses the JSON array format of the trace events, which can be opened without the closing bracket, so
+     * the events already saved never have to be written again.
+     */
+    bool Save();
+
+    /**
+     * Clear the events - the file is rewritten by the next Save
+     */
+    void Reset();
+
+    /**
+     * @name Return the number of events not saved yet and their approximate memory size in bytes
+     */
+    ///@{
+    int GetEventCount() const;
+    size_t GetMemorySize() const;
+    ///@}
+
+    /**
+     * @name Get and set the current recorder of the thread.
+     * SetCurrent returns the previous one.
+     */
+    ///@{
+    static TraceRecorder *GetCurrent();
+    static TraceRecorder *SetCurrent(TraceRecorder *recorder);
+    ///@}
+
+private:
+    /** Return the time in microseconds since the recorder was created */
+    long GetTimestamp(std::chrono::steady_clock::time_point time) const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::string m_filename;
+    std::chrono::steady_clock::time_point m_origin;
+    /** The events not saved yet, already formatted as JSON objects */
+    std::vector<std::string> m_events;
+    /** True when the file was created and the next events are appended to it */
+    bool m_isFileStarted;
+};
+
+//----------------------------------------------------------------------------
+// TraceRecorderScope
+//----------------------------------------------------------------------------
+
+/**
+ * This class sets a recorder as the current one of the thread for its lifetime and restores the previous one.
+ * A NULL recorder disables the tracing within the scope. The outermost scope of a recorder saves its events when
+ * ending, which keeps the file up to date after each traced Toolkit call without keeping the events in memory.
+ */
+class TraceRecorderScope {
+public:
+    TraceRecorderScope(TraceRecorder *recorder);
+    ~TraceRecorderScope();
+
+private:
+    TraceRecorder *m_recorder;
+    TraceRecorder *m_previous;
+};
+
+//----------------------------------------------------------------------------
+// TraceSpan
+//----------------------------------------------------------------------------
+
+/**
+ * This class records a span with the current recorder of the thread for its lifetime.
+ * Nothing is done without a current recorder. Restart ends the span and starts a new one, which is handy for
+ * successive stages of a method. The optional argument is added to the event (e.g., the page number).
+ */
+class TraceSpan {
+public:
+    TraceSpan(const char *name, const char *argName = NULL, int argValue = 0);
+    ~TraceSpan() { this->End(); }
+
+    /**
+     * End the span (if not ended already)
+     */
+    void End();
+
+    /**
+     * End the span and start a new one with the name
+     */
+    void Restart(const char *name);
+
+private:
+    TraceRecorder *m_recorder;
+    const char *m_name;
+    const char *m_argName;
+    int m_argValue;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * Add a counter event with the current recorder of the thread (if any)
+ */
+void TraceCounter(const char *name, int value);
 
 /**
  * Utility for comparing doubles
@@ -87,14 +421,15 @@ std::string GetFileVersion(int vmaj, int vmin, int vrev);
 std::string GetFilename(std::string fullpath);
 
 /**
- * Return the version number (X.X.X)
+ * Return true if the filename has the extension of a file format that can be loaded.
+ * This is used for selecting the input files of a directory.
  */
-std::string GetVersion();
+bool HasInputFileExtension(const std::string &filename);
 
 /**
- *
+ * Return the version number (X.X.X)
  */
-extern bool noLog;
+std::string GetVersion();
 
 /**
  * Functions for logging in milliseconds the elapsed time of an
@@ -107,7 +442,6 @@ extern bool noLog;
  * ... Do something
  * LogElapsedTimeEnd("name of the operation");
  */
-extern struct timeval start;
 void LogElapsedTimeStart();
 void LogElapsedTimeEnd(const char *msg = "unspecified operation");
 
@@ -122,23 +456,35 @@ bool Check(Object *object);
 //----------------------------------------------------------------------------
 
 /**
- * This class provides static resource values.
- * The default values can be changed by setters.
+ * A table of glyphs by code. The tables are loaded once by Resources and are not modified afterwards.
  */
+typedef std::map<wchar_t, Glyph> GlyphTable;
 
+/**
+ * This class provides the resource values, i.e., the path to the resources and the fonts loaded from it.
+ * The static methods use the current resources of the thread (see ResourcesScope), or the default ones without
+ * current resources. Each Toolkit owns resources that it sets as current in its methods and that are initialized from
+ * the current ones when it is created. The default ones are meant to be set up before creating toolkits.
+ * The glyph tables are loaded under a lock, shared by all the resources loading the same font from the same path and
+ * never modified once loaded, so the toolkits can load fonts and render concurrently.
+ */
 class Resources {
 public:
+    /** @name Constructors and destructor */
+    ///@{
+    Resources();
+    virtual ~Resources() {}
+    ///@}
+
     /**
-     * @name Setters and getters for static environment variables
+     * @name Setters and getters for the current resources
      */
     ///@{
     /** Resource path */
-    static std::string GetPath() { return m_path; }
-    static void SetPath(std::string path) { m_path = path; }
+    static std::string GetPath() { return GetCurrent()->m_path; }
+    static void SetPath(std::string path) { GetCurrent()->m_path = path; }
     /** Init the SMufL music and text fonts */
     static bool InitFonts();
-    /** Init the text font (bounding boxes and ASCII only) */
-    static bool InitTextFont();
     /** Select a particular font */
     static bool SetFont(std::string fontName);
     /** Returns the glyph (if exists) for the current SMuFL font */
@@ -147,16 +493,62 @@ public:
     static Glyph *GetTextGlyph(wchar_t code);
     ///@}
 
+    /**
+     * @name Get and set the current resources of the thread.
+     * GetCurrent returns the default resources if none is set. SetCurrent returns the previous ones.
+     */
+    ///@{
+    static Resources *GetCurrent();
+    static Resources *SetCurrent(Resources *resources);
+    ///@}
+
 private:
-    static bool LoadFont(std::string fontName);
+    /**
+     * Return the table of the font loaded from the path, loading it if necessary - NULL if it cannot be loaded.
+     * The fonts other than the default one (Leipzig) are loaded over the default one. Needs the font lock.
+     */
+    static std::shared_ptr<GlyphTable> GetGlyphTable(const std::string &path, const std::string &fontName);
+
+    /**
+     * Load the glyphs of the font into the table
+     */
+    static bool LoadFont(GlyphTable &table, const std::string &path, const std::string &fontName);
+
+    /**
+     * Load the text font (bounding boxes and ASCII only) into the table
+     */
+    static bool LoadTextFont(GlyphTable &table, const std::string &path);
 
+public:
+    //
 private:
     /** The path to the resources directory (e.g., for the svg/ subdirectory with fonts as XML */
-    static std::string m_path;
+    std::string m_path;
     /** The loaded SMuFL font */
-    static std::map<wchar_t, Glyph> m_font;
+    std::shared_ptr<GlyphTable> m_font;
     /** A text font used for bounding box calculations */
-    static std::map<wchar_t, Glyph> m_textFont;
+    std::shared_ptr<GlyphTable> m_textFont;
+
+    /** The lock for loading the fonts */
+    static std::mutex s_fontMutex;
+    /** The glyph tables loaded by path and font name (the text font with an empty name) */
+    static std::map<std::pair<std::string, std::string>, std::shared_ptr<GlyphTable> > s_glyphTables;
+};
+
+//----------------------------------------------------------------------------
+// ResourcesScope
+//----------------------------------------------------------------------------
+
+/**
+ * This class sets resources as the current ones of the thread for its lifetime and restores the previous ones.
+ */
+class ResourcesScope {
+public:
+    ResourcesScope(Resources *resources) { m_previous = Resources::SetCurrent(resources); }
+    ~ResourcesScope() { Resources::SetCurrent(m_previous); }
+
+private:
+    Resources *m_previous;
 };
 
 //----------------------------------------------------------------------------
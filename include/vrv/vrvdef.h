@@ -9,6 +9,7 @@
 #define __VRV_DEF_H__
 
 #include <algorithm>
+#include <cstdint>
 #include <list>
 #include <map>
 #include <vector>
@@ -189,6 +190,7 @@ enum ClassId {
     //
     BBOX_DEVICE_CONTEXT,
     SVG_DEVICE_CONTEXT,
+    DISPLAY_LIST_DEVICE_CONTEXT,
     CUSTOM_DEVICE_CONTEXT,
     //
     UNSPECIFIED
@@ -24,10 +24,10 @@
 
 namespace vrv {
 
-std::vector<data_ARTICULATION> Artic::s_outStaffArtic = { ARTICULATION_acc, ARTICULATION_dnbow, ARTICULATION_marc,
+const std::vector<data_ARTICULATION> Artic::s_outStaffArtic = { ARTICULATION_acc, ARTICULATION_dnbow, ARTICULATION_marc,
     ARTICULATION_marc_stacc, ARTICULATION_upbow, ARTICULATION_harm };
 
-std::vector<data_ARTICULATION> Artic::s_aboveStaffArtic
+const std::vector<data_ARTICULATION> Artic::s_aboveStaffArtic
     = { ARTICULATION_dnbow, ARTICULATION_marc, ARTICULATION_upbow, ARTICULATION_harm };
 
 //----------------------------------------------------------------------------
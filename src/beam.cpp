@@ -19,6 +19,7 @@
 #include "elementpart.h"
 #include "functorparams.h"
 #include "layer.h"
+#include "memorystats.h"
 #include "note.h"
 #include "rest.h"
 #include "smufl.h"
@@ -653,4 +654,16 @@ int Beam::ResetDrawing(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Beam::CalcMemoryStats(FunctorParams *functorParams)
+{
+    CalcMemoryStatsParams *params = dynamic_cast<CalcMemoryStatsParams *>(functorParams);
+    assert(params);
+
+    const ArrayOfBeamElementCoords *coords = this->GetElementCoords();
+    params->m_memoryStats->Add(MEMORY_STATS_LAYOUT, "BeamElementCoord", (int)coords->size(),
+        coords->size() * (sizeof(BeamElementCoord) + sizeof(BeamElementCoord *)));
+
+    return Object::CalcMemoryStats(functorParams);
+}
+
 } // namespace vrv
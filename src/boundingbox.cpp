@@ -24,7 +24,6 @@
 
 namespace vrv {
 
-int BoundingBox::s_deCasteljau[4][4];
 
 //----------------------------------------------------------------------------
 // BoundingBox
@@ -725,15 +724,16 @@ int BoundingBox::CalcBezierAtPosition(const Point bezier[4], int x)
     if (bezier[3].x != bezier[0].x) t = (double)(x - bezier[0].x) / (double)(bezier[3].x - bezier[0].x);
     t = std::min(1.0, std::max(0.0, t));
     int n = 4;
+    // Buffer for De-Casteljau algorithm
+    int deCasteljau[4][4];
 
-    for (i = 0; i < n; ++i) BoundingBox::s_deCasteljau[0][i] = bezier[i].y;
+    for (i = 0; i < n; ++i) deCasteljau[0][i] = bezier[i].y;
     for (j = 1; j < n; ++j) {
         for (int i = 0; i < 4 - j; ++i) {
-            BoundingBox::s_deCasteljau[j][i]
-                = BoundingBox::s_deCasteljau[j - 1][i] * (1 - t) + BoundingBox::s_deCasteljau[j - 1][i + 1] * t;
+            deCasteljau[j][i] = deCasteljau[j - 1][i] * (1 - t) + deCasteljau[j - 1][i + 1] * t;
         }
     }
-    return BoundingBox::s_deCasteljau[n - 1][0];
+    return deCasteljau[n - 1][0];
 }
 
 void BoundingBox::CalcThickBezier(
@@ -0,0 +1,514 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        displaylistdevicecontext.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "displaylistdevicecontext.h"
+
+//----------------------------------------------------------------------------
+
+#include <assert.h>
+
+//----------------------------------------------------------------------------
+
+#include "memorystats.h"
+#include "vrv.h"
+
+namespace vrv {
+
+//----------------------------------------------------------------------------
+// DisplayListDeviceContext
+//----------------------------------------------------------------------------
+
+DisplayListDeviceContext::DisplayListDeviceContext(bool useGlobalStyling) : DeviceContext()
+{
+    m_useGlobalStyling = useGlobalStyling;
+
+    m_originX = 0;
+    m_originY = 0;
+
+    // Same as SvgDeviceContext and BBoxDeviceContext
+    SetBrush(AxBLACK, AxSOLID);
+    SetPen(AxBLACK, 1, AxSOLID);
+}
+
+DisplayListDeviceContext::~DisplayListDeviceContext() {}
+
+DisplayListCommand &DisplayListDeviceContext::AddCommand(DisplayListCommandType type)
+{
+    DisplayListCommand command;
+    command.m_type = type;
+    command.m_pointer = NULL;
+    command.m_view = NULL;
+    command.m_pointIdx = -1;
+    command.m_stringIdx = -1;
+    command.m_wstringIdx = -1;
+    command.m_isDeactivatedX = m_isDeactivatedX;
+    command.m_isDeactivatedY = m_isDeactivatedY;
+
+    // Store the pen, brush and font only when they change
+    command.m_pen = -1;
+    if (!m_penStack.empty()) {
+        const Pen &pen = m_penStack.top();
+        if (m_pens.empty() || (m_pens.back().GetColour() != pen.GetColour())
+            || (m_pens.back().GetWidth() != pen.GetWidth()) || (m_pens.back().GetOpacity() != pen.GetOpacity())
+            || (m_pens.back().GetDashLength() != pen.GetDashLength())) {
+            m_pens.push_back(pen);
+        }
+        command.m_pen = (int)m_pens.size() - 1;
+    }
+    command.m_brush = -1;
+    if (!m_brushStack.empty()) {
+        const Brush &brush = m_brushStack.top();
+        if (m_brushes.empty() || (m_brushes.back().GetColour() != brush.GetColour())
+            || (m_brushes.back().GetOpacity() != brush.GetOpacity())) {
+            m_brushes.push_back(brush);
+        }
+        command.m_brush = (int)m_brushes.size() - 1;
+    }
+    command.m_font = -1;
+    if (!m_fontStack.empty() && m_fontStack.top()) {
+        FontInfo *font = m_fontStack.top();
+        if (m_fonts.empty() || (m_fonts.back().GetPointSize() != font->GetPointSize())
+            || (m_fonts.back().GetStyle() != font->GetStyle()) || (m_fonts.back().GetWeight() != font->GetWeight())
+            || (m_fonts.back().GetUnderlined() != font->GetUnderlined())
+            || (m_fonts.back().GetFaceName() != font->GetFaceName())
+            || (m_fonts.back().GetFamily() != font->GetFamily())
+            || (m_fonts.back().GetEncoding() != font->GetEncoding())) {
+            m_fonts.push_back(*font);
+        }
+        command.m_font = (int)m_fonts.size() - 1;
+    }
+
+    m_commands.push_back(command);
+    return m_commands.back();
+}
+
+int DisplayListDeviceContext::AddPoints(int n, Point points[])
+{
+    int idx = (int)m_points.size();
+    m_points.insert(m_points.end(), points, points + n);
+    return idx;
+}
+
+int DisplayListDeviceContext::AddString(const std::string &string)
+{
+    m_strings.push_back(string);
+    return (int)m_strings.size() - 1;
+}
+
+size_t DisplayListDeviceContext::GetMemorySize() const
+{
+    size_t bytes = sizeof(DisplayListDeviceContext);
+    bytes += m_commands.capacity() * sizeof(DisplayListCommand);
+    bytes += m_points.capacity() * sizeof(Point);
+    bytes += m_strings.capacity() * sizeof(std::string);
+    for (auto &string : m_strings) bytes += string.capacity();
+    bytes += m_wstrings.capacity() * sizeof(std::wstring);
+    for (auto &wstring : m_wstrings) bytes += wstring.capacity() * sizeof(wchar_t);
+    bytes += m_pens.capacity() * sizeof(Pen);
+    bytes += m_brushes.capacity() * sizeof(Brush);
+    bytes += m_fonts.capacity() * sizeof(FontInfo);
+    return bytes;
+}
+
+void DisplayListDeviceContext::Replay(DeviceContext *dc) const
+{
+    assert(dc);
+
+    bool isDeactivatedX = false;
+    bool isDeactivatedY = false;
+
+    // The FontInfo pushed onto the stack of the device context can be modified by it
+    std::vector<FontInfo> fonts = m_fonts;
+    std::vector<Point> points;
+
+    for (auto &command : m_commands) {
+        // Restore the deactivation of the graphic
+        if ((command.m_isDeactivatedX != isDeactivatedX) || (command.m_isDeactivatedY != isDeactivatedY)) {
+            if (isDeactivatedX || isDeactivatedY) dc->ReactivateGraphic();
+            if (command.m_isDeactivatedX && command.m_isDeactivatedY)
+                dc->DeactivateGraphic();
+            else if (command.m_isDeactivatedX)
+                dc->DeactivateGraphicX();
+            else if (command.m_isDeactivatedY)
+                dc->DeactivateGraphicY();
+            isDeactivatedX = command.m_isDeactivatedX;
+            isDeactivatedY = command.m_isDeactivatedY;
+        }
+
+        // Push the pen, brush and font of the command onto the stacks
+        if (command.m_pen != -1) {
+            const Pen &pen = m_pens.at(command.m_pen);
+            dc->SetPen(pen.GetColour(), pen.GetWidth(), (pen.GetOpacity() == 0.0) ? AxTRANSPARENT : AxSOLID,
+                pen.GetDashLength());
+        }
+        if (command.m_brush != -1) {
+            const Brush &brush = m_brushes.at(command.m_brush);
+            dc->SetBrush(brush.GetColour(), (brush.GetOpacity() == 0.0) ? AxTRANSPARENT : AxSOLID);
+        }
+        if (command.m_font != -1) {
+            dc->SetFont(&fonts.at(command.m_font));
+        }
+
+        const int *values = command.m_values;
+        const std::string *strings = (command.m_stringIdx != -1) ? &m_strings.at(command.m_stringIdx) : NULL;
+        if (command.m_pointIdx != -1) {
+            // The drawing methods take non-const arrays
+            int pointCount = (command.m_type == DL_DRAW_COMPLEX_BEZIER_PATH) ? 8 : values[0];
+            points.assign(m_points.begin() + command.m_pointIdx, m_points.begin() + command.m_pointIdx + pointCount);
+        }
+        Object *object = static_cast<Object *>(command.m_pointer);
+
+        switch (command.m_type) {
+            case DL_SET_BACKGROUND: dc->SetBackground(values[0], values[1]); break;
+            case DL_SET_BACKGROUND_IMAGE: dc->SetBackgroundImage(command.m_pointer, command.m_doubleValues[0]); break;
+            case DL_SET_BACKGROUND_MODE: dc->SetBackgroundMode(values[0]); break;
+            case DL_SET_TEXT_FOREGROUND: dc->SetTextForeground(values[0]); break;
+            case DL_SET_TEXT_BACKGROUND: dc->SetTextBackground(values[0]); break;
+            case DL_SET_LOGICAL_ORIGIN: dc->SetLogicalOrigin(values[0], values[1]); break;
+            case DL_DRAW_COMPLEX_BEZIER_PATH: dc->DrawComplexBezierPath(&points[0], &points[4]); break;
+            case DL_DRAW_CIRCLE: dc->DrawCircle(values[0], values[1], values[2]); break;
+            case DL_DRAW_ELLIPSE: dc->DrawEllipse(values[0], values[1], values[2], values[3]); break;
+            case DL_DRAW_ELLIPTIC_ARC:
+                dc->DrawEllipticArc(values[0], values[1], values[2], values[3], command.m_doubleValues[0],
+                    command.m_doubleValues[1]);
+                break;
+            case DL_DRAW_LINE: dc->DrawLine(values[0], values[1], values[2], values[3]); break;
+            case DL_DRAW_POLYGON: dc->DrawPolygon(values[0], &points[0], values[1], values[2], values[3]); break;
+            case DL_DRAW_RECTANGLE: dc->DrawRectangle(values[0], values[1], values[2], values[3]); break;
+            case DL_DRAW_ROTATED_TEXT:
+                dc->DrawRotatedText(strings[0], values[0], values[1], command.m_doubleValues[0]);
+                break;
+            case DL_DRAW_ROUNDED_RECTANGLE:
+                dc->DrawRoundedRectangle(values[0], values[1], values[2], values[3], command.m_doubleValues[0]);
+                break;
+            case DL_DRAW_TEXT:
+                dc->DrawText(strings[0], m_wstrings.at(command.m_wstringIdx), values[0], values[1]);
+                break;
+            case DL_DRAW_MUSIC_TEXT:
+                dc->DrawMusicText(m_wstrings.at(command.m_wstringIdx), values[0], values[1], (values[2] != 0));
+                break;
+            case DL_DRAW_SPLINE: dc->DrawSpline(values[0], &points[0]); break;
+            case DL_DRAW_SVG_SHAPE:
+                dc->DrawSvgShape(values[0], values[1], values[2], values[3], command.m_svg);
+                break;
+            case DL_DRAW_BACKGROUND_IMAGE: dc->DrawBackgroundImage(values[0], values[1]); break;
+            case DL_DRAW_PLACEHOLDER: dc->DrawPlaceholder(values[0], values[1]); break;
+            case DL_START_TEXT:
+                dc->StartText(values[0], values[1], (data_HORIZONTALALIGNMENT)values[2]);
+                break;
+            case DL_END_TEXT: dc->EndText(); break;
+            case DL_MOVE_TEXT_TO:
+                dc->MoveTextTo(values[0], values[1], (data_HORIZONTALALIGNMENT)values[2]);
+                break;
+            case DL_START_GRAPHIC: dc->StartGraphic(object, strings[0], strings[1]); break;
+            case DL_END_GRAPHIC: dc->EndGraphic(object, command.m_view); break;
+            case DL_START_CUSTOM_GRAPHIC: dc->StartCustomGraphic(strings[0], strings[1], strings[2]); break;
+            case DL_END_CUSTOM_GRAPHIC: dc->EndCustomGraphic(); break;
+            case DL_RESUME_GRAPHIC: dc->ResumeGraphic(object, strings[0]); break;
+            case DL_END_RESUMED_GRAPHIC: dc->EndResumedGraphic(object, command.m_view); break;
+            case DL_START_TEXT_GRAPHIC: dc->StartTextGraphic(object, strings[0], strings[1]); break;
+            case DL_END_TEXT_GRAPHIC: dc->EndTextGraphic(object, command.m_view); break;
+            case DL_ROTATE_GRAPHIC:
+                dc->RotateGraphic(Point(values[0], values[1]), command.m_doubleValues[0]);
+                break;
+            case DL_START_PAGE: dc->StartPage(); break;
+            case DL_END_PAGE: dc->EndPage(); break;
+            case DL_ADD_DESCRIPTION: dc->AddDescription(strings[0]); break;
+            default: assert(false);
+        }
+
+        if (command.m_pen != -1) dc->ResetPen();
+        if (command.m_brush != -1) dc->ResetBrush();
+        if (command.m_font != -1) dc->ResetFont();
+    }
+
+    if (isDeactivatedX || isDeactivatedY) dc->ReactivateGraphic();
+}
+
+void DisplayListDeviceContext::SetBackground(int colour, int style)
+{
+    DisplayListCommand &command = AddCommand(DL_SET_BACKGROUND);
+    command.m_values[0] = colour;
+    command.m_values[1] = style;
+}
+
+void DisplayListDeviceContext::SetBackgroundImage(void *image, double opacity)
+{
+    DisplayListCommand &command = AddCommand(DL_SET_BACKGROUND_IMAGE);
+    command.m_pointer = image;
+    command.m_doubleValues[0] = opacity;
+}
+
+void DisplayListDeviceContext::SetBackgroundMode(int mode)
+{
+    DisplayListCommand &command = AddCommand(DL_SET_BACKGROUND_MODE);
+    command.m_values[0] = mode;
+}
+
+void DisplayListDeviceContext::SetTextForeground(int colour)
+{
+    DisplayListCommand &command = AddCommand(DL_SET_TEXT_FOREGROUND);
+    command.m_values[0] = colour;
+}
+
+void DisplayListDeviceContext::SetTextBackground(int colour)
+{
+    DisplayListCommand &command = AddCommand(DL_SET_TEXT_BACKGROUND);
+    command.m_values[0] = colour;
+}
+
+void DisplayListDeviceContext::SetLogicalOrigin(int x, int y)
+{
+    m_originX = x;
+    m_originY = y;
+
+    DisplayListCommand &command = AddCommand(DL_SET_LOGICAL_ORIGIN);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+}
+
+Point DisplayListDeviceContext::GetLogicalOrigin()
+{
+    return Point(m_originX, m_originY);
+}
+
+void DisplayListDeviceContext::DrawComplexBezierPath(Point bezier1[4], Point bezier2[4])
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_COMPLEX_BEZIER_PATH);
+    command.m_pointIdx = AddPoints(4, bezier1);
+    AddPoints(4, bezier2);
+}
+
+void DisplayListDeviceContext::DrawCircle(int x, int y, int radius)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_CIRCLE);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = radius;
+}
+
+void DisplayListDeviceContext::DrawEllipse(int x, int y, int width, int height)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_ELLIPSE);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = width;
+    command.m_values[3] = height;
+}
+
+void DisplayListDeviceContext::DrawEllipticArc(int x, int y, int width, int height, double start, double end)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_ELLIPTIC_ARC);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = width;
+    command.m_values[3] = height;
+    command.m_doubleValues[0] = start;
+    command.m_doubleValues[1] = end;
+}
+
+void DisplayListDeviceContext::DrawLine(int x1, int y1, int x2, int y2)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_LINE);
+    command.m_values[0] = x1;
+    command.m_values[1] = y1;
+    command.m_values[2] = x2;
+    command.m_values[3] = y2;
+}
+
+void DisplayListDeviceContext::DrawPolygon(int n, Point points[], int xoffset, int yoffset, int fill_style)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_POLYGON);
+    command.m_values[0] = n;
+    command.m_values[1] = xoffset;
+    command.m_values[2] = yoffset;
+    command.m_values[3] = fill_style;
+    command.m_pointIdx = AddPoints(n, points);
+}
+
+void DisplayListDeviceContext::DrawRectangle(int x, int y, int width, int height)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_RECTANGLE);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = width;
+    command.m_values[3] = height;
+}
+
+void DisplayListDeviceContext::DrawRotatedText(const std::string &text, int x, int y, double angle)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_ROTATED_TEXT);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_doubleValues[0] = angle;
+    command.m_stringIdx = AddString(text);
+}
+
+void DisplayListDeviceContext::DrawRoundedRectangle(int x, int y, int width, int height, double radius)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_ROUNDED_RECTANGLE);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = width;
+    command.m_values[3] = height;
+    command.m_doubleValues[0] = radius;
+}
+
+void DisplayListDeviceContext::DrawText(const std::string &text, const std::wstring wtext, int x, int y)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_TEXT);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_stringIdx = AddString(text);
+    command.m_wstringIdx = (int)m_wstrings.size();
+    m_wstrings.push_back(wtext);
+}
+
+void DisplayListDeviceContext::DrawMusicText(const std::wstring &text, int x, int y, bool setSmuflGlyph)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_MUSIC_TEXT);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = setSmuflGlyph;
+    command.m_wstringIdx = (int)m_wstrings.size();
+    m_wstrings.push_back(text);
+}
+
+void DisplayListDeviceContext::DrawSpline(int n, Point points[])
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_SPLINE);
+    command.m_values[0] = n;
+    command.m_pointIdx = AddPoints(n, points);
+}
+
+void DisplayListDeviceContext::DrawSvgShape(int x, int y, int width, int height, pugi::xml_node svg)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_SVG_SHAPE);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = width;
+    command.m_values[3] = height;
+    command.m_svg = svg;
+}
+
+void DisplayListDeviceContext::DrawBackgroundImage(int x, int y)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_BACKGROUND_IMAGE);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+}
+
+void DisplayListDeviceContext::DrawPlaceholder(int x, int y)
+{
+    DisplayListCommand &command = AddCommand(DL_DRAW_PLACEHOLDER);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+}
+
+void DisplayListDeviceContext::StartText(int x, int y, data_HORIZONTALALIGNMENT alignment)
+{
+    DisplayListCommand &command = AddCommand(DL_START_TEXT);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = alignment;
+}
+
+void DisplayListDeviceContext::EndText()
+{
+    AddCommand(DL_END_TEXT);
+}
+
+void DisplayListDeviceContext::MoveTextTo(int x, int y, data_HORIZONTALALIGNMENT alignment)
+{
+    DisplayListCommand &command = AddCommand(DL_MOVE_TEXT_TO);
+    command.m_values[0] = x;
+    command.m_values[1] = y;
+    command.m_values[2] = alignment;
+}
+
+void DisplayListDeviceContext::StartGraphic(Object *object, std::string gClass, std::string gId)
+{
+    DisplayListCommand &command = AddCommand(DL_START_GRAPHIC);
+    command.m_pointer = object;
+    command.m_stringIdx = AddString(gClass);
+    AddString(gId);
+}
+
+void DisplayListDeviceContext::EndGraphic(Object *object, View *view)
+{
+    DisplayListCommand &command = AddCommand(DL_END_GRAPHIC);
+    command.m_pointer = object;
+    command.m_view = view;
+}
+
+void DisplayListDeviceContext::StartCustomGraphic(std::string name, std::string gClass, std::string gId)
+{
+    DisplayListCommand &command = AddCommand(DL_START_CUSTOM_GRAPHIC);
+    command.m_stringIdx = AddString(name);
+    AddString(gClass);
+    AddString(gId);
+}
+
+void DisplayListDeviceContext::EndCustomGraphic()
+{
+    AddCommand(DL_END_CUSTOM_GRAPHIC);
+}
+
+void DisplayListDeviceContext::ResumeGraphic(Object *object, std::string gId)
+{
+    DisplayListCommand &command = AddCommand(DL_RESUME_GRAPHIC);
+    command.m_pointer = object;
+    command.m_stringIdx = AddString(gId);
+}
+
+void DisplayListDeviceContext::EndResumedGraphic(Object *object, View *view)
+{
+    DisplayListCommand &command = AddCommand(DL_END_RESUMED_GRAPHIC);
+    command.m_pointer = object;
+    command.m_view = view;
+}
+
+void DisplayListDeviceContext::StartTextGraphic(Object *object, std::string gClass, std::string gId)
+{
+    DisplayListCommand &command = AddCommand(DL_START_TEXT_GRAPHIC);
+    command.m_pointer = object;
+    command.m_stringIdx = AddString(gClass);
+    AddString(gId);
+}
+
+void DisplayListDeviceContext::EndTextGraphic(Object *object, View *view)
+{
+    DisplayListCommand &command = AddCommand(DL_END_TEXT_GRAPHIC);
+    command.m_pointer = object;
+    command.m_view = view;
+}
+
+void DisplayListDeviceContext::RotateGraphic(Point const &orig, double angle)
+{
+    DisplayListCommand &command = AddCommand(DL_ROTATE_GRAPHIC);
+    command.m_values[0] = orig.x;
+    command.m_values[1] = orig.y;
+    command.m_doubleValues[0] = angle;
+}
+
+void DisplayListDeviceContext::StartPage()
+{
+    AddCommand(DL_START_PAGE);
+}
+
+void DisplayListDeviceContext::EndPage()
+{
+    AddCommand(DL_END_PAGE);
+}
+
+void DisplayListDeviceContext::AddDescription(const std::string &text)
+{
+    DisplayListCommand &command = AddCommand(DL_ADD_DESCRIPTION);
+    command.m_stringIdx = AddString(text);
+}
+
+} // namespace vrv
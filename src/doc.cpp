@@ -9,6 +9,7 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
 #include <math.h>
 
@@ -24,6 +25,7 @@
 #include "keysig.h"
 #include "label.h"
 #include "layer.h"
+#include "layoutcache.h"
 #include "mdiv.h"
 #include "measure.h"
 #include "mensur.h"
@@ -67,6 +69,9 @@ namespace vrv {
 Doc::Doc() : Object("doc-")
 {
     m_options = new Options();
+    m_layoutCache = NULL;
+    m_modificationCount = 0;
+    m_measureGeneration = 0;
 
     Reset();
 }
@@ -91,10 +96,35 @@ void Doc::Reset()
     m_drawingPage = NULL;
     m_currentScoreDefDone = false;
     m_drawingPreparationDone = false;
+    m_drawingGrpObjects.clear();
     m_hasMidiTimemap = false;
     m_hasAnalyticalMarkup = false;
     m_isMensuralMusicOnly = false;
 
+    m_castOffContextHash = 0;
+    m_castOffPageWidth = 0;
+    m_castOffPageHeight = 0;
+    m_castOffScoreDefWidth = 0;
+    m_castOffLabelsWidth = 0;
+    m_castOffAbbrLabelsWidth = 0;
+
+    m_isCastOffPending = false;
+    m_lazyLongestActualDur = DUR_4;
+    m_lazyScoreDefWidth = 0;
+    m_lazyPgHeadHeight = 0;
+    m_lazyPgFootHeight = 0;
+    m_lazyPgHead2Height = 0;
+    m_lazyPgFoot2Height = 0;
+    m_lazyMeasureCount = 0;
+    m_lazyPageCount = 0;
+
+    m_excerptPage = NULL;
+    m_excerptObjects.clear();
+    m_excerptPositions.clear();
+
+    this->SetModified();
+    this->SetMeasuresChanged();
+
     m_scoreDef.Reset();
 
     m_drawingSmuflFontSize = 0;
@@ -460,13 +490,26 @@ void Doc::PrepareJsonTimemap(std::string &output, std::map<int, double> &realTim
 
 void Doc::PrepareDrawing()
 {
+    TraceSpan traceSpan("PrepareDrawing");
+    TraceSpan stageSpan("ResetDrawing");
+
+    this->SetModified();
+
+    this->ResetCastOffLayout();
+
+    m_drawingGrpObjects.clear();
+
     if (m_drawingPreparationDone) {
         Functor resetDrawing(&Object::ResetDrawing);
         this->Process(&resetDrawing, NULL);
+        // Some element parts (e.g., the artic parts) are created again
+        this->SetMeasuresChanged();
     }
 
     /************ Resolve @starid / @endid ************/
 
+    stageSpan.Restart("PrepareTimeSpanning");
+
     // Try to match all spanning elements (slur, tie, etc) by processing backwards
     PrepareTimeSpanningParams prepareTimeSpanningParams;
     Functor prepareTimeSpanning(&Object::PrepareTimeSpanning);
@@ -486,6 +529,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve @starid (only) ************/
 
+    stageSpan.Restart("PrepareTimePointing");
+
     // Try to match all time pointing elements (tempo, fermata, etc) by processing backwards
     PrepareTimePointingParams prepareTimePointingParams;
     Functor prepareTimePointing(&Object::PrepareTimePointing);
@@ -495,6 +540,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve @tstamp / tstamp2 ************/
 
+    stageSpan.Restart("PrepareTimestamps");
+
     // Now try to match the @tstamp and @tstamp2 attributes.
     PrepareTimestampsParams prepareTimestampsParams;
     prepareTimestampsParams.m_timeSpanningInterfaces = prepareTimeSpanningParams.m_timeSpanningInterfaces;
@@ -510,6 +557,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve @plist ************/
 
+    stageSpan.Restart("PreparePlist");
+
     // Try to match all pointing elements using @plist
     PreparePlistParams preparePlistParams;
     Functor preparePlist(&Object::PreparePlist);
@@ -529,6 +578,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve cross staff ************/
 
+    stageSpan.Restart("PrepareCrossStaff");
+
     // Prepare the cross-staff pointers
     PrepareCrossStaffParams prepareCrossStaffParams;
     Functor prepareCrossStaff(&Object::PrepareCrossStaff);
@@ -537,6 +588,8 @@ void Doc::PrepareDrawing()
 
     /************ Prepare processing by staff/layer/verse ************/
 
+    stageSpan.Restart("PrepareProcessingLists");
+
     // We need to populate processing lists for processing the document by Layer (for matching @tie) and
     // by Verse (for matching syllable connectors)
     PrepareProcessingListsParams prepareProcessingListsParams;
@@ -559,6 +612,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve some pointers by layer ************/
 
+    stageSpan.Restart("PreparePointersByLayer");
+
     std::vector<AttComparison *> filters;
     for (staves = prepareProcessingListsParams.m_layerTree.child.begin();
          staves != prepareProcessingListsParams.m_layerTree.child.end(); ++staves) {
@@ -578,6 +633,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve lyric connectors ************/
 
+    stageSpan.Restart("PrepareLyrics");
+
     // Same for the lyrics, but Verse by Verse since Syl are TimeSpanningInterface elements for handling connectors
     for (staves = prepareProcessingListsParams.m_verseTree.child.begin();
          staves != prepareProcessingListsParams.m_verseTree.child.end(); ++staves) {
@@ -605,6 +662,8 @@ void Doc::PrepareDrawing()
 
     /************ Fill control event spanning ************/
 
+    stageSpan.Restart("FillStaffCurrentTimeSpanning");
+
     // Once <slur>, <ties> and @ties are matched but also syl connectors, we need to set them as running
     // TimeSpanningInterface to each staff they are extended. This does not need to be done staff by staff because we
     // can just check the staff->GetN to see where we are (see Staff::FillStaffCurrentTimeSpanning)
@@ -621,6 +680,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve mRpt ************/
 
+    stageSpan.Restart("PrepareRpt");
+
     // Process by staff for matching mRpt elements and setting the drawing number
     for (staves = prepareProcessingListsParams.m_layerTree.child.begin();
          staves != prepareProcessingListsParams.m_layerTree.child.end(); ++staves) {
@@ -641,6 +702,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve endings ************/
 
+    stageSpan.Restart("PrepareBoundaries");
+
     // Prepare the endings (pointers to the measure after and before the boundaries
     PrepareBoundariesParams prepareEndingsParams;
     Functor prepareEndings(&Object::PrepareBoundaries);
@@ -648,6 +711,8 @@ void Doc::PrepareDrawing()
 
     /************ Resolve floating groups for vertical alignment ************/
 
+    stageSpan.Restart("PrepareFloatingGrps");
+
     // Prepare the floating drawing groups
     PrepareFloatingGrpsParams prepareFloatingGrpsParams;
     Functor prepareFloatingGrps(&Object::PrepareFloatingGrps);
@@ -656,15 +721,28 @@ void Doc::PrepareDrawing()
 
     /************ Resolve cue size ************/
 
+    stageSpan.Restart("PrepareDrawingCueSize");
+
     // Prepare the drawing cue size
     Functor prepareDrawingCueSize(&Object::PrepareDrawingCueSize);
     this->Process(&prepareDrawingCueSize, NULL);
 
     /************ Instanciate LayerElement parts (stemp, flag, dots, etc) ************/
 
+    stageSpan.Restart("PrepareLayerElementParts");
+
     Functor prepareLayerElementParts(&Object::PrepareLayerElementParts);
     this->Process(&prepareLayerElementParts, NULL);
 
+    /************ Set the content flags of the measures ************/
+
+    stageSpan.Restart("PrepareMeasureContent");
+
+    PrepareMeasureContentParams prepareMeasureContentParams;
+    Functor prepareMeasureContent(&Object::PrepareMeasureContent);
+    Functor prepareMeasureContentEnd(&Object::PrepareMeasureContentEnd);
+    this->Process(&prepareMeasureContent, &prepareMeasureContentParams, &prepareMeasureContentEnd);
+
     /*
     // Alternate solution with StaffN_LayerN_VerseN_t
     StaffN_LayerN_VerseN_t::iterator staves;
@@ -696,7 +774,17 @@ void Doc::PrepareDrawing()
     m_drawingPreparationDone = true;
 }
 
-void Doc::CollectScoreDefs(bool force)
+int Doc::GetDrawingGrpObjectIdx(void *drawingGrpObject)
+{
+    std::vector<void *>::const_iterator it
+        = std::find(m_drawingGrpObjects.begin(), m_drawingGrpObjects.end(), drawingGrpObject);
+    if (it != m_drawingGrpObjects.end()) return (int)(it - m_drawingGrpObjects.begin());
+
+    m_drawingGrpObjects.push_back(drawingGrpObject);
+    return (int)m_drawingGrpObjects.size() - 1;
+}
+
+void Doc::CollectScoreDefs(bool force, Measure *scoreDefMeasure, ScoreDef *measureScoreDef)
 {
     if (m_currentScoreDefDone && !force) {
         return;
@@ -705,10 +793,21 @@ void Doc::CollectScoreDefs(bool force)
     if (m_currentScoreDefDone) {
         Functor unsetCurrentScoreDef(&Object::UnsetCurrentScoreDef);
         this->Process(&unsetCurrentScoreDef, NULL);
+        // The drawing scoreDef objects are created again and the pages laid out so far have to be laid out again
+        Pages *pages = this->GetPages();
+        assert(pages);
+        int i;
+        for (i = 0; i < pages->GetChildCount(); ++i) {
+            Page *page = dynamic_cast<Page *>(pages->GetChild(i));
+            assert(page);
+            page->ResetLayout();
+        }
     }
 
     ScoreDef upcomingScoreDef = m_scoreDef;
     SetCurrentScoreDefParams setCurrentScoreDefParams(this, &upcomingScoreDef);
+    setCurrentScoreDefParams.m_scoreDefMeasure = scoreDefMeasure;
+    setCurrentScoreDefParams.m_measureScoreDef = measureScoreDef;
     Functor setCurrentScoreDef(&Object::SetCurrentScoreDef);
 
     // First process the current scoreDef in order to fill the staffDef with
@@ -722,8 +821,10 @@ void Doc::CollectScoreDefs(bool force)
     m_currentScoreDefDone = true;
 }
 
-void Doc::CastOffDoc()
+void Doc::CastOffDoc(bool useCastOffLayout)
 {
+    TraceSpan traceSpan("CastOffDoc");
+
     Pages *pages = this->GetPages();
     assert(pages);
 
@@ -732,28 +833,56 @@ void Doc::CastOffDoc()
         return;
     }
 
+    this->SetModified();
+
     this->CollectScoreDefs();
 
     Page *contentPage = this->SetDrawingPage(0);
     assert(contentPage);
-    contentPage->LayOutHorizontally();
-
-    System *contentSystem = dynamic_cast<System *>(contentPage->DetachChild(0));
-    assert(contentSystem);
+    contentPage->LayOutHorizontally(useCastOffLayout);
+
+    // The content system is detached until the systems are cast off
+    {
+        CancellationDeferralScope cancellationDeferralScope;
+
+        System *contentSystem = dynamic_cast<System *>(contentPage->DetachChild(0));
+        assert(contentSystem);
+
+        if (!useCastOffLayout) {
+            // Store the horizontal layout of the content page for re-flowing the document
+            AttComparison matchType(MEASURE);
+            ArrayOfObjects measures;
+            contentSystem->FindAllChildByAttComparison(&measures, &matchType);
+            for (auto &object : measures) {
+                Measure *measure = dynamic_cast<Measure *>(object);
+                assert(measure);
+                measure->StoreCastOffLayout();
+            }
+            m_castOffScoreDefWidth = contentPage->m_drawingScoreDef.GetDrawingWidth();
+            m_castOffLabelsWidth = contentSystem->GetDrawingLabelsWidth();
+            m_castOffAbbrLabelsWidth = contentSystem->GetDrawingAbbrLabelsWidth();
+        }
+        else {
+            // The labels are not drawn when the horizontal layout is restored
+            contentSystem->SetDrawingLabelsWidth(m_castOffLabelsWidth);
+            contentSystem->SetDrawingAbbrLabelsWidth(m_castOffAbbrLabelsWidth);
+        }
 
-    System *currentSystem = new System();
-    contentPage->AddChild(currentSystem);
-    CastOffSystemsParams castOffSystemsParams(contentSystem, contentPage, currentSystem);
-    castOffSystemsParams.m_systemWidth = this->m_drawingPageWidth - this->m_drawingPageMarginLeft
-        - this->m_drawingPageMarginRight - currentSystem->m_systemLeftMar - currentSystem->m_systemRightMar;
-    castOffSystemsParams.m_shift = -contentSystem->GetDrawingLabelsWidth();
-    castOffSystemsParams.m_currentScoreDefWidth
-        = contentPage->m_drawingScoreDef.GetDrawingWidth() + contentSystem->GetDrawingAbbrLabelsWidth();
+        System *currentSystem = new System();
+        contentPage->AddChild(currentSystem);
+        CastOffSystemsParams castOffSystemsParams(contentSystem, contentPage, currentSystem);
+        castOffSystemsParams.m_systemWidth = this->m_drawingPageWidth - this->m_drawingPageMarginLeft
+            - this->m_drawingPageMarginRight - currentSystem->m_systemLeftMar - currentSystem->m_systemRightMar;
+        castOffSystemsParams.m_shift = -m_castOffLabelsWidth;
+        castOffSystemsParams.m_currentScoreDefWidth = m_castOffScoreDefWidth + m_castOffAbbrLabelsWidth;
+
+        Functor castOffSystems(&Object::CastOffSystems);
+        Functor castOffSystemsEnd(&Object::CastOffSystemsEnd);
+        contentSystem->Process(&castOffSystems, &castOffSystemsParams, &castOffSystemsEnd);
+        delete contentSystem;
+    }
 
-    Functor castOffSystems(&Object::CastOffSystems);
-    Functor castOffSystemsEnd(&Object::CastOffSystemsEnd);
-    contentSystem->Process(&castOffSystems, &castOffSystemsParams, &castOffSystemsEnd);
-    delete contentSystem;
+    m_castOffPageWidth = this->m_drawingPageWidth - this->m_drawingPageMarginLeft - this->m_drawingPageMarginRight;
 
     // Reset the scoreDef at the beginning of each system
     this->CollectScoreDefs(true);
@@ -762,15 +891,95 @@ void Doc::CastOffDoc()
     // We can actually optimise this and have a custom version that does not redo all the calculation
     contentPage->LayOutVertically();
 
-    // Detach the contentPage
+    // Store the vertical layout of the content page for re-flowing the document
+    m_castOffPageHeight = this->m_drawingPageHeight;
+    int i;
+    for (i = 0; i < contentPage->GetChildCount(); ++i) {
+        System *system = dynamic_cast<System *>(contentPage->GetChild(i));
+        assert(system);
+        system->StoreCastOffLayout();
+    }
+
+    // Detach the contentPage - until the pages are cast off
+    CancellationDeferralScope cancellationDeferralScope;
     pages->DetachChild(0);
     assert(contentPage && !contentPage->GetParent());
     this->ResetDrawingPage();
 
+    this->CastOffContentPage(contentPage);
+
+    m_castOffContextHash = LayoutCache::CalcContextHash(this);
+}
+
+bool Doc::ReflowDoc()
+{
+    TraceSpan traceSpan("ReflowDoc");
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    if ((m_castOffContextHash == 0) || (m_castOffContextHash != LayoutCache::CalcContextHash(this))) {
+        return false;
+    }
+
+    this->SetModified();
+
+    // Make sure the page size and margins are the ones of the current options
+    this->ResetDrawingPage();
+    if (!this->SetDrawingPage(0)) return false;
+
+    int pageWidth = this->m_drawingPageWidth - this->m_drawingPageMarginLeft - this->m_drawingPageMarginRight;
+    if (pageWidth != m_castOffPageWidth) {
+        this->UnCastOffDoc();
+        this->CastOffDoc(true);
+        return true;
+    }
+
+    // The systems are unchanged, move them to a content page and only cast off the pages again
+    CancellationDeferralScope cancellationDeferralScope;
+    this->ResetDrawingPage();
+    Page *contentPage = new Page();
+    int i;
+    for (i = 0; i < pages->GetChildCount(); ++i) {
+        contentPage->MoveChildrenFrom(pages->GetChild(i));
+    }
+    pages->ClearChildren();
+
+    this->CastOffContentPage(contentPage);
+
+    m_castOffContextHash = LayoutCache::CalcContextHash(this);
+
+    return true;
+}
+
+void Doc::ReleaseLayouts(Page *activePage)
+{
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    int i;
+    for (i = 0; i < pages->GetChildCount(); ++i) {
+        Page *page = dynamic_cast<Page *>(pages->GetChild(i));
+        assert(page);
+        if (page != activePage) page->ReleaseLayout();
+    }
+}
+
+void Doc::CastOffContentPage(Page *contentPage)
+{
+    Pages *pages = this->GetPages();
+    assert(pages);
+    assert(contentPage && !contentPage->GetParent());
+
+    // The content page is detached
+    CancellationDeferralScope cancellationDeferralScope;
+
     Page *currentPage = new Page();
     CastOffPagesParams castOffPagesParams(contentPage, this, currentPage);
     CastOffRunningElements(&castOffPagesParams);
     castOffPagesParams.m_pageHeight = this->m_drawingPageHeight - this->m_drawingPageMarginBot;
+    // The systems are positioned from the page height used for the vertical layout of the content page
+    castOffPagesParams.m_shift = m_castOffPageHeight - this->m_drawingPageHeight;
     Functor castOffPages(&Object::CastOffPages);
     pages->AddChild(currentPage);
     contentPage->Process(&castOffPages, &castOffPagesParams);
@@ -783,6 +992,492 @@ void Doc::CastOffDoc()
     this->CollectScoreDefs(true);
 }
 
+void Doc::CastOffDocLazy()
+{
+    TraceSpan traceSpan("CastOffDocLazy");
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    if (pages->GetChildCount() != 1) {
+        LogDebug("Document is already cast off");
+        return;
+    }
+
+    this->ResetCastOffLayout();
+
+    this->CollectScoreDefs();
+
+    Page *contentPage = dynamic_cast<Page *>(pages->GetChild(0));
+    assert(contentPage);
+    m_lazyLongestActualDur = contentPage->GetLongestActualDur();
+
+    // Calculate the height of the running elements once for all chunks
+    CancellationDeferralScope cancellationDeferralScope;
+    pages->DetachChild(0);
+    CastOffPagesParams castOffPagesParams(NULL, this, NULL);
+    CastOffRunningElements(&castOffPagesParams);
+    m_lazyPgHeadHeight = castOffPagesParams.m_pgHeadHeight;
+    m_lazyPgFootHeight = castOffPagesParams.m_pgFootHeight;
+    m_lazyPgHead2Height = castOffPagesParams.m_pgHead2Height;
+    m_lazyPgFoot2Height = castOffPagesParams.m_pgFoot2Height;
+    pages->AddChild(contentPage);
+
+    m_lazyMeasureCount = 0;
+    m_lazyPageCount = 0;
+    m_isCastOffPending = true;
+}
+
+void Doc::CastOffLazyPages(int pageCount)
+{
+    TraceSpan traceSpan("CastOffLazyPages");
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    while (m_isCastOffPending) {
+        // The content page is the last one
+        int castOffPageCount = pages->GetChildCount() - 1;
+        if ((pageCount != -1) && (castOffPageCount >= pageCount)) break;
+
+        int measureCount = VRV_UNSET;
+        if (pageCount != -1) {
+            int measuresPerPage
+                = (m_lazyPageCount > 0) ? m_lazyMeasureCount / m_lazyPageCount : LAZY_CAST_OFF_MEASURES_PER_PAGE;
+            // Cast off at least as many pages as there are already for keeping the number of chunks low when all
+            // the pages are requested one after the other - and one more page since the last one is not kept
+            int chunkPageCount = std::max(pageCount - castOffPageCount, castOffPageCount);
+            measureCount = std::max(1, measuresPerPage) * (chunkPageCount + 1);
+        }
+        else {
+            System *pendingSystem = dynamic_cast<System *>(pages->GetChild(castOffPageCount)->GetChild(0));
+            assert(pendingSystem);
+            measureCount = pendingSystem->GetChildCount(MEASURE);
+        }
+
+        // Make the chunk longer until it fills at least one page
+        while (this->CastOffLazyChunk(measureCount) == 0) {
+            measureCount *= 2;
+        }
+    }
+}
+
+void Doc::CastOffLazyPagesUntil(Object *object)
+{
+    assert(object);
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    while (m_isCastOffPending) {
+        Page *page = dynamic_cast<Page *>(object->GetFirstParent(PAGE));
+        // The object is not on the content page anymore
+        if (!page || (page->GetIdx() < pages->GetChildCount() - 1)) break;
+        this->CastOffLazyPages(pages->GetChildCount());
+    }
+}
+
+int Doc::GetEstimatedPageCount()
+{
+    if (!m_isCastOffPending) return this->GetPageCount();
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    int castOffPageCount = pages->GetChildCount() - 1;
+    System *pendingSystem = dynamic_cast<System *>(pages->GetChild(castOffPageCount)->GetChild(0));
+    assert(pendingSystem);
+
+    int measuresPerPage
+        = (m_lazyPageCount > 0) ? m_lazyMeasureCount / m_lazyPageCount : LAZY_CAST_OFF_MEASURES_PER_PAGE;
+    measuresPerPage = std::max(1, measuresPerPage);
+    int pendingPageCount = (pendingSystem->GetChildCount(MEASURE) + measuresPerPage - 1) / measuresPerPage;
+
+    return castOffPageCount + std::max(1, pendingPageCount);
+}
+
+int Doc::CastOffLazyChunk(int measureCount)
+{
+    // The chunk is cast off entirely since the content moves between pages and systems
+    CancellationDeferralScope cancellationDeferralScope;
+
+    this->SetModified();
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    // The chunk is laid out in the pending content page itself since its scoreDefs are already set
+    Page *chunkPage = dynamic_cast<Page *>(pages->GetChild(pages->GetChildCount() - 1));
+    assert(chunkPage);
+    System *contentSystem = dynamic_cast<System *>(chunkPage->GetChild(0));
+    assert(contentSystem);
+
+    bool isFirstChunk = (pages->GetChildCount() == 1);
+
+    // The scoreDef at the beginning of the chunk, for setting the scoreDefs of its pages only
+    m_lazyScoreDef = chunkPage->m_drawingScoreDef;
+
+    // Move the content from the first measure after the chunk to a new pending page
+    Page *pendingPage = new Page();
+    System *pendingSystem = new System();
+    pendingPage->AddChild(pendingSystem);
+    int chunkMeasureCount = 0;
+    int i;
+    for (i = 0; i < contentSystem->GetChildCount(); ++i) {
+        if (contentSystem->GetChild(i)->Is(MEASURE)) {
+            if (chunkMeasureCount == measureCount) break;
+            ++chunkMeasureCount;
+        }
+    }
+    for (; i < contentSystem->GetChildCount(); ++i) {
+        pendingSystem->AddChild(contentSystem->Relinquish(i));
+    }
+    contentSystem->ClearRelinquishedChildren();
+    bool isLastChunk = (pendingSystem->GetChildCount() == 0);
+    int pendingMeasureCount = pendingSystem->GetChildCount(MEASURE);
+
+    pages->AddChild(pendingPage);
+
+    this->ResetDrawingPage();
+    this->SetDrawingPage(chunkPage->GetIdx());
+    chunkPage->LayOutHorizontally(false, m_lazyLongestActualDur);
+
+    contentSystem = dynamic_cast<System *>(chunkPage->DetachChild(0));
+    assert(contentSystem);
+
+    // The values of the first chunk are used for all of them, as they are for the content page in CastOffDoc
+    if (isFirstChunk) {
+        m_castOffScoreDefWidth = chunkPage->m_drawingScoreDef.GetDrawingWidth();
+        m_castOffLabelsWidth = contentSystem->GetDrawingLabelsWidth();
+        m_castOffAbbrLabelsWidth = contentSystem->GetDrawingAbbrLabelsWidth();
+        m_lazyScoreDefWidth = m_castOffScoreDefWidth + m_castOffAbbrLabelsWidth;
+    }
+
+    System *currentSystem = new System();
+    chunkPage->AddChild(currentSystem);
+    CastOffSystemsParams castOffSystemsParams(contentSystem, chunkPage, currentSystem);
+    castOffSystemsParams.m_systemWidth = this->m_drawingPageWidth - this->m_drawingPageMarginLeft
+        - this->m_drawingPageMarginRight - currentSystem->m_systemLeftMar - currentSystem->m_systemRightMar;
+    // Only the first system of the document has the full labels. In the other chunks, the first measure includes the
+    // scoreDef at the beginning of the system, which is not the case when it is laid out in the middle of a system
+    if (isFirstChunk) {
+        castOffSystemsParams.m_shift = -m_castOffLabelsWidth;
+    }
+    else {
+        Measure *firstMeasure = dynamic_cast<Measure *>(contentSystem->FindChildByType(MEASURE, 1));
+        castOffSystemsParams.m_shift = (firstMeasure) ? firstMeasure->GetLeftBarLineXRel() : 0;
+    }
+    castOffSystemsParams.m_currentScoreDefWidth = m_lazyScoreDefWidth;
+
+    Functor castOffSystems(&Object::CastOffSystems);
+    Functor castOffSystemsEnd(&Object::CastOffSystemsEnd);
+    contentSystem->Process(&castOffSystems, &castOffSystemsParams, &castOffSystemsEnd);
+    delete contentSystem;
+
+    if (!isLastChunk) {
+        // The last system continues in the next chunk
+        int systemIdx = (chunkPage->GetChildCount() > 1) ? chunkPage->GetChildCount() - 1 : 0;
+        this->UnCastOffLazyPage(chunkPage, pendingSystem, systemIdx);
+        if (systemIdx == 0) {
+            this->ResetDrawingPage();
+            pages->DeleteChild(chunkPage);
+            this->CollectScoreDefs(pendingPage->GetIdx(), pendingPage->GetIdx(), m_lazyScoreDef);
+            return 0;
+        }
+    }
+
+    // Reset the scoreDef at the beginning of each system
+    this->ResetDrawingPage();
+    this->CollectScoreDefs(chunkPage->GetIdx(), pages->GetChildCount() - 1, m_lazyScoreDef);
+
+    this->SetDrawingPage(chunkPage->GetIdx());
+    chunkPage->LayOutVertically();
+    for (i = 0; i < chunkPage->GetChildCount(); ++i) {
+        System *system = dynamic_cast<System *>(chunkPage->GetChild(i));
+        assert(system);
+        system->StoreCastOffLayout();
+    }
+
+    // Detach the chunk page and the pending page for adding the new pages
+    this->ResetDrawingPage();
+    pages->DetachChild(chunkPage->GetIdx());
+    pages->DetachChild(pendingPage->GetIdx());
+    int pageCount = pages->GetChildCount();
+
+    Page *currentPage = new Page();
+    CastOffPagesParams castOffPagesParams(chunkPage, this, currentPage);
+    castOffPagesParams.m_pageHeight = this->m_drawingPageHeight - this->m_drawingPageMarginBot;
+    if (pageCount > 0) {
+        // The first system of the chunk is positioned as in a new page - use VRV_UNSET value as a flag
+        System *firstSystem = dynamic_cast<System *>(chunkPage->GetChild(0));
+        assert(firstSystem);
+        castOffPagesParams.m_shift = firstSystem->GetDrawingYRel() - castOffPagesParams.m_pageHeight;
+        castOffPagesParams.m_pgHeadHeight = VRV_UNSET;
+    }
+    else {
+        castOffPagesParams.m_pgHeadHeight = m_lazyPgHeadHeight;
+    }
+    castOffPagesParams.m_pgFootHeight = m_lazyPgFootHeight;
+    castOffPagesParams.m_pgHead2Height = m_lazyPgHead2Height;
+    castOffPagesParams.m_pgFoot2Height = m_lazyPgFoot2Height;
+    Functor castOffPages(&Object::CastOffPages);
+    pages->AddChild(currentPage);
+    chunkPage->Process(&castOffPages, &castOffPagesParams);
+    delete chunkPage;
+
+    int addedPageCount = pages->GetChildCount() - pageCount;
+    if (!isLastChunk) {
+        // The last page continues in the next chunk
+        Page *lastPage = dynamic_cast<Page *>(pages->GetChild(pages->GetChildCount() - 1));
+        assert(lastPage);
+        this->UnCastOffLazyPage(lastPage, pendingSystem);
+        pages->DeleteChild(lastPage);
+        pages->AddChild(pendingPage);
+        addedPageCount--;
+        chunkMeasureCount -= pendingSystem->GetChildCount(MEASURE) - pendingMeasureCount;
+    }
+    else {
+        delete pendingPage;
+        m_isCastOffPending = false;
+    }
+
+    m_lazyMeasureCount += chunkMeasureCount;
+    m_lazyPageCount += addedPageCount;
+
+    // The width of the last scoreDef cast off is the one for the next chunk, as in ScoreDef::CastOffSystems
+    for (i = pageCount; i < pageCount + addedPageCount; ++i) {
+        AttComparison matchType(SCOREDEF);
+        ArrayOfObjects scoreDefs;
+        pages->GetChild(i)->FindAllChildByAttComparison(&scoreDefs, &matchType, 2);
+        if (scoreDefs.empty()) continue;
+        ScoreDef *scoreDef = dynamic_cast<ScoreDef *>(scoreDefs.back());
+        assert(scoreDef);
+        m_lazyScoreDefWidth = scoreDef->GetDrawingWidth() + m_castOffAbbrLabelsWidth;
+    }
+
+    this->CollectScoreDefs(pageCount, pages->GetChildCount() - 1, m_lazyScoreDef);
+
+    return addedPageCount;
+}
+
+void Doc::UnCastOffLazyPage(Page *page, System *pendingSystem, int systemIdx)
+{
+    assert(page);
+    assert(pendingSystem);
+
+    int i;
+    for (i = page->GetChildCount() - 1; i >= systemIdx; --i) {
+        System *system = dynamic_cast<System *>(page->GetChild(i));
+        assert(system);
+        pendingSystem->MoveChildrenFrom(system, 0);
+        page->DeleteChild(system);
+    }
+}
+
+void Doc::CollectScoreDefs(int startPageIdx, int endPageIdx, const ScoreDef &startScoreDef,
+    Measure *scoreDefMeasure, ScoreDef *measureScoreDef)
+{
+    Pages *pages = this->GetPages();
+    assert(pages);
+    assert((startPageIdx >= 0) && (startPageIdx <= endPageIdx) && (endPageIdx < pages->GetChildCount()));
+
+    // The other pages are not changed and do not have to be laid out again
+    Functor unsetCurrentScoreDef(&Object::UnsetCurrentScoreDef);
+    int i;
+    for (i = startPageIdx; i <= endPageIdx; ++i) {
+        Page *page = dynamic_cast<Page *>(pages->GetChild(i));
+        assert(page);
+        page->Process(&unsetCurrentScoreDef, NULL);
+        page->ResetLayout();
+    }
+
+    ScoreDef upcomingScoreDef = startScoreDef;
+    SetCurrentScoreDefParams setCurrentScoreDefParams(this, &upcomingScoreDef);
+    setCurrentScoreDefParams.m_scoreDefMeasure = scoreDefMeasure;
+    setCurrentScoreDefParams.m_measureScoreDef = measureScoreDef;
+    // The cautionary scoreDef of the last measure of the previous page is still set
+    if (startPageIdx > 0) {
+        setCurrentScoreDefParams.m_previousMeasure
+            = dynamic_cast<Measure *>(pages->GetChild(startPageIdx - 1)->FindChildByType(MEASURE, 2, BACKWARD));
+        setCurrentScoreDefParams.m_cautionaryScoreDefDone = true;
+    }
+    Functor setCurrentScoreDef(&Object::SetCurrentScoreDef);
+    for (i = startPageIdx; i <= endPageIdx; ++i) {
+        pages->GetChild(i)->Process(&setCurrentScoreDef, &setCurrentScoreDefParams);
+    }
+
+    // The cautionary scoreDef and the barline of the last measure depend on the beginning of the next page
+    Measure *lastMeasure = setCurrentScoreDefParams.m_previousMeasure;
+    if (!lastMeasure || (endPageIdx + 1 >= pages->GetChildCount())) return;
+    Page *nextPage = dynamic_cast<Page *>(pages->GetChild(endPageIdx + 1));
+    assert(nextPage);
+    if (nextPage->m_drawingScoreDef.m_setAsDrawing) {
+        ScoreDef cautionaryScoreDef = nextPage->m_drawingScoreDef;
+        SetCautionaryScoreDefParams setCautionaryScoreDefParams(&cautionaryScoreDef);
+        Functor setCautionaryScoreDef(&Object::SetCautionaryScoreDef);
+        lastMeasure->Process(&setCautionaryScoreDef, &setCautionaryScoreDefParams);
+    }
+    Measure *nextMeasure = dynamic_cast<Measure *>(nextPage->FindChildByType(MEASURE, 2));
+    if (nextMeasure) nextMeasure->SetDrawingBarLines(lastMeasure, true, false);
+}
+
+bool Doc::CastOffExcerpt(Measure *startMeasure, Measure *endMeasure)
+{
+    assert(startMeasure);
+    assert(endMeasure);
+
+    // The measures of the excerpt are moved to the excerpt page
+    CancellationDeferralScope cancellationDeferralScope;
+
+    if (m_excerptPage) {
+        LogDebug("An excerpt is already cast off");
+        return false;
+    }
+
+    if (this->GetType() == Transcription) {
+        LogError("Excerpts cannot be cast off for transcription documents");
+        return false;
+    }
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    // Collect the content of the systems from the start measure to the end measure
+    m_excerptObjects.clear();
+    bool inRange = false;
+    bool rangeDone = false;
+    int i, j, k;
+    for (i = 0; (i < pages->GetChildCount()) && !rangeDone; ++i) {
+        Object *page = pages->GetChild(i);
+        for (j = 0; (j < page->GetChildCount()) && !rangeDone; ++j) {
+            Object *system = page->GetChild(j);
+            for (k = 0; (k < system->GetChildCount()) && !rangeDone; ++k) {
+                Object *object = system->GetChild(k);
+                if (object == startMeasure) inRange = true;
+                if (inRange) m_excerptObjects.push_back(object);
+                if (inRange && (object == endMeasure)) rangeDone = true;
+            }
+        }
+    }
+
+    if (!rangeDone) {
+        LogError("Measure '%s' is not after measure '%s'", endMeasure->GetUuid().c_str(),
+            startMeasure->GetUuid().c_str());
+        m_excerptObjects.clear();
+        return false;
+    }
+
+    // Get the scoreDef effective at the start of the range - only the page of the start measure is processed
+    Page *startPage = dynamic_cast<Page *>(startMeasure->GetFirstParent(PAGE));
+    assert(startPage);
+    this->CollectScoreDefs(
+        startPage->GetIdx(), startPage->GetIdx(), startPage->m_drawingScoreDef, startMeasure, &m_excerptScoreDef);
+
+    // Move the content to the excerpt page
+    m_excerptPage = new Page();
+    pages->AddChild(m_excerptPage);
+    System *contentSystem = new System();
+    m_excerptPage->AddChild(contentSystem);
+
+    m_excerptPositions.clear();
+    for (auto &object : m_excerptObjects) {
+        Object *parent = object->GetParent();
+        assert(parent);
+        int idx = parent->GetChildIndex(object);
+        m_excerptPositions.push_back(std::make_pair(parent, idx));
+        parent->DetachChild(idx);
+        object->SetParent(contentSystem);
+        contentSystem->InsertChild(object, contentSystem->GetChildCount());
+    }
+
+    this->CollectExcerptScoreDefs();
+
+    this->ResetDrawingPage();
+    this->SetDrawingPage(m_excerptPage->GetIdx());
+
+    // Without system breaks the excerpt remains on one single system
+    if (m_options->m_breaks.GetValue() == BREAKS_none) {
+        return true;
+    }
+
+    m_excerptPage->LayOutHorizontally();
+
+    m_excerptPage->DetachChild(0);
+    assert(contentSystem && !contentSystem->GetParent());
+
+    System *currentSystem = new System();
+    m_excerptPage->AddChild(currentSystem);
+    CastOffSystemsParams castOffSystemsParams(contentSystem, m_excerptPage, currentSystem);
+    castOffSystemsParams.m_systemWidth = this->m_drawingPageWidth - this->m_drawingPageMarginLeft
+        - this->m_drawingPageMarginRight - currentSystem->m_systemLeftMar - currentSystem->m_systemRightMar;
+    castOffSystemsParams.m_shift = -contentSystem->GetDrawingLabelsWidth();
+    castOffSystemsParams.m_currentScoreDefWidth
+        = m_excerptPage->m_drawingScoreDef.GetDrawingWidth() + contentSystem->GetDrawingAbbrLabelsWidth();
+
+    Functor castOffSystems(&Object::CastOffSystems);
+    Functor castOffSystemsEnd(&Object::CastOffSystemsEnd);
+    contentSystem->Process(&castOffSystems, &castOffSystemsParams, &castOffSystemsEnd);
+    delete contentSystem;
+
+    // Reset the scoreDef at the beginning of each system
+    this->CollectExcerptScoreDefs();
+
+    return true;
+}
+
+void Doc::UnCastOffExcerpt()
+{
+    if (!m_excerptPage) return;
+
+    // The measures of the excerpt are moved back to their systems
+    CancellationDeferralScope cancellationDeferralScope;
+
+    Pages *pages = this->GetPages();
+    assert(pages);
+
+    // Move the content back in reverse order for restoring the original positions
+    int i;
+    for (i = (int)m_excerptObjects.size() - 1; i >= 0; --i) {
+        Object *object = m_excerptObjects.at(i);
+        Object *parent = object->GetParent();
+        assert(parent);
+        parent->DetachChild(parent->GetChildIndex(object));
+        Object *originalParent = m_excerptPositions.at(i).first;
+        object->SetParent(originalParent);
+        originalParent->InsertChild(object, m_excerptPositions.at(i).second);
+    }
+    Page *startPage = dynamic_cast<Page *>(m_excerptObjects.front()->GetFirstParent(PAGE));
+    assert(startPage);
+    Page *endPage = dynamic_cast<Page *>(m_excerptObjects.back()->GetFirstParent(PAGE));
+    assert(endPage);
+    m_excerptObjects.clear();
+    m_excerptPositions.clear();
+
+    pages->DetachChild(m_excerptPage->GetIdx());
+    delete m_excerptPage;
+    m_excerptPage = NULL;
+
+    // This also marks the pages of the range to be laid out again
+    this->ResetDrawingPage();
+    this->CollectScoreDefs(startPage->GetIdx(), endPage->GetIdx(), startPage->m_drawingScoreDef);
+}
+
+void Doc::CollectExcerptScoreDefs()
+{
+    assert(m_excerptPage);
+
+    Functor unsetCurrentScoreDef(&Object::UnsetCurrentScoreDef);
+    m_excerptPage->Process(&unsetCurrentScoreDef, NULL);
+
+    // The scoreDef is processed as for the first page of the document
+    ScoreDef upcomingScoreDef = m_excerptScoreDef;
+    upcomingScoreDef.SetRedrawFlags(true, true, true, true, false);
+    SetCurrentScoreDefParams setCurrentScoreDefParams(this, &upcomingScoreDef);
+    setCurrentScoreDefParams.m_drawLabels = true;
+    Functor setCurrentScoreDef(&Object::SetCurrentScoreDef);
+    m_excerptPage->Process(&setCurrentScoreDef, &setCurrentScoreDefParams);
+}
+
 void Doc::CastOffRunningElements(CastOffPagesParams *params)
 {
     Pages *pages = this->GetPages();
@@ -821,9 +1516,17 @@ void Doc::CastOffRunningElements(CastOffPagesParams *params)
 
 void Doc::UnCastOffDoc()
 {
+    // The content is moved from the pages to a single content page
+    CancellationDeferralScope cancellationDeferralScope;
+
+    this->SetModified();
+
     Pages *pages = this->GetPages();
     assert(pages);
 
+    this->ResetCastOffLayout();
+    m_isCastOffPending = false;
+
     Page *contentPage = new Page();
     System *contentSystem = new System();
     contentPage->AddChild(contentSystem);
@@ -847,6 +1550,15 @@ void Doc::UnCastOffDoc()
 
 void Doc::CastOffEncodingDoc()
 {
+    TraceSpan traceSpan("CastOffEncodingDoc");
+
+    // The content is moved from the content page to the encoded pages
+    CancellationDeferralScope cancellationDeferralScope;
+
+    this->SetModified();
+
+    this->ResetCastOffLayout();
+
     this->CollectScoreDefs();
 
     Pages *pages = this->GetPages();
@@ -883,6 +1595,12 @@ void Doc::CastOffEncodingDoc()
 
 void Doc::ConvertToPageBasedDoc()
 {
+    // The content is moved from the score to the pages
+    CancellationDeferralScope cancellationDeferralScope;
+
+    this->SetModified();
+    this->SetMeasuresChanged();
+
     Score *score = this->GetScore();
     assert(score);
 
@@ -914,6 +1632,12 @@ void Doc::ConvertToCastOffMensuralDoc()
 {
     if (!m_isMensuralMusicOnly) return;
 
+    // The content is moved to new measures
+    CancellationDeferralScope cancellationDeferralScope;
+
+    this->SetModified();
+    this->SetMeasuresChanged();
+
     // We are converting to measure music in a definitiv way
     if (this->GetOptions()->m_mensuralToMeasure.GetValue()) {
         m_isMensuralMusicOnly = false;
@@ -969,6 +1693,12 @@ void Doc::ConvertToUnCastOffMensuralDoc()
 {
     if (!m_isMensuralMusicOnly) return;
 
+    // The content is moved to other measures
+    CancellationDeferralScope cancellationDeferralScope;
+
+    this->SetModified();
+    this->SetMeasuresChanged();
+
     Pages *pages = this->GetPages();
     assert(pages);
     if (pages->GetChildCount() > 1) {
@@ -1027,6 +1757,8 @@ void Doc::ConvertAnalyticalMarkupDoc(bool permanent)
 {
     if (!m_hasAnalyticalMarkup) return;
 
+    this->SetModified();
+
     LogMessage("Converting analytical markup...");
 
     /************ Prepare processing by staff/layer/verse ************/
@@ -1078,8 +1810,9 @@ void Doc::ConvertAnalyticalMarkupDoc(bool permanent)
 
 bool Doc::HasPage(int pageIdx)
 {
+    // No pages when the document is empty, e.g., after a cancelled loading
     Pages *pages = this->GetPages();
-    assert(pages);
+    if (!pages) return false;
     return ((pageIdx >= 0) && (pageIdx < pages->GetChildCount()));
 }
 
@@ -1096,7 +1829,7 @@ Pages *Doc::GetPages()
 int Doc::GetPageCount()
 {
     Pages *pages = this->GetPages();
-    assert(pages);
+    if (!pages) return 0;
     return pages->GetChildCount();
 }
 
@@ -34,12 +34,6 @@
 
 namespace vrv {
 
-//----------------------------------------------------------------------------
-// Static members
-//----------------------------------------------------------------------------
-
-std::vector<void *> FloatingObject::s_drawingObjectIds;
-
 //----------------------------------------------------------------------------
 // FloatingObject
 //----------------------------------------------------------------------------
@@ -117,18 +111,10 @@ int FloatingObject::SetDrawingGrpObject(void *drawingGrpObject)
 {
     assert(drawingGrpObject);
 
-    int idx = 0;
-    std::vector<void *>::const_iterator it
-        = std::find(s_drawingObjectIds.begin(), s_drawingObjectIds.end(), drawingGrpObject);
-    if (it == s_drawingObjectIds.end()) {
-        idx = (int)s_drawingObjectIds.size();
-        s_drawingObjectIds.push_back(drawingGrpObject);
-        // LogDebug("Creating grpId %d", idx);
-    }
-    else {
-        idx = (int)(it - s_drawingObjectIds.begin());
-        // LogDebug("Using grpId %d", idx);
-    }
+    Doc *doc = dynamic_cast<Doc *>(this->GetFirstParent(DOC));
+    assert(doc);
+
+    int idx = doc->GetDrawingGrpObjectIdx(drawingGrpObject);
     m_drawingGrpId = idx + 1000;
     return m_drawingGrpId;
 }
@@ -493,9 +479,6 @@ int FloatingObject::FillStaffCurrentTimeSpanning(FunctorParams *functorParams)
 
 int FloatingObject::ResetDrawing(FunctorParams *functorParams)
 {
-    // Clear all
-    FloatingObject::s_drawingObjectIds.clear();
-
     m_currentPositioner = NULL;
     // Pass it to the pseudo functor of the interface
     if (this->HasInterface(INTERFACE_TIME_SPANNING)) {
@@ -18,6 +18,7 @@
 #include "editorial.h"
 #include "functorparams.h"
 #include "layer.h"
+#include "memorystats.h"
 #include "note.h"
 #include "staff.h"
 #include "vrv.h"
@@ -194,4 +195,16 @@ int FTrem::ResetDrawing(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int FTrem::CalcMemoryStats(FunctorParams *functorParams)
+{
+    CalcMemoryStatsParams *params = dynamic_cast<CalcMemoryStatsParams *>(functorParams);
+    assert(params);
+
+    const ArrayOfBeamElementCoords *coords = this->GetElementCoords();
+    params->m_memoryStats->Add(MEMORY_STATS_LAYOUT, "BeamElementCoord", (int)coords->size(),
+        coords->size() * (sizeof(BeamElementCoord) + sizeof(BeamElementCoord *)));
+
+    return Object::CalcMemoryStats(functorParams);
+}
+
 } // namespace vrv
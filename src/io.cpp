@@ -57,6 +57,7 @@ FileInputStream::FileInputStream(Doc *doc) : std::ifstream()
 void FileInputStream::Init()
 {
     m_hasLayoutInformation = false;
+    m_memoryStats = NULL;
 }
 
 FileInputStream::~FileInputStream()
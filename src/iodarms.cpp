@@ -433,6 +433,8 @@ bool DarmsInput::ImportFile()
 
 bool DarmsInput::ImportString(std::string const &data_str)
 {
+    TraceSpan traceSpan("DarmsInput");
+
     int len;
     int res;
     int pos = 0;
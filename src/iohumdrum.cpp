@@ -360,6 +360,7 @@ bool HumdrumInput::ImportFile()
 
 bool HumdrumInput::ImportString(std::string const &content)
 {
+    TraceSpan traceSpan("HumdrumInput");
 
 #ifndef NO_HUMDRUM_SUPPORT
     try {
@@ -49,6 +49,7 @@
 #include "ligature.h"
 #include "mdiv.h"
 #include "measure.h"
+#include "memorystats.h"
 #include "mensur.h"
 #include "metersig.h"
 #include "mnum.h"
@@ -95,7 +96,7 @@
 
 namespace vrv {
 
-std::vector<std::string> MeiInput::s_editorialElementNames = { "abbr", "add", "app", "annot", "choice", "corr",
+const std::vector<std::string> MeiInput::s_editorialElementNames = { "abbr", "add", "app", "annot", "choice", "corr",
     "damage", "del", "expan", "orig", "ref", "reg", "restore", "sic", "supplied", "unclear" };
 
 //----------------------------------------------------------------------------
@@ -1944,11 +1945,13 @@ bool MeiInput::ImportFile()
 
 bool MeiInput::ImportString(std::string const &mei)
 {
+    TraceSpan traceSpan("MeiInput");
     try {
         m_doc->Reset();
         m_doc->SetType(Raw);
         pugi::xml_document doc;
         doc.load(mei.c_str(), pugi::parse_default & ~pugi::parse_eol);
+        if (m_memoryStats) m_memoryStats->SetXml("MeiInput", doc);
         pugi::xml_node root = doc.first_child();
         return ReadDoc(root);
     }
@@ -2375,6 +2378,10 @@ bool MeiInput::ReadMdivChildren(Object *parent, pugi::xml_node parentNode, bool
         bool makeVisible = (isVisible || (m_selectedMdiv == current));
         if (!success) break;
         if (std::string(current.name()) == "mdiv") {
+            // Do not build the <mdiv> if only the selected one is loaded
+            if (!isVisible && m_doc->GetOptions()->m_mdivSelectedOnly.GetValue() && !IsSelectedMdiv(current)) {
+                continue;
+            }
             success = ReadMdiv(parent, current, makeVisible);
         }
         else if (std::string(current.name()) == "pages") {
@@ -4988,6 +4995,15 @@ std::wstring MeiInput::RightTrim(std::wstring str)
     return str;
 }
 
+bool MeiInput::IsSelectedMdiv(pugi::xml_node mdiv)
+{
+    pugi::xml_node current;
+    for (current = m_selectedMdiv; current; current = current.parent()) {
+        if (current == mdiv) return true;
+    }
+    return false;
+}
+
 bool MeiInput::IsEditorialElementName(std::string elementName)
 {
     auto i = std::find(MeiInput::s_editorialElementNames.begin(), MeiInput::s_editorialElementNames.end(), elementName);
@@ -33,6 +33,7 @@
 #include "layer.h"
 #include "mdiv.h"
 #include "measure.h"
+#include "memorystats.h"
 #include "mordent.h"
 #include "mrest.h"
 #include "mrpt.h"
@@ -94,11 +95,13 @@ bool MusicXmlInput::ImportFile()
 
 bool MusicXmlInput::ImportString(std::string const &musicxml)
 {
+    TraceSpan traceSpan("MusicXmlInput");
     try {
         m_doc->Reset();
         m_doc->SetType(Raw);
         pugi::xml_document xmlDoc;
         xmlDoc.load(musicxml.c_str());
+        if (m_memoryStats) m_memoryStats->SetXml("MusicXmlInput", xmlDoc);
         pugi::xml_node root = xmlDoc.first_child();
         return ReadMusicXml(root);
     }
@@ -289,7 +292,7 @@ void MusicXmlInput::FillSpace(Layer *layer, int dur)
 
 void MusicXmlInput::GenerateUuid(pugi::xml_node node)
 {
-    int nr = std::rand();
+    int nr = Object::GenerateUuidNumber();
     char str[17];
     // I do not want to use a stream for doing this!
     snprintf(str, 17, "%016d", nr);
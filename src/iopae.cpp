@@ -101,6 +101,7 @@ bool PaeInput::ImportFile()
 
 bool PaeInput::ImportString(std::string const &pae)
 {
+    TraceSpan traceSpan("PaeInput");
     std::istringstream in_stream(pae);
     parsePlainAndEasy(in_stream);
     return true;
@@ -0,0 +1,1480 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        iosnapshot.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "iosnapshot.h"
+
+//----------------------------------------------------------------------------
+
+#include <assert.h>
+#include <fstream>
+#include <sstream>
+#include <string.h>
+
+//----------------------------------------------------------------------------
+
+#include "accid.h"
+#include "anchoredtext.h"
+#include "annot.h"
+#include "arpeg.h"
+#include "artic.h"
+#include "barline.h"
+#include "beam.h"
+#include "beatrpt.h"
+#include "boundary.h"
+#include "breath.h"
+#include "btrem.h"
+#include "chord.h"
+#include "clef.h"
+#include "controlelement.h"
+#include "custos.h"
+#include "dir.h"
+#include "doc.h"
+#include "dot.h"
+#include "dynam.h"
+#include "editorial.h"
+#include "elementpart.h"
+#include "ending.h"
+#include "expansion.h"
+#include "fb.h"
+#include "fermata.h"
+#include "fig.h"
+#include "ftrem.h"
+#include "hairpin.h"
+#include "harm.h"
+#include "instrdef.h"
+#include "keysig.h"
+#include "label.h"
+#include "labelabbr.h"
+#include "layer.h"
+#include "layerelement.h"
+#include "lb.h"
+#include "ligature.h"
+#include "mdiv.h"
+#include "measure.h"
+#include "memorystats.h"
+#include "mensur.h"
+#include "metersig.h"
+#include "mnum.h"
+#include "mordent.h"
+#include "mrest.h"
+#include "mrpt.h"
+#include "mrpt2.h"
+#include "multirest.h"
+#include "multirpt.h"
+#include "note.h"
+#include "num.h"
+#include "octave.h"
+#include "page.h"
+#include "pages.h"
+#include "pb.h"
+#include "pedal.h"
+#include "pgfoot.h"
+#include "pgfoot2.h"
+#include "pghead.h"
+#include "pghead2.h"
+#include "plistinterface.h"
+#include "proport.h"
+#include "ref.h"
+#include "rend.h"
+#include "rest.h"
+#include "runningelement.h"
+#include "sb.h"
+#include "score.h"
+#include "scoredef.h"
+#include "section.h"
+#include "slur.h"
+#include "space.h"
+#include "staff.h"
+#include "staffdef.h"
+#include "staffgrp.h"
+#include "svg.h"
+#include "syl.h"
+#include "system.h"
+#include "systemelement.h"
+#include "tempo.h"
+#include "text.h"
+#include "textelement.h"
+#include "tie.h"
+#include "timeinterface.h"
+#include "timestamp.h"
+#include "trill.h"
+#include "tuplet.h"
+#include "turn.h"
+#include "verse.h"
+#include "vrv.h"
+
+//----------------------------------------------------------------------------
+
+#include "pugixml.hpp"
+
+namespace vrv {
+
+// The magic string at the beginning of a snapshot
+static const char SNAPSHOT_MAGIC[] = "VRVSNAP";
+// The version of the snapshot format - to be increased when it changes
+static const uint64_t SNAPSHOT_FORMAT_VERSION = 2;
+
+//----------------------------------------------------------------------------
+// SnapshotCache
+//----------------------------------------------------------------------------
+
+void SnapshotCache::Synchronize(int measureGeneration)
+{
+    if (measureGeneration == m_measureGeneration) return;
+
+    m_measures.clear();
+    m_measureGeneration = measureGeneration;
+}
+
+void SnapshotCache::Invalidate(Object *object)
+{
+    assert(object);
+
+    Object *measure = (object->Is(MEASURE)) ? object : object->GetFirstParent(MEASURE);
+    if (measure) m_measures.erase(measure->GetUuid());
+}
+
+const SnapshotCacheEntry *SnapshotCache::GetMeasure(Object *measure) const
+{
+    assert(measure);
+
+    std::map<std::string, SnapshotCacheEntry>::const_iterator iter = m_measures.find(measure->GetUuid());
+    if (iter == m_measures.end()) return NULL;
+    return &iter->second;
+}
+
+const SnapshotCacheEntry *SnapshotCache::SetMeasure(Object *measure, const SnapshotCacheEntry &entry)
+{
+    assert(measure);
+
+    SnapshotCacheEntry *cached = &m_measures[measure->GetUuid()];
+    *cached = entry;
+    return cached;
+}
+
+size_t SnapshotCache::GetMemorySize() const
+{
+    size_t bytes = 0;
+    for (auto &measure : m_measures) {
+        bytes += MEMORY_STATS_NODE_SIZE + sizeof(measure) + measure.first.capacity() + measure.second.m_data.capacity();
+    }
+    return bytes;
+}
+
+//----------------------------------------------------------------------------
+// SnapshotOutput
+//----------------------------------------------------------------------------
+
+SnapshotOutput::SnapshotOutput(Doc *doc, std::string filename) : FileOutputStream(doc)
+{
+    m_filename = filename;
+    m_cache = NULL;
+    m_castOffPages = false;
+    m_optionsHash = 0;
+    m_prepared = false;
+    m_objectCount = 0;
+}
+
+SnapshotOutput::~SnapshotOutput() {}
+
+void SnapshotOutput::SetCastOffPages(bool castOffPages, uint64_t optionsHash)
+{
+    m_castOffPages = castOffPages;
+    m_optionsHash = (castOffPages) ? optionsHash : 0;
+}
+
+bool SnapshotOutput::ExportFile()
+{
+    if (!this->WriteDoc()) return false;
+
+    std::ofstream output(m_filename.c_str(), std::ios::out | std::ios::binary);
+    if (!output.is_open()) {
+        LogError("Unable to open the snapshot file '%s'", m_filename.c_str());
+        return false;
+    }
+    output.write(m_output.data(), m_output.size());
+    return true;
+}
+
+std::string SnapshotOutput::GetOutput()
+{
+    if (!this->WriteDoc()) return "";
+
+    return m_output;
+}
+
+bool SnapshotOutput::WriteDoc()
+{
+    m_output.clear();
+    m_objectCount = 0;
+    m_objectIndexes.clear();
+    m_indexedObjects.clear();
+    m_sharedStrings.clear();
+
+    if (m_doc->GetType() == Transcription) {
+        LogError("Snapshots are not supported for transcription documents");
+        return false;
+    }
+    if (m_doc->IsMensuralMusicOnly()) {
+        LogError("Snapshots are not supported for mensural music documents that are not cast off");
+        return false;
+    }
+
+    m_prepared = m_doc->IsDrawingPreparationDone();
+    if (m_cache && m_prepared) m_cache->Synchronize(m_doc->GetMeasureGeneration());
+
+    m_output.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    this->WriteUInt(SNAPSHOT_FORMAT_VERSION);
+    this->WriteString(GetVersion());
+    int docFlags = 0;
+    if (m_castOffPages) docFlags |= SNAPSHOT_DOC_CAST_OFF_PAGES;
+    // Page breaks are what make the MEI input have layout information
+    if (m_doc->FindChildByType(PB)) docFlags |= SNAPSHOT_DOC_LAYOUT_INFORMATION;
+    if (m_prepared) docFlags |= SNAPSHOT_DOC_PREPARED;
+    this->WriteUInt(docFlags);
+    this->WriteUInt(m_optionsHash);
+
+    this->WriteUInt(m_doc->GetType());
+    std::ostringstream header;
+    m_doc->m_header.print(header, "", pugi::format_raw);
+    this->WriteString(header.str());
+
+    if (!this->WriteObject(&m_doc->m_scoreDef)) return false;
+
+    this->WriteUInt(m_doc->GetChildCount());
+    int i;
+    for (i = 0; i < m_doc->GetChildCount(); ++i) {
+        if (!this->WriteObject(m_doc->GetChild(i))) return false;
+    }
+
+    if (m_prepared && !this->WritePreparedValues()) return false;
+
+    return true;
+}
+
+bool SnapshotOutput::WriteObject(Object *object, const ArrayOfObjects *children)
+{
+    assert(object);
+
+    if (!m_castOffPages && object->Is(PAGES) && !children) {
+        return this->WriteContentPages(object);
+    }
+
+    this->WriteUInt(object->GetClassId());
+
+    if (object->Is(MEASURE)) {
+        assert(!children);
+        return this->WriteMeasureChunk(object);
+    }
+
+    return this->WriteObjectRecord(object, children);
+}
+
+bool SnapshotOutput::WriteObjectRecord(Object *object, const ArrayOfObjects *children)
+{
+    assert(object);
+
+    if (!this->WriteObjectContent(object)) return false;
+
+    ArrayOfObjects objectChildren;
+    if (!children) {
+        this->GetChildrenToWrite(object, objectChildren);
+        children = &objectChildren;
+    }
+
+    this->WriteUInt(children->size());
+    for (auto &child : *children) {
+        if (!this->WriteObject(child)) return false;
+    }
+
+    return true;
+}
+
+bool SnapshotOutput::WriteMeasureChunk(Object *measure)
+{
+    assert(measure);
+
+    // Only the measures of prepared documents are cached since the other ones are written without the element parts
+    SnapshotCache *cache = (m_prepared) ? m_cache : NULL;
+    const SnapshotCacheEntry *entry = (cache) ? cache->GetMeasure(measure) : NULL;
+    SnapshotCacheEntry encoded;
+
+    if (entry) {
+        // The objects of the measure are indexed as they were when encoding it
+        int objectCount = m_objectCount;
+        this->IndexObjects(measure);
+        if (m_objectCount - objectCount != entry->m_objectCount) {
+            LogError("The measure '%s' in the snapshot cache is not up to date", measure->GetUuid().c_str());
+            return false;
+        }
+    }
+    else {
+        // The measure is written with its own shared strings for making it independent from the rest of the snapshot
+        std::map<std::string, int> sharedStrings;
+        int objectCount = m_objectCount;
+        m_output.swap(encoded.m_data);
+        m_sharedStrings.swap(sharedStrings);
+        bool success = this->WriteObjectRecord(measure);
+        m_output.swap(encoded.m_data);
+        m_sharedStrings.swap(sharedStrings);
+        if (!success) return false;
+
+        encoded.m_objectCount = m_objectCount - objectCount;
+        entry = (cache) ? cache->SetMeasure(measure, encoded) : &encoded;
+    }
+
+    this->WriteUInt(entry->m_data.size());
+    m_output.append(entry->m_data);
+
+    return true;
+}
+
+void SnapshotOutput::IndexObjects(Object *object)
+{
+    assert(object);
+
+    m_objectIndexes[object] = m_objectCount;
+    m_indexedObjects.push_back(object);
+    ++m_objectCount;
+
+    ArrayOfObjects children;
+    this->GetChildrenToWrite(object, children);
+    for (auto &child : children) {
+        this->IndexObjects(child);
+    }
+}
+
+void SnapshotOutput::GetChildrenToWrite(Object *object, ArrayOfObjects &children)
+{
+    assert(object);
+
+    int i;
+    for (i = 0; i < object->GetChildCount(); ++i) {
+        Object *child = object->GetChild(i);
+        // The element parts are not written when the document is not prepared because they are added by
+        // Doc::PrepareDrawing when loading it
+        if (!m_prepared && child->Is({ ARTIC_PART, DOTS, FLAG, STEM })) continue;
+        // The dots and the stems are added to the front of the children when reading them (see Note::AddChild), so
+        // they are written first in reverse order
+        if (child->Is({ DOTS, STEM })) {
+            children.insert(children.begin(), child);
+        }
+        else {
+            children.push_back(child);
+        }
+    }
+}
+
+bool SnapshotOutput::WriteContentPages(Object *pages)
+{
+    assert(pages);
+
+    // Gather the systems of all the pages and their content as it would be in the content page
+    ArrayOfObjects systems;
+    ArrayOfObjects content;
+    int i, j;
+    for (i = 0; i < pages->GetChildCount(); ++i) {
+        Object *page = pages->GetChild(i);
+        for (j = 0; j < page->GetChildCount(); ++j) {
+            Object *system = page->GetChild(j);
+            assert(system->Is(SYSTEM));
+            systems.push_back(system);
+            for (int k = 0; k < system->GetChildCount(); ++k) content.push_back(system->GetChild(k));
+        }
+    }
+
+    // Nothing to gather
+    if (systems.empty()) {
+        ArrayOfObjects pageChildren;
+        for (i = 0; i < pages->GetChildCount(); ++i) pageChildren.push_back(pages->GetChild(i));
+        return this->WriteObject(pages, &pageChildren);
+    }
+
+    // The first page and the first system are used for the content page and the content system
+    this->WriteUInt(pages->GetClassId());
+    if (!this->WriteObjectContent(pages)) return false;
+    this->WriteUInt(1);
+    this->WriteUInt(PAGE);
+    if (!this->WriteObjectContent(systems.front()->GetParent())) return false;
+    this->WriteUInt(1);
+    return this->WriteObject(systems.front(), &content);
+}
+
+bool SnapshotOutput::WriteObjectContent(Object *object)
+{
+    assert(object);
+
+    m_objectIndexes[object] = m_objectCount;
+    m_indexedObjects.push_back(object);
+    ++m_objectCount;
+
+    int flags = 0;
+    if (object->IsAttribute()) flags |= SNAPSHOT_OBJECT_ATTRIBUTE;
+    if (object->HasComment()) flags |= SNAPSHOT_OBJECT_COMMENT;
+    if (object->IsEditorialElement()) {
+        EditorialElement *editorialElement = dynamic_cast<EditorialElement *>(object);
+        assert(editorialElement);
+        if (editorialElement->m_visibility == Hidden) flags |= SNAPSHOT_OBJECT_HIDDEN;
+    }
+    else if (object->Is(MDIV)) {
+        Mdiv *mdiv = dynamic_cast<Mdiv *>(object);
+        assert(mdiv);
+        if (mdiv->m_visibility == Hidden) flags |= SNAPSHOT_OBJECT_HIDDEN;
+    }
+    else if (object->Is(MEASURE)) {
+        Measure *measure = dynamic_cast<Measure *>(object);
+        assert(measure);
+        if (!measure->IsMeasuredMusic()) flags |= SNAPSHOT_OBJECT_UNMEASURED;
+    }
+    else if (object->Is(MNUM)) {
+        MNum *mNum = dynamic_cast<MNum *>(object);
+        assert(mNum);
+        if (mNum->IsGenerated()) flags |= SNAPSHOT_OBJECT_GENERATED;
+    }
+    else if (object->IsRunningElement()) {
+        RunningElement *runningElement = dynamic_cast<RunningElement *>(object);
+        assert(runningElement);
+        if (runningElement->IsGenerated()) flags |= SNAPSHOT_OBJECT_GENERATED;
+    }
+
+    this->WriteUInt(flags);
+
+    // The start of a boundary end is needed for creating it
+    if (object->Is(BOUNDARY_END)) {
+        BoundaryEnd *boundaryEnd = dynamic_cast<BoundaryEnd *>(object);
+        assert(boundaryEnd);
+        std::unordered_map<Object *, int>::iterator iter = m_objectIndexes.find(boundaryEnd->GetStart());
+        if (iter == m_objectIndexes.end()) {
+            LogError("The start of the boundary end '%s' is not in the snapshot", object->GetUuid().c_str());
+            return false;
+        }
+        this->WriteUInt(iter->second);
+    }
+    // The level of app and choice is needed for creating them
+    else if (object->Is(APP)) {
+        App *app = dynamic_cast<App *>(object);
+        assert(app);
+        this->WriteUInt(app->GetLevel());
+    }
+    else if (object->Is(CHOICE)) {
+        Choice *choice = dynamic_cast<Choice *>(object);
+        assert(choice);
+        this->WriteUInt(choice->GetLevel());
+    }
+    // The type of an artic part is needed for creating it
+    else if (object->Is(ARTIC_PART)) {
+        ArticPart *articPart = dynamic_cast<ArticPart *>(object);
+        assert(articPart);
+        this->WriteUInt(articPart->GetType());
+    }
+
+    this->WriteString(object->GetUuid());
+    if (flags & SNAPSHOT_OBJECT_COMMENT) this->WriteString(object->GetComment());
+
+    ArrayOfStrAttr attributes;
+    object->GetAttributes(&attributes);
+    this->WriteUInt(attributes.size());
+    for (auto &attribute : attributes) {
+        this->WriteSharedString(attribute.first);
+        this->WriteSharedString(attribute.second);
+    }
+
+    // Values that are not attributes
+    if (object->Is(PAGE)) {
+        Page *page = dynamic_cast<Page *>(object);
+        assert(page);
+        this->WriteInt(page->m_pageHeight);
+        this->WriteInt(page->m_pageWidth);
+        this->WriteInt(page->m_pageMarginBottom);
+        this->WriteInt(page->m_pageMarginLeft);
+        this->WriteInt(page->m_pageMarginRight);
+        this->WriteInt(page->m_pageMarginTop);
+        this->WriteString(page->m_surface);
+        this->WriteDouble(page->GetPPUFactor());
+    }
+    else if (object->Is(SYSTEM)) {
+        System *system = dynamic_cast<System *>(object);
+        assert(system);
+        this->WriteInt(system->m_systemLeftMar);
+        this->WriteInt(system->m_systemRightMar);
+        this->WriteInt(system->m_yAbs);
+    }
+    else if (object->Is(MEASURE)) {
+        Measure *measure = dynamic_cast<Measure *>(object);
+        assert(measure);
+        // The duration of the measure is needed for the timemap when the pages are not laid out again
+        this->WriteDouble(measure->m_measureAligner.GetMaxTime());
+    }
+    else if (object->Is(TEXT)) {
+        Text *text = dynamic_cast<Text *>(object);
+        assert(text);
+        this->WriteString(UTF16to8(text->GetText()));
+    }
+    else if (object->Is(ANNOT)) {
+        Annot *annot = dynamic_cast<Annot *>(object);
+        assert(annot);
+        std::ostringstream content;
+        annot->m_content.print(content, "", pugi::format_raw);
+        this->WriteString(content.str());
+    }
+    else if (object->Is(SVG)) {
+        Svg *svg = dynamic_cast<Svg *>(object);
+        assert(svg);
+        std::ostringstream content;
+        svg->Get().print(content, "", pugi::format_raw);
+        this->WriteString(content.str());
+    }
+
+    return true;
+}
+
+bool SnapshotOutput::WritePreparedValues()
+{
+    int previousIndex = -1;
+    int index;
+    for (index = 0; index < (int)m_indexedObjects.size(); ++index) {
+        Object *object = m_indexedObjects.at(index);
+
+        TimePointInterface *timePoint = object->GetTimePointInterface();
+        TimeSpanningInterface *timeSpanning = object->GetTimeSpanningInterface();
+        PlistInterface *plist = object->GetPlistInterface();
+        LayerElement *element = NULL;
+        FloatingObject *floatingObject = NULL;
+        BoundaryStartInterface *boundaryStart = NULL;
+
+        int flags = 0;
+        if (timePoint && timePoint->GetStart()) flags |= SNAPSHOT_PREPARED_START;
+        if (timeSpanning && timeSpanning->GetEnd()) flags |= SNAPSHOT_PREPARED_END;
+        if (plist && !plist->GetRefs()->empty()) flags |= SNAPSHOT_PREPARED_REFERENCES;
+        if (object->IsLayerElement()) {
+            element = dynamic_cast<LayerElement *>(object);
+            assert(element);
+            if (element->m_crossStaff || element->m_crossLayer) flags |= SNAPSHOT_PREPARED_CROSS_STAFF;
+            if (element->GetDrawingCueSize()) flags |= SNAPSHOT_PREPARED_CUE_SIZE;
+            StemmedDrawingInterface *stemmed = object->GetStemmedDrawingInterface();
+            if (stemmed && stemmed->GetDrawingStem()) flags |= SNAPSHOT_PREPARED_STEM;
+            if (object->Is(DOT)) {
+                Dot *dot = dynamic_cast<Dot *>(object);
+                assert(dot);
+                if (dot->m_drawingNote || dot->m_drawingNextElement) flags |= SNAPSHOT_PREPARED_DOT;
+            }
+            else if (object->Is(SYL)) {
+                Syl *syl = dynamic_cast<Syl *>(object);
+                assert(syl);
+                if (syl->m_drawingVerse != 1) flags |= SNAPSHOT_PREPARED_VERSE;
+            }
+            else if (object->Is(MRPT)) {
+                MRpt *mRpt = dynamic_cast<MRpt *>(object);
+                assert(mRpt);
+                if (mRpt->m_drawingMeasureCount != 0) flags |= SNAPSHOT_PREPARED_MEASURE_COUNT;
+            }
+        }
+        if (object->IsControlElement() || object->IsSystemElement()) {
+            floatingObject = dynamic_cast<FloatingObject *>(object);
+            assert(floatingObject);
+            if (floatingObject->GetDrawingGrpId() != 0) flags |= SNAPSHOT_PREPARED_GRP_ID;
+            if (object->Is(HAIRPIN)) {
+                Hairpin *hairpin = dynamic_cast<Hairpin *>(object);
+                assert(hairpin);
+                if (hairpin->GetLeftLink() || hairpin->GetRightLink()) flags |= SNAPSHOT_PREPARED_LINKS;
+            }
+        }
+        if (object->Is({ ENDING, SECTION }) || object->IsEditorialElement()) {
+            boundaryStart = dynamic_cast<BoundaryStartInterface *>(object);
+            assert(boundaryStart);
+            if (boundaryStart->GetMeasure()) flags |= SNAPSHOT_PREPARED_MEASURE;
+        }
+        else if (object->Is(BOUNDARY_END)) {
+            BoundaryEnd *boundaryEnd = dynamic_cast<BoundaryEnd *>(object);
+            assert(boundaryEnd);
+            if (boundaryEnd->GetMeasure()) flags |= SNAPSHOT_PREPARED_MEASURE;
+        }
+        else if (object->Is(MEASURE)) {
+            Measure *measure = dynamic_cast<Measure *>(object);
+            assert(measure);
+            if (measure->GetDrawingEnding()) flags |= SNAPSHOT_PREPARED_ENDING;
+            if (measure->IsContentDone()) flags |= SNAPSHOT_PREPARED_CONTENT;
+        }
+        else if (object->Is(STAFF)) {
+            Staff *staff = dynamic_cast<Staff *>(object);
+            assert(staff);
+            if (!staff->m_timeSpanningElements.empty()) flags |= SNAPSHOT_PREPARED_TIME_SPANNING;
+        }
+
+        if (flags == 0) continue;
+
+        this->WriteUInt(index - previousIndex);
+        previousIndex = index;
+        this->WriteUInt(flags);
+
+        bool success = true;
+        if (flags & SNAPSHOT_PREPARED_START) success = success && this->WriteReference(timePoint->GetStart());
+        if (flags & SNAPSHOT_PREPARED_END) success = success && this->WriteReference(timeSpanning->GetEnd());
+        if (flags & SNAPSHOT_PREPARED_REFERENCES) {
+            this->WriteUInt(plist->GetRefs()->size());
+            for (auto &reference : *plist->GetRefs()) success = success && this->WriteReference(reference);
+        }
+        if (flags & SNAPSHOT_PREPARED_CROSS_STAFF) {
+            success = success && this->WriteReference(element->m_crossStaff);
+            success = success && this->WriteReference(element->m_crossLayer);
+        }
+        if (flags & SNAPSHOT_PREPARED_STEM) {
+            success = success && this->WriteReference(object->GetStemmedDrawingInterface()->GetDrawingStem());
+        }
+        if (flags & SNAPSHOT_PREPARED_DOT) {
+            Dot *dot = dynamic_cast<Dot *>(object);
+            assert(dot);
+            success = success && this->WriteReference(dot->m_drawingNote);
+            success = success && this->WriteReference(dot->m_drawingNextElement);
+        }
+        if (flags & SNAPSHOT_PREPARED_VERSE) {
+            Syl *syl = dynamic_cast<Syl *>(object);
+            assert(syl);
+            this->WriteInt(syl->m_drawingVerse);
+        }
+        if (flags & SNAPSHOT_PREPARED_MEASURE_COUNT) {
+            MRpt *mRpt = dynamic_cast<MRpt *>(object);
+            assert(mRpt);
+            this->WriteInt(mRpt->m_drawingMeasureCount);
+        }
+        if (flags & SNAPSHOT_PREPARED_MEASURE) {
+            if (boundaryStart) {
+                success = success && this->WriteReference(boundaryStart->GetMeasure());
+            }
+            else {
+                BoundaryEnd *boundaryEnd = dynamic_cast<BoundaryEnd *>(object);
+                assert(boundaryEnd);
+                success = success && this->WriteReference(boundaryEnd->GetMeasure());
+            }
+        }
+        if (flags & SNAPSHOT_PREPARED_ENDING) {
+            Measure *measure = dynamic_cast<Measure *>(object);
+            assert(measure);
+            success = success && this->WriteReference(measure->GetDrawingEnding());
+        }
+        if (flags & SNAPSHOT_PREPARED_GRP_ID) this->WriteInt(floatingObject->GetDrawingGrpId());
+        if (flags & SNAPSHOT_PREPARED_LINKS) {
+            Hairpin *hairpin = dynamic_cast<Hairpin *>(object);
+            assert(hairpin);
+            success = success && this->WriteReference(hairpin->GetLeftLink());
+            success = success && this->WriteReference(hairpin->GetRightLink());
+        }
+        if (flags & SNAPSHOT_PREPARED_TIME_SPANNING) {
+            Staff *staff = dynamic_cast<Staff *>(object);
+            assert(staff);
+            this->WriteUInt(staff->m_timeSpanningElements.size());
+            for (auto &timeSpanningElement : staff->m_timeSpanningElements) {
+                success = success && this->WriteReference(timeSpanningElement);
+            }
+        }
+        if (flags & SNAPSHOT_PREPARED_CONTENT) {
+            Measure *measure = dynamic_cast<Measure *>(object);
+            assert(measure);
+            const std::bitset<UNSPECIFIED> &contentClassIds = measure->GetContentClassIds();
+            this->WriteUInt(contentClassIds.count());
+            int classId;
+            for (classId = 0; classId < UNSPECIFIED; ++classId) {
+                if (contentClassIds.test(classId)) this->WriteUInt(classId);
+            }
+            this->WriteUInt(measure->HasCrossStaffContent());
+        }
+
+        if (!success) {
+            LogError(
+                "A drawing value of '%s' points to an object that is not in the snapshot", object->GetUuid().c_str());
+            return false;
+        }
+    }
+    this->WriteUInt(0);
+
+    return true;
+}
+
+bool SnapshotOutput::WriteReference(Object *object)
+{
+    if (!object) {
+        this->WriteUInt(0);
+        return true;
+    }
+
+    // The timestamps are not in the tree and are created again in the timestamp aligner of their measure
+    if (object->Is(TIMESTAMP_ATTR)) {
+        TimestampAttr *timestampAttr = dynamic_cast<TimestampAttr *>(object);
+        assert(timestampAttr);
+        std::unordered_map<Object *, int>::iterator iter = m_objectIndexes.find(object->GetFirstParent(MEASURE));
+        if (iter == m_objectIndexes.end()) return false;
+        this->WriteUInt(2 * ((uint64_t)iter->second + 1));
+        this->WriteDouble(timestampAttr->GetActualDurPos());
+        return true;
+    }
+
+    std::unordered_map<Object *, int>::iterator iter = m_objectIndexes.find(object);
+    if (iter == m_objectIndexes.end()) return false;
+    this->WriteUInt(2 * (uint64_t)iter->second + 1);
+    return true;
+}
+
+void SnapshotOutput::WriteUInt(uint64_t value)
+{
+    // Variable-length encoding with 7 bits per byte
+    while (value >= 0x80) {
+        m_output.push_back((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    m_output.push_back((char)value);
+}
+
+void SnapshotOutput::WriteInt(int64_t value)
+{
+    // Zigzag encoding for having small negative values written with few bytes
+    this->WriteUInt(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void SnapshotOutput::WriteDouble(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int i;
+    for (i = 0; i < 8; ++i) {
+        m_output.push_back((char)((bits >> (8 * i)) & 0xFF));
+    }
+}
+
+void SnapshotOutput::WriteString(const std::string &value)
+{
+    this->WriteUInt(value.size());
+    m_output.append(value);
+}
+
+void SnapshotOutput::WriteSharedString(const std::string &value)
+{
+    // A shared string is written the first time with 0 and then with its index + 1
+    std::map<std::string, int>::iterator iter = m_sharedStrings.find(value);
+    if (iter != m_sharedStrings.end()) {
+        this->WriteUInt(iter->second + 1);
+        return;
+    }
+    int index = (int)m_sharedStrings.size();
+    m_sharedStrings[value] = index;
+    this->WriteUInt(0);
+    this->WriteString(value);
+}
+
+//----------------------------------------------------------------------------
+// SnapshotInput
+//----------------------------------------------------------------------------
+
+SnapshotInput::SnapshotInput(Doc *doc, std::string filename) : FileInputStream(doc)
+{
+    m_filename = filename;
+    m_input = NULL;
+    m_position = 0;
+    m_optionsHash = 0;
+    m_hasCastOffPages = false;
+    m_isPrepared = false;
+    m_flattenPages = false;
+}
+
+SnapshotInput::~SnapshotInput() {}
+
+bool SnapshotInput::IsSnapshot(const std::string &data)
+{
+    return ((data.size() >= sizeof(SNAPSHOT_MAGIC))
+        && (memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0));
+}
+
+bool SnapshotInput::ImportFile()
+{
+    std::ifstream input(m_filename.c_str(), std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        LogError("Unable to open the snapshot file '%s'", m_filename.c_str());
+        return false;
+    }
+    std::string snapshot((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    return this->ImportString(snapshot);
+}
+
+bool SnapshotInput::ImportString(std::string const &snapshot)
+{
+    TraceSpan traceSpan("SnapshotInput");
+
+    m_doc->Reset();
+    m_doc->SetType(Raw);
+
+    m_input = &snapshot;
+    m_position = 0;
+    m_hasCastOffPages = false;
+    m_isPrepared = false;
+    m_flattenPages = false;
+    m_objects.clear();
+    m_sharedStrings.clear();
+    m_sharedStringIds.clear();
+    m_stringIds.clear();
+    m_attSetters.clear();
+
+    bool success = this->ReadDoc();
+    if (!success) {
+        LogError("The snapshot could not be read");
+        m_doc->Reset();
+        m_isPrepared = false;
+    }
+
+    m_input = NULL;
+    m_objects.clear();
+    m_sharedStrings.clear();
+    m_sharedStringIds.clear();
+    m_stringIds.clear();
+    m_attSetters.clear();
+
+    return success;
+}
+
+bool SnapshotInput::ReadDoc()
+{
+    if (!IsSnapshot(*m_input)) {
+        LogError("The data is not a snapshot");
+        return false;
+    }
+    m_position = sizeof(SNAPSHOT_MAGIC);
+
+    uint64_t formatVersion;
+    std::string version;
+    if (!this->ReadUInt(formatVersion) || !this->ReadString(version)) return false;
+    if ((formatVersion != SNAPSHOT_FORMAT_VERSION) || (version != GetVersion())) {
+        LogError("The snapshot was written by another version of Verovio (%s)", version.c_str());
+        return false;
+    }
+
+    uint64_t docFlags, optionsHash;
+    if (!this->ReadUInt(docFlags) || !this->ReadUInt(optionsHash)) return false;
+    if (docFlags & SNAPSHOT_DOC_LAYOUT_INFORMATION) m_hasLayoutInformation = true;
+    if (docFlags & SNAPSHOT_DOC_CAST_OFF_PAGES) {
+        m_hasCastOffPages = (optionsHash == m_optionsHash);
+        // The pages were cast off with other options and need to be cast off again
+        m_flattenPages = !m_hasCastOffPages;
+    }
+
+    uint64_t type;
+    std::string header;
+    if (!this->ReadUInt(type) || !this->ReadString(header)) return false;
+    m_doc->SetType((DocType)type);
+    if (!header.empty()) {
+        m_doc->m_header.load_buffer(header.data(), header.size());
+    }
+
+    // The scoreDef of the document is read into the existing one
+    uint64_t classId, flags;
+    if (!this->ReadUInt(classId) || !this->ReadUInt(flags)) return false;
+    if (classId != SCOREDEF) return false;
+    m_objects.push_back(&m_doc->m_scoreDef);
+    if (!this->ReadObjectContent(&m_doc->m_scoreDef, (int)flags)) return false;
+    uint64_t childCount;
+    if (!this->ReadUInt(childCount)) return false;
+    for (uint64_t i = 0; i < childCount; ++i) {
+        if (!this->ReadObject(&m_doc->m_scoreDef)) return false;
+    }
+
+    if (!this->ReadUInt(childCount)) return false;
+    for (uint64_t i = 0; i < childCount; ++i) {
+        if (!this->ReadObject(m_doc)) return false;
+    }
+
+    if (docFlags & SNAPSHOT_DOC_PREPARED) {
+        if (!this->ReadPreparedValues()) return false;
+        m_doc->SetDrawingPreparationDone();
+        m_isPrepared = true;
+    }
+
+    if (m_position != m_input->size()) {
+        LogError("Unexpected data at the end of the snapshot");
+        return false;
+    }
+
+    return true;
+}
+
+bool SnapshotInput::ReadObject(Object *parent)
+{
+    assert(parent);
+
+    uint64_t classId;
+    if (!this->ReadUInt(classId)) return false;
+
+    if (classId == MEASURE) return this->ReadMeasureChunk(parent);
+
+    return this->ReadObjectRecord(parent, (ClassId)classId);
+}
+
+bool SnapshotInput::ReadMeasureChunk(Object *parent)
+{
+    assert(parent);
+
+    uint64_t size;
+    if (!this->ReadUInt(size) || (size > m_input->size() - m_position)) return false;
+    size_t end = m_position + size;
+
+    // The measure has its own shared strings
+    std::vector<std::string> sharedStrings;
+    std::vector<int> sharedStringIds;
+    m_sharedStrings.swap(sharedStrings);
+    m_sharedStringIds.swap(sharedStringIds);
+    bool success = this->ReadObjectRecord(parent, MEASURE);
+    m_sharedStrings.swap(sharedStrings);
+    m_sharedStringIds.swap(sharedStringIds);
+
+    return (success && (m_position == end));
+}
+
+bool SnapshotInput::ReadObjectRecord(Object *parent, ClassId classId)
+{
+    assert(parent);
+
+    uint64_t flags;
+    if (!this->ReadUInt(flags)) return false;
+
+    Object *object = NULL;
+    if (classId == BOUNDARY_END) {
+        uint64_t startIndex;
+        if (!this->ReadUInt(startIndex) || (startIndex >= m_objects.size())) return false;
+        Object *start = m_objects.at(startIndex);
+        BoundaryStartInterface *boundaryStart = dynamic_cast<BoundaryStartInterface *>(start);
+        if (!boundaryStart) return false;
+        BoundaryEnd *boundaryEnd = new BoundaryEnd(start);
+        boundaryStart->SetEnd(boundaryEnd);
+        object = boundaryEnd;
+    }
+    else if ((classId == APP) || (classId == CHOICE)) {
+        uint64_t level;
+        if (!this->ReadUInt(level)) return false;
+        if (classId == APP)
+            object = new App((EditorialLevel)level);
+        else
+            object = new Choice((EditorialLevel)level);
+    }
+    else if (classId == ARTIC_PART) {
+        uint64_t type;
+        if (!this->ReadUInt(type)) return false;
+        Artic *artic = dynamic_cast<Artic *>(parent);
+        if (!artic) return false;
+        object = new ArticPart((ArticPartType)type, artic);
+    }
+    else {
+        object = this->CreateObject(classId, (int)flags);
+    }
+    if (!object) {
+        LogError("Unsupported class %d in the snapshot", (int)classId);
+        return false;
+    }
+
+    if (flags & SNAPSHOT_OBJECT_ATTRIBUTE) object->IsAttribute(true);
+    // The visibility is always set since it is not the same by default for editorial elements and mdivs
+    VisibilityType visibility = (flags & SNAPSHOT_OBJECT_HIDDEN) ? Hidden : Visible;
+    if (object->IsEditorialElement()) {
+        EditorialElement *editorialElement = dynamic_cast<EditorialElement *>(object);
+        assert(editorialElement);
+        editorialElement->m_visibility = visibility;
+    }
+    else if (object->Is(MDIV)) {
+        Mdiv *mdiv = dynamic_cast<Mdiv *>(object);
+        assert(mdiv);
+        mdiv->m_visibility = visibility;
+    }
+    if (flags & SNAPSHOT_OBJECT_GENERATED) {
+        if (object->Is(MNUM)) {
+            MNum *mNum = dynamic_cast<MNum *>(object);
+            assert(mNum);
+            mNum->IsGenerated(true);
+        }
+        else if (object->IsRunningElement()) {
+            RunningElement *runningElement = dynamic_cast<RunningElement *>(object);
+            assert(runningElement);
+            runningElement->IsGenerated(true);
+        }
+    }
+
+    // Pushed before the content is read since the index is the position in the preorder of the tree
+    m_objects.push_back(object);
+    size_t index = m_objects.size() - 1;
+
+    if (!this->ReadObjectContent(object, (int)flags)) {
+        delete object;
+        m_objects.at(index) = NULL;
+        return false;
+    }
+
+    // When flattening the pages, the children of the pages and systems are added to the first one
+    Object *target = object;
+    if (m_flattenPages && (object->Is(PAGE) || object->Is(SYSTEM))) {
+        Object *first = parent->FindChildByType(object->GetClassId(), 1);
+        if (first) {
+            target = first;
+            m_objects.at(index) = first;
+            delete object;
+        }
+    }
+    if (target == object) parent->AddChild(object);
+
+    uint64_t childCount;
+    if (!this->ReadUInt(childCount)) return false;
+    for (uint64_t i = 0; i < childCount; ++i) {
+        if (!this->ReadObject(target)) return false;
+    }
+
+    return true;
+}
+
+bool SnapshotInput::ReadObjectContent(Object *object, int flags)
+{
+    assert(object);
+
+    std::string uuid;
+    if (!this->ReadString(uuid)) return false;
+    object->SetUuid(uuid);
+
+    if (flags & SNAPSHOT_OBJECT_COMMENT) {
+        std::string comment;
+        if (!this->ReadString(comment)) return false;
+        object->SetComment(comment);
+    }
+
+    uint64_t attributeCount;
+    if (!this->ReadUInt(attributeCount)) return false;
+    std::string name, value;
+    int nameId;
+    for (uint64_t i = 0; i < attributeCount; ++i) {
+        if (!this->ReadSharedString(name, &nameId) || !this->ReadSharedString(value)) return false;
+        this->SetAttribute(object, nameId, name, value);
+    }
+
+    // Values that are not attributes
+    if (object->Is(PAGE)) {
+        Page *page = dynamic_cast<Page *>(object);
+        assert(page);
+        double PPUFactor;
+        if (!this->ReadInt(page->m_pageHeight) || !this->ReadInt(page->m_pageWidth)
+            || !this->ReadInt(page->m_pageMarginBottom) || !this->ReadInt(page->m_pageMarginLeft)
+            || !this->ReadInt(page->m_pageMarginRight) || !this->ReadInt(page->m_pageMarginTop)
+            || !this->ReadString(page->m_surface) || !this->ReadDouble(PPUFactor)) {
+            return false;
+        }
+        page->SetPPUFactor(PPUFactor);
+    }
+    else if (object->Is(SYSTEM)) {
+        System *system = dynamic_cast<System *>(object);
+        assert(system);
+        if (!this->ReadInt(system->m_systemLeftMar) || !this->ReadInt(system->m_systemRightMar)
+            || !this->ReadInt(system->m_yAbs)) {
+            return false;
+        }
+    }
+    else if (object->Is(MEASURE)) {
+        Measure *measure = dynamic_cast<Measure *>(object);
+        assert(measure);
+        double maxTime;
+        if (!this->ReadDouble(maxTime)) return false;
+        measure->m_measureAligner.SetMaxTime(maxTime);
+    }
+    else if (object->Is(TEXT)) {
+        Text *text = dynamic_cast<Text *>(object);
+        assert(text);
+        std::string content;
+        if (!this->ReadString(content)) return false;
+        text->SetText(UTF8to16(content));
+    }
+    else if (object->Is(ANNOT)) {
+        Annot *annot = dynamic_cast<Annot *>(object);
+        assert(annot);
+        std::string content;
+        if (!this->ReadString(content)) return false;
+        if (!content.empty()) {
+            annot->m_content.load_buffer(content.data(), content.size(), pugi::parse_default | pugi::parse_fragment);
+        }
+    }
+    else if (object->Is(SVG)) {
+        Svg *svg = dynamic_cast<Svg *>(object);
+        assert(svg);
+        std::string content;
+        if (!this->ReadString(content)) return false;
+        pugi::xml_document svgDoc;
+        svgDoc.load_buffer(content.data(), content.size());
+        svg->Set(svgDoc.first_child());
+    }
+
+    return true;
+}
+
+bool SnapshotInput::ReadPreparedValues()
+{
+    // The group ids are set at the end since setting the links of the hairpins changes them
+    std::vector<std::pair<FloatingObject *, int> > drawingGrpIds;
+
+    int64_t index = -1;
+    uint64_t indexDifference;
+    while (true) {
+        if (!this->ReadUInt(indexDifference)) return false;
+        if (indexDifference == 0) break;
+        index += indexDifference;
+        if ((indexDifference > m_objects.size()) || (index >= (int64_t)m_objects.size())) return false;
+        Object *object = m_objects.at(index);
+        uint64_t flags;
+        if (!object || !this->ReadUInt(flags)) return false;
+
+        Object *reference;
+        if (flags & SNAPSHOT_PREPARED_START) {
+            TimePointInterface *timePoint = object->GetTimePointInterface();
+            if (!timePoint || !this->ReadReference(reference)) return false;
+            LayerElement *start = dynamic_cast<LayerElement *>(reference);
+            if (!start) return false;
+            timePoint->SetStart(start);
+        }
+        if (flags & SNAPSHOT_PREPARED_END) {
+            TimeSpanningInterface *timeSpanning = object->GetTimeSpanningInterface();
+            if (!timeSpanning || !this->ReadReference(reference)) return false;
+            LayerElement *end = dynamic_cast<LayerElement *>(reference);
+            if (!end) return false;
+            timeSpanning->SetEnd(end);
+        }
+        if (flags & SNAPSHOT_PREPARED_REFERENCES) {
+            PlistInterface *plist = object->GetPlistInterface();
+            uint64_t count;
+            if (!plist || !this->ReadUInt(count)) return false;
+            for (uint64_t i = 0; i < count; ++i) {
+                if (!this->ReadReference(reference) || !reference) return false;
+                plist->SetRef(reference);
+            }
+        }
+        LayerElement *element = dynamic_cast<LayerElement *>(object);
+        if (flags & SNAPSHOT_PREPARED_CROSS_STAFF) {
+            Object *crossLayer;
+            if (!element || !this->ReadReference(reference) || !this->ReadReference(crossLayer)) return false;
+            element->m_crossStaff = dynamic_cast<Staff *>(reference);
+            element->m_crossLayer = dynamic_cast<Layer *>(crossLayer);
+        }
+        if (flags & SNAPSHOT_PREPARED_CUE_SIZE) {
+            if (!element) return false;
+            element->SetDrawingCueSize(true);
+        }
+        if (flags & SNAPSHOT_PREPARED_STEM) {
+            StemmedDrawingInterface *stemmed = object->GetStemmedDrawingInterface();
+            if (!stemmed || !this->ReadReference(reference)) return false;
+            Stem *stem = dynamic_cast<Stem *>(reference);
+            if (!stem) return false;
+            stemmed->SetDrawingStem(stem);
+        }
+        if (flags & SNAPSHOT_PREPARED_DOT) {
+            Dot *dot = dynamic_cast<Dot *>(object);
+            Object *nextElement;
+            if (!dot || !this->ReadReference(reference) || !this->ReadReference(nextElement)) return false;
+            dot->m_drawingNote = dynamic_cast<Note *>(reference);
+            dot->m_drawingNextElement = dynamic_cast<LayerElement *>(nextElement);
+        }
+        if (flags & SNAPSHOT_PREPARED_VERSE) {
+            Syl *syl = dynamic_cast<Syl *>(object);
+            if (!syl || !this->ReadInt(syl->m_drawingVerse)) return false;
+        }
+        if (flags & SNAPSHOT_PREPARED_MEASURE_COUNT) {
+            MRpt *mRpt = dynamic_cast<MRpt *>(object);
+            if (!mRpt || !this->ReadInt(mRpt->m_drawingMeasureCount)) return false;
+        }
+        if (flags & SNAPSHOT_PREPARED_MEASURE) {
+            if (!this->ReadReference(reference)) return false;
+            Measure *measure = dynamic_cast<Measure *>(reference);
+            BoundaryStartInterface *boundaryStart = dynamic_cast<BoundaryStartInterface *>(object);
+            BoundaryEnd *boundaryEnd = dynamic_cast<BoundaryEnd *>(object);
+            if (!measure) return false;
+            if (boundaryStart)
+                boundaryStart->SetMeasure(measure);
+            else if (boundaryEnd)
+                boundaryEnd->SetMeasure(measure);
+            else
+                return false;
+        }
+        if (flags & SNAPSHOT_PREPARED_ENDING) {
+            Measure *measure = dynamic_cast<Measure *>(object);
+            if (!measure || !this->ReadReference(reference)) return false;
+            Ending *ending = dynamic_cast<Ending *>(reference);
+            if (!ending) return false;
+            measure->SetDrawingEnding(ending);
+        }
+        if (flags & SNAPSHOT_PREPARED_GRP_ID) {
+            FloatingObject *floatingObject = dynamic_cast<FloatingObject *>(object);
+            int drawingGrpId;
+            if (!floatingObject || !this->ReadInt(drawingGrpId)) return false;
+            drawingGrpIds.push_back(std::make_pair(floatingObject, drawingGrpId));
+        }
+        if (flags & SNAPSHOT_PREPARED_LINKS) {
+            Hairpin *hairpin = dynamic_cast<Hairpin *>(object);
+            Object *rightLink;
+            if (!hairpin || !this->ReadReference(reference) || !this->ReadReference(rightLink)) return false;
+            ControlElement *leftLinkElement = dynamic_cast<ControlElement *>(reference);
+            ControlElement *rightLinkElement = dynamic_cast<ControlElement *>(rightLink);
+            if ((reference && !leftLinkElement) || (rightLink && !rightLinkElement)) return false;
+            if (leftLinkElement) hairpin->SetLeftLink(leftLinkElement);
+            if (rightLinkElement) hairpin->SetRightLink(rightLinkElement);
+        }
+        if (flags & SNAPSHOT_PREPARED_TIME_SPANNING) {
+            Staff *staff = dynamic_cast<Staff *>(object);
+            uint64_t count;
+            if (!staff || !this->ReadUInt(count)) return false;
+            for (uint64_t i = 0; i < count; ++i) {
+                if (!this->ReadReference(reference) || !reference) return false;
+                staff->m_timeSpanningElements.push_back(reference);
+            }
+        }
+        if (flags & SNAPSHOT_PREPARED_CONTENT) {
+            Measure *measure = dynamic_cast<Measure *>(object);
+            uint64_t count, classId, hasCrossStaffContent;
+            if (!measure || !this->ReadUInt(count)) return false;
+            std::bitset<UNSPECIFIED> contentClassIds;
+            for (uint64_t i = 0; i < count; ++i) {
+                if (!this->ReadUInt(classId) || (classId >= UNSPECIFIED)) return false;
+                contentClassIds.set(classId);
+            }
+            if (!this->ReadUInt(hasCrossStaffContent)) return false;
+            measure->SetContent(contentClassIds, hasCrossStaffContent);
+        }
+    }
+
+    for (auto &drawingGrpId : drawingGrpIds) {
+        drawingGrpId.first->SetDrawingGrpId(drawingGrpId.second);
+    }
+
+    return true;
+}
+
+bool SnapshotInput::ReadReference(Object *&object)
+{
+    object = NULL;
+
+    uint64_t value;
+    if (!this->ReadUInt(value)) return false;
+    if (value == 0) return true;
+
+    if (value % 2 == 1) {
+        uint64_t index = value / 2;
+        if (index >= m_objects.size()) return false;
+        object = m_objects.at(index);
+        return (object != NULL);
+    }
+
+    // A timestamp of a measure
+    uint64_t index = value / 2 - 1;
+    double time;
+    if ((index >= m_objects.size()) || !this->ReadDouble(time)) return false;
+    Measure *measure = dynamic_cast<Measure *>(m_objects.at(index));
+    if (!measure) return false;
+    TimestampAttr *timestampAttr = measure->m_timestampAligner.GetTimestampAtTime(time + 1.0);
+    // The time is set again for having exactly the one of the snapshot
+    timestampAttr->SetDrawingPos(time);
+    object = timestampAttr;
+    return true;
+}
+
+Object *SnapshotInput::CreateObject(ClassId classId, int flags)
+{
+    switch (classId) {
+        case MEASURE: return new Measure(!(flags & SNAPSHOT_OBJECT_UNMEASURED));
+        case ANNOT: return new Annot();
+        case LABEL: return new Label();
+        case LABELABBR: return new LabelAbbr();
+        case LAYER: return new Layer();
+        case MDIV: return new Mdiv();
+        case PAGE: return new Page();
+        case PAGES: return new Pages();
+        case SCORE: return new Score();
+        case STAFF: return new Staff();
+        case STAFFGRP: return new StaffGrp();
+        case SVG: return new Svg();
+        case SYSTEM: return new System();
+        case ABBR: return new Abbr();
+        case ADD: return new vrv::Add();
+        case CORR: return new Corr();
+        case DAMAGE: return new Damage();
+        case DEL: return new Del();
+        case EXPAN: return new Expan();
+        case LEM: return new Lem();
+        case ORIG: return new Orig();
+        case RDG: return new Rdg();
+        case REF: return new Ref();
+        case REG: return new Reg();
+        case RESTORE: return new Restore();
+        case SIC: return new Sic();
+        case SUPPLIED: return new Supplied();
+        case UNCLEAR: return new Unclear();
+        case PGFOOT: return new PgFoot();
+        case PGFOOT2: return new PgFoot2();
+        case PGHEAD: return new PgHead();
+        case PGHEAD2: return new PgHead2();
+        case ENDING: return new Ending();
+        case EXPANSION: return new Expansion();
+        case PB: return new Pb();
+        case SB: return new Sb();
+        case SECTION: return new Section();
+        case ANCHORED_TEXT: return new AnchoredText();
+        case ARPEG: return new Arpeg();
+        case BREATH: return new Breath();
+        case DIR: return new Dir();
+        case DYNAM: return new Dynam();
+        case FERMATA: return new Fermata();
+        case HAIRPIN: return new Hairpin();
+        case HARM: return new Harm();
+        case MORDENT: return new Mordent();
+        case MNUM: return new MNum();
+        case OCTAVE: return new Octave();
+        case PEDAL: return new Pedal();
+        case SLUR: return new Slur();
+        case TEMPO: return new Tempo();
+        case TIE: return new Tie();
+        case TRILL: return new Trill();
+        case TURN: return new Turn();
+        case ACCID: return new Accid();
+        case ARTIC: return new Artic();
+        case BARLINE: return new BarLine();
+        case BEAM: return new Beam();
+        case BEATRPT: return new BeatRpt();
+        case BTREM: return new BTrem();
+        case CHORD: return new Chord();
+        case CLEF: return new Clef();
+        case CUSTOS: return new Custos();
+        case DOT: return new Dot();
+        case DOTS: return new Dots();
+        case FLAG: return new Flag();
+        case FTREM: return new FTrem();
+        case KEYSIG: return new KeySig();
+        case LIGATURE: return new Ligature();
+        case MENSUR: return new Mensur();
+        case METERSIG: return new MeterSig();
+        case MREST: return new MRest();
+        case MRPT: return new MRpt();
+        case MRPT2: return new MRpt2();
+        case MULTIREST: return new MultiRest();
+        case MULTIRPT: return new MultiRpt();
+        case NOTE: return new Note();
+        case PROPORT: return new Proport();
+        case REST: return new Rest();
+        case SPACE: return new Space();
+        case STEM: return new Stem();
+        case SYL: return new Syl();
+        case TUPLET: return new Tuplet();
+        case VERSE: return new Verse();
+        case SCOREDEF: return new ScoreDef();
+        case STAFFDEF: return new StaffDef();
+        case FB: return new Fb();
+        case FIG: return new Fig();
+        case FIGURE: return new F();
+        case INSTRDEF: return new InstrDef();
+        case LB: return new Lb();
+        case NUM: return new Num();
+        case REND: return new Rend();
+        case TEXT: return new Text();
+        default: return NULL;
+    }
+}
+
+void SnapshotInput::SetAttribute(Object *object, int nameId, const std::string &name, const std::string &value)
+{
+    typedef bool (*AttSetter)(Object *, std::string, std::string);
+    static const AttSetter attSetters[] = { Att::SetAnalytical, Att::SetCmn, Att::SetCmnornaments, Att::SetCritapp,
+        Att::SetExternalsymbols, Att::SetGestural, Att::SetMei, Att::SetMensural, Att::SetMidi, Att::SetPagebased,
+        Att::SetShared, Att::SetVisual };
+    static const int attSetterCount = sizeof(attSetters) / sizeof(attSetters[0]);
+
+    // The setter is looked for only once for each class and attribute name since trying them all is slow
+    std::pair<int, int> key(object->GetClassId(), nameId);
+    std::map<std::pair<int, int>, int>::iterator iter = m_attSetters.find(key);
+    if (iter != m_attSetters.end()) {
+        if ((iter->second != -1) && attSetters[iter->second](object, name, value)) return;
+    }
+    else {
+        int i;
+        for (i = 0; i < attSetterCount; ++i) {
+            if (attSetters[i](object, name, value)) {
+                m_attSetters[key] = i;
+                return;
+            }
+        }
+        m_attSetters[key] = -1;
+    }
+
+    object->m_unsupported.push_back(std::make_pair(name, value));
+}
+
+bool SnapshotInput::ReadUInt(uint64_t &value)
+{
+    value = 0;
+    int shift = 0;
+    while (m_position < m_input->size()) {
+        unsigned char byte = (unsigned char)(*m_input)[m_position++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+        shift += 7;
+        if (shift > 63) return false;
+    }
+    return false;
+}
+
+bool SnapshotInput::ReadInt(int64_t &value)
+{
+    uint64_t zigzag;
+    if (!this->ReadUInt(zigzag)) return false;
+    value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+    return true;
+}
+
+bool SnapshotInput::ReadInt(int &value)
+{
+    int64_t value64;
+    if (!this->ReadInt(value64)) return false;
+    value = (int)value64;
+    return true;
+}
+
+bool SnapshotInput::ReadDouble(double &value)
+{
+    if (m_position + 8 > m_input->size()) return false;
+    uint64_t bits = 0;
+    int i;
+    for (i = 0; i < 8; ++i) {
+        bits |= (uint64_t)(unsigned char)(*m_input)[m_position++] << (8 * i);
+    }
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+bool SnapshotInput::ReadString(std::string &value)
+{
+    uint64_t size;
+    if (!this->ReadUInt(size)) return false;
+    if (size > m_input->size() - m_position) return false;
+    value.assign(*m_input, m_position, size);
+    m_position += size;
+    return true;
+}
+
+bool SnapshotInput::ReadSharedString(std::string &value, int *id)
+{
+    uint64_t sharedIndex;
+    if (!this->ReadUInt(sharedIndex)) return false;
+    if (sharedIndex == 0) {
+        if (!this->ReadString(value)) return false;
+        m_sharedStrings.push_back(value);
+        std::pair<std::map<std::string, int>::iterator, bool> result
+            = m_stringIds.insert(std::make_pair(value, (int)m_stringIds.size()));
+        m_sharedStringIds.push_back(result.first->second);
+        sharedIndex = m_sharedStrings.size();
+    }
+    else if (sharedIndex > m_sharedStrings.size()) {
+        return false;
+    }
+    else {
+        value = m_sharedStrings.at(sharedIndex - 1);
+    }
+    if (id) *id = m_sharedStringIds.at(sharedIndex - 1);
+    return true;
+}
+
+} // namespace vrv
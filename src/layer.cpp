@@ -218,7 +218,7 @@ data_STEMDIRECTION Layer::GetDrawingStemDir(LayerElement *element)
     assert(measure);
 
     // First check if there is any <space> in the measure - if not we can return the layer stem direction
-    if (!measure->FindChildByType(SPACE)) {
+    if (!measure->HasContentOfType(SPACE)) {
         return m_drawingStemDir;
     }
 
@@ -252,7 +252,7 @@ data_STEMDIRECTION Layer::GetDrawingStemDir(const ArrayOfBeamElementCoords *coor
     assert(measure);
 
     // First check if there is any <space> in the measure - if not we can return the layer stem direction
-    if (!measure->FindChildByType(SPACE)) {
+    if (!measure->HasContentOfType(SPACE)) {
         return m_drawingStemDir;
     }
 
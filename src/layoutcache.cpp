@@ -0,0 +1,200 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        layoutcache.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "layoutcache.h"
+
+//----------------------------------------------------------------------------
+
+#include <assert.h>
+#include <fstream>
+#include <iterator>
+
+//----------------------------------------------------------------------------
+
+#include "doc.h"
+#include "memorystats.h"
+#include "vrv.h"
+
+namespace vrv {
+
+#define LAYOUT_CACHE_FILE_HEADER "verovio-layout-cache 1"
+
+//----------------------------------------------------------------------------
+// LayoutCache
+//----------------------------------------------------------------------------
+
+const uint64_t LayoutCache::s_hashInit = 14695981039346656037ULL;
+
+LayoutCache::LayoutCache()
+{
+    Reset();
+}
+
+LayoutCache::~LayoutCache() {}
+
+void LayoutCache::Reset()
+{
+    m_entries.clear();
+    m_keys.clear();
+    m_isModified = false;
+}
+
+bool LayoutCache::Load(const std::string &filename)
+{
+    std::ifstream in(filename.c_str());
+    if (!in.is_open()) {
+        return false;
+    }
+
+    std::string header;
+    std::getline(in, header);
+    if (header != LAYOUT_CACHE_FILE_HEADER) {
+        LogWarning("File '%s' is not a layout cache file", filename.c_str());
+        return false;
+    }
+
+    m_entries.clear();
+    m_keys.clear();
+
+    uint64_t key;
+    int count;
+    while (in >> key) {
+        LayoutCacheEntry entry;
+        if (!(in >> count) || (count < 0)) break;
+        entry.m_alignmentXRels.resize(count);
+        for (int i = 0; i < count; ++i) in >> entry.m_alignmentXRels.at(i);
+        if (!(in >> count) || (count < 0)) break;
+        entry.m_elementXRels.resize(count);
+        for (int i = 0; i < count; ++i) in >> entry.m_elementXRels.at(i);
+        if (in.fail()) break;
+        // The entries are saved from the least to the most recently used
+        this->SetEntry(key, entry);
+    }
+
+    m_isModified = false;
+
+    return true;
+}
+
+bool LayoutCache::Save(const std::string &filename)
+{
+    std::ofstream out(filename.c_str());
+    if (!out.is_open()) {
+        LogError("Unable to write the layout cache to '%s'", filename.c_str());
+        return false;
+    }
+
+    out << LAYOUT_CACHE_FILE_HEADER << std::endl;
+
+    ListOfKeys::const_iterator iter;
+    for (iter = m_keys.begin(); iter != m_keys.end(); ++iter) {
+        const LayoutCacheEntry &entry = m_entries.at(*iter).first;
+        out << *iter << " " << entry.m_alignmentXRels.size();
+        for (auto &xRel : entry.m_alignmentXRels) out << " " << xRel;
+        out << " " << entry.m_elementXRels.size();
+        for (auto &xRel : entry.m_elementXRels) out << " " << xRel;
+        out << std::endl;
+    }
+
+    m_isModified = false;
+
+    return true;
+}
+
+const LayoutCacheEntry *LayoutCache::GetEntry(uint64_t key)
+{
+    auto iter = m_entries.find(key);
+    if (iter == m_entries.end()) return NULL;
+
+    // Move the key to the end of the list as the most recently used one
+    m_keys.splice(m_keys.end(), m_keys, iter->second.second);
+    return &iter->second.first;
+}
+
+void LayoutCache::SetEntry(uint64_t key, const LayoutCacheEntry &entry)
+{
+    m_isModified = true;
+
+    auto iter = m_entries.find(key);
+    if (iter != m_entries.end()) {
+        iter->second.first = entry;
+        m_keys.splice(m_keys.end(), m_keys, iter->second.second);
+        return;
+    }
+
+    // Keep the memory bounded by evicting the least recently used entry
+    if (m_entries.size() >= LAYOUT_CACHE_MAX_ENTRIES) {
+        m_entries.erase(m_keys.front());
+        m_keys.pop_front();
+    }
+
+    m_keys.push_back(key);
+    m_entries[key] = std::make_pair(entry, std::prev(m_keys.end()));
+}
+
+size_t LayoutCache::GetMemorySize() const
+{
+    size_t bytes = 0;
+    for (auto &entry : m_entries) {
+        bytes += MEMORY_STATS_NODE_SIZE + sizeof(entry);
+        bytes += entry.second.first.m_alignmentXRels.capacity() * sizeof(int);
+        bytes += entry.second.first.m_elementXRels.capacity() * sizeof(int);
+    }
+    bytes += m_keys.size() * (MEMORY_STATS_NODE_SIZE + sizeof(uint64_t));
+    return bytes;
+}
+
+void LayoutCache::Hash(uint64_t &hash, int value)
+{
+    unsigned int bytes = (unsigned int)value;
+    for (int i = 0; i < 4; ++i) {
+        hash ^= (bytes & 0xFF);
+        hash *= 1099511628211ULL;
+        bytes >>= 8;
+    }
+}
+
+void LayoutCache::Hash(uint64_t &hash, uint64_t value)
+{
+    Hash(hash, (int)(value & 0xFFFFFFFF));
+    Hash(hash, (int)(value >> 32));
+}
+
+void LayoutCache::Hash(uint64_t &hash, const std::string &value)
+{
+    for (auto &c : value) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
+    }
+    // Add the length to separate consecutive strings
+    Hash(hash, (int)value.size());
+}
+
+uint64_t LayoutCache::CalcContextHash(Doc *doc)
+{
+    assert(doc);
+
+    uint64_t hash = s_hashInit;
+
+    Hash(hash, doc->GetType());
+    Hash(hash, doc->GetDrawingUnit(100));
+
+    // Page size and margin options do not change the horizontal layout of the measures
+    Options *options = doc->GetOptions();
+    Hash(hash, options->m_unit.GetStrValue());
+    Hash(hash, options->m_evenNoteSpacing.GetStrValue());
+    for (auto grp : { &options->m_generalLayout, &options->m_elementMargins }) {
+        for (auto option : *grp->GetOptions()) {
+            Hash(hash, option->GetKey());
+            Hash(hash, option->GetStrValue());
+        }
+    }
+
+    return hash;
+}
+
+} // namespace vrv
@@ -17,12 +17,20 @@
 
 #include "attcomparison.h"
 #include "boundary.h"
+#include "clef.h"
 #include "controlelement.h"
 #include "doc.h"
 #include "editorial.h"
 #include "ending.h"
 #include "functorparams.h"
 #include "hairpin.h"
+#include "keysig.h"
+#include "layer.h"
+#include "layerelement.h"
+#include "layoutcache.h"
+#include "memorystats.h"
+#include "mensur.h"
+#include "metersig.h"
 #include "page.h"
 #include "staff.h"
 #include "staffdef.h"
@@ -108,6 +116,12 @@ void Measure::Reset()
 
     m_drawingEnding = NULL;
     m_hasAlignmentRefWithMultipleLayers = false;
+    m_horizontalLayoutKey = 0;
+    m_horizontalLayoutCached = false;
+    m_castOffLayout.m_alignmentXRels.clear();
+    m_castOffLayout.m_elementXRels.clear();
+
+    this->ResetContent();
 
     m_scoreTimeOffset.clear();
     m_realTimeOffsetMilliseconds.clear();
@@ -269,6 +283,44 @@ int Measure::GetInnerCenterX() const
     return (this->GetDrawingX() + this->GetLeftBarLineRight() + this->GetInnerWidth() / 2);
 }
 
+void Measure::StoreCastOffLayout()
+{
+    std::vector<Alignment *> alignments;
+    std::vector<LayerElement *> elements;
+    this->GetHorizontalLayoutObjects(alignments, elements);
+
+    m_castOffLayout.m_alignmentXRels.clear();
+    for (auto &alignment : alignments) m_castOffLayout.m_alignmentXRels.push_back(alignment->GetXRel());
+    m_castOffLayout.m_elementXRels.clear();
+    for (auto &element : elements) m_castOffLayout.m_elementXRels.push_back(element->GetDrawingXRel());
+}
+
+void Measure::ReleaseAlignments()
+{
+    double maxTime = m_measureAligner.GetMaxTime();
+    m_measureAligner.Reset();
+    m_measureAligner.SetMaxTime(maxTime);
+}
+
+bool Measure::RestoreCastOffLayout(bool checkOnly)
+{
+    std::vector<Alignment *> alignments;
+    std::vector<LayerElement *> elements;
+    this->GetHorizontalLayoutObjects(alignments, elements);
+
+    if ((alignments.size() != m_castOffLayout.m_alignmentXRels.size())
+        || (elements.size() != m_castOffLayout.m_elementXRels.size())) {
+        return false;
+    }
+    if (checkOnly) return true;
+
+    int i;
+    for (i = 0; i < (int)alignments.size(); ++i) alignments.at(i)->SetXRel(m_castOffLayout.m_alignmentXRels.at(i));
+    for (i = 0; i < (int)elements.size(); ++i) elements.at(i)->SetDrawingXRel(m_castOffLayout.m_elementXRels.at(i));
+
+    return true;
+}
+
 void Measure::SetDrawingScoreDef(ScoreDef *drawingScoreDef)
 {
     assert(!m_drawingScoreDef); // We should always call UnsetCurrentScoreDef before
@@ -277,6 +329,156 @@ void Measure::SetDrawingScoreDef(ScoreDef *drawingScoreDef)
     *m_drawingScoreDef = *drawingScoreDef;
 }
 
+void Measure::ResetContent()
+{
+    m_contentClassIds.reset();
+    m_contentDone = false;
+    m_hasCrossStaffContent = false;
+    m_contentHash = 0;
+}
+
+void Measure::AddContent(Object *object)
+{
+    assert(object);
+
+    m_contentClassIds.set(object->GetClassId());
+    if (object->IsLayerElement()) {
+        LayerElement *element = dynamic_cast<LayerElement *>(object);
+        assert(element);
+        if (element->m_crossStaff) m_hasCrossStaffContent = true;
+    }
+}
+
+void Measure::SetContent(const std::bitset<UNSPECIFIED> &contentClassIds, bool hasCrossStaffContent)
+{
+    m_contentClassIds = contentClassIds;
+    m_hasCrossStaffContent = hasCrossStaffContent;
+    m_contentDone = true;
+    m_contentHash = 0;
+}
+
+bool Measure::HasContentOfType(ClassId classId)
+{
+    assert(classId < UNSPECIFIED);
+
+    if (!m_contentDone) return (this->FindChildByType(classId) != NULL);
+
+    return m_contentClassIds.test(classId);
+}
+
+uint64_t Measure::GetContentHash()
+{
+    if (m_contentHash != 0) return m_contentHash;
+
+    Functor calcContentHash(&Object::CalcContentHash);
+    Functor calcContentHashEnd(&Object::CalcContentHashEnd);
+    CalcContentHashParams calcContentHashParams(LayoutCache::s_hashInit);
+    this->Process(&calcContentHash, &calcContentHashParams, &calcContentHashEnd);
+
+    m_contentHash = calcContentHashParams.m_hash;
+    return m_contentHash;
+}
+
+bool Measure::NeedsHorizontalBoundingBoxes()
+{
+    if (!m_horizontalLayoutCached) return true;
+
+    return (this->HasContentOfType(SYL) || this->HasContentOfType(ARPEG));
+}
+
+void Measure::GetHorizontalLayoutObjects(std::vector<Alignment *> &alignments, std::vector<LayerElement *> &elements)
+{
+    int i, j;
+    for (i = 0; i < m_measureAligner.GetChildCount(); ++i) {
+        Alignment *alignment = dynamic_cast<Alignment *>(m_measureAligner.GetChild(i));
+        assert(alignment);
+        alignments.push_back(alignment);
+        MapOfIntGraceAligners::const_iterator iter;
+        for (iter = alignment->GetGraceAligners()->begin(); iter != alignment->GetGraceAligners()->end(); ++iter) {
+            for (j = 0; j < iter->second->GetChildCount(); ++j) {
+                Alignment *graceAlignment = dynamic_cast<Alignment *>(iter->second->GetChild(j));
+                assert(graceAlignment);
+                alignments.push_back(graceAlignment);
+            }
+        }
+    }
+
+    std::vector<Alignment *>::const_iterator alignmentIter;
+    for (alignmentIter = alignments.begin(); alignmentIter != alignments.end(); ++alignmentIter) {
+        for (i = 0; i < (*alignmentIter)->GetChildCount(); ++i) {
+            Object *reference = (*alignmentIter)->GetChild(i);
+            for (j = 0; j < reference->GetChildCount(); ++j) {
+                LayerElement *element = dynamic_cast<LayerElement *>(reference->GetChild(j));
+                assert(element);
+                elements.push_back(element);
+            }
+        }
+    }
+}
+
+uint64_t Measure::CalcHorizontalLayoutKey(
+    uint64_t contextHash, const std::vector<Alignment *> &alignments, const std::vector<LayerElement *> &elements)
+{
+    uint64_t key = contextHash;
+    LayoutCache::Hash(key, this->GetContentHash());
+
+    // The staff sizes and the drawing staffDef values (that is, the effective scoreDef)
+    Functor calcContentHash(&Object::CalcContentHash);
+    Functor calcContentHashEnd(&Object::CalcContentHashEnd);
+    int i, j;
+    for (i = 0; i < this->GetChildCount(); ++i) {
+        if (!this->GetChild(i)->Is(STAFF)) continue;
+        Staff *staff = dynamic_cast<Staff *>(this->GetChild(i));
+        assert(staff);
+        LayoutCache::Hash(key, staff->GetN());
+        LayoutCache::Hash(key, staff->m_drawingStaffSize);
+        LayoutCache::Hash(key, staff->m_drawingLines);
+        LayoutCache::Hash(key, staff->m_drawingNotationType);
+        if (staff->m_drawingStaffDef) {
+            CalcContentHashParams calcContentHashParams(key);
+            staff->m_drawingStaffDef->Process(&calcContentHash, &calcContentHashParams, &calcContentHashEnd);
+            key = calcContentHashParams.m_hash;
+        }
+        for (j = 0; j < staff->GetChildCount(); ++j) {
+            if (!staff->GetChild(j)->Is(LAYER)) continue;
+            Layer *layer = dynamic_cast<Layer *>(staff->GetChild(j));
+            assert(layer);
+            std::vector<Object *> staffDefElements = { layer->GetStaffDefClef(), layer->GetStaffDefKeySig(),
+                layer->GetStaffDefMensur(), layer->GetStaffDefMeterSig(), layer->GetCautionStaffDefClef(),
+                layer->GetCautionStaffDefKeySig(), layer->GetCautionStaffDefMensur(),
+                layer->GetCautionStaffDefMeterSig() };
+            for (Object *staffDefElement : staffDefElements) {
+                if (!staffDefElement) {
+                    LayoutCache::Hash(key, 0);
+                    continue;
+                }
+                CalcContentHashParams calcContentHashParams(key);
+                staffDefElement->Process(&calcContentHash, &calcContentHashParams, &calcContentHashEnd);
+                key = calcContentHashParams.m_hash;
+            }
+        }
+    }
+
+    // The state of the content as left by the previous layout steps - this does not include the bounding boxes
+    // since they are not available yet, but they only depend on the values above
+    std::vector<Alignment *>::const_iterator alignmentIter;
+    for (alignmentIter = alignments.begin(); alignmentIter != alignments.end(); ++alignmentIter) {
+        LayoutCache::Hash(key, (*alignmentIter)->GetType());
+        LayoutCache::Hash(key, (*alignmentIter)->GetXRel());
+        LayoutCache::Hash(key, (*alignmentIter)->GetChildCount());
+    }
+    std::vector<LayerElement *>::const_iterator elementIter;
+    for (elementIter = elements.begin(); elementIter != elements.end(); ++elementIter) {
+        LayerElement *element = (*elementIter);
+        LayoutCache::Hash(key, element->GetClassId());
+        LayoutCache::Hash(key, element->GetDrawingXRel());
+        LayoutCache::Hash(key, element->GetDrawingYRel());
+    }
+
+    // 0 is used for measures that are not cached
+    return (key != 0) ? key : 1;
+}
+
 std::vector<Staff *> Measure::GetFirstStaffGrpStaves(ScoreDef *scoreDef)
 {
     assert(scoreDef);
@@ -482,6 +684,17 @@ int Measure::ConvertToUnCastOffMensural(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Measure::CalcMemoryStats(FunctorParams *functorParams)
+{
+    CalcMemoryStatsParams *params = dynamic_cast<CalcMemoryStatsParams *>(functorParams);
+    assert(params);
+
+    params->m_memoryStats->AddObjectTree(MEMORY_STATS_LAYOUT, &m_measureAligner);
+    params->m_memoryStats->AddObjectTree(MEMORY_STATS_LAYOUT, &m_timestampAligner);
+
+    return Object::CalcMemoryStats(functorParams);
+}
+
 int Measure::Save(FunctorParams *functorParams)
 {
     if (this->IsMeasuredMusic())
@@ -522,6 +735,8 @@ int Measure::ResetHorizontalAlignment(FunctorParams *functorParams)
     m_timestampAligner.Process(&resetHorizontalAlignment, NULL);
 
     m_hasAlignmentRefWithMultipleLayers = false;
+    m_horizontalLayoutKey = 0;
+    m_horizontalLayoutCached = false;
 
     return FUNCTOR_CONTINUE;
 }
@@ -606,6 +821,8 @@ int Measure::AdjustLayers(FunctorParams *functorParams)
     AdjustLayersParams *params = dynamic_cast<AdjustLayersParams *>(functorParams);
     assert(params);
 
+    if (m_horizontalLayoutCached) return FUNCTOR_SIBLINGS;
+
     if (!m_hasAlignmentRefWithMultipleLayers) return FUNCTOR_SIBLINGS;
 
     std::vector<int>::iterator iter;
@@ -631,6 +848,8 @@ int Measure::AdjustAccidX(FunctorParams *functorParams)
     AdjustAccidXParams *params = dynamic_cast<AdjustAccidXParams *>(functorParams);
     assert(params);
 
+    if (m_horizontalLayoutCached) return FUNCTOR_SIBLINGS;
+
     params->m_currentMeasure = this;
 
     m_measureAligner.Process(params->m_functor, params);
@@ -643,6 +862,8 @@ int Measure::AdjustGraceXPos(FunctorParams *functorParams)
     AdjustGraceXPosParams *params = dynamic_cast<AdjustGraceXPosParams *>(functorParams);
     assert(params);
 
+    if (m_horizontalLayoutCached) return FUNCTOR_SIBLINGS;
+
     m_measureAligner.PushAlignmentsRight();
     params->m_rightDefaultAlignment = NULL;
     
@@ -672,6 +893,8 @@ int Measure::AdjustXPos(FunctorParams *functorParams)
     AdjustXPosParams *params = dynamic_cast<AdjustXPosParams *>(functorParams);
     assert(params);
 
+    if (m_horizontalLayoutCached) return FUNCTOR_SIBLINGS;
+
     params->m_minPos = 0;
     params->m_upcomingMinPos = VRV_UNSET;
     params->m_cumulatedXShift = 0;
@@ -709,7 +932,7 @@ int Measure::AdjustXPos(FunctorParams *functorParams)
         minMeasureWidth *= 2;
     }
     // Nothing if the measure has at least one note or @metcon="false"
-    else if ((this->FindChildByType(NOTE) != NULL) || (this->GetMetcon() == BOOLEAN_false)) {
+    else if (this->HasContentOfType(NOTE) || (this->GetMetcon() == BOOLEAN_false)) {
         minMeasureWidth = 0;
     }
 
@@ -723,6 +946,67 @@ int Measure::AdjustXPos(FunctorParams *functorParams)
     return FUNCTOR_SIBLINGS;
 }
 
+int Measure::CacheHorizontalLayout(FunctorParams *functorParams)
+{
+    CacheHorizontalLayoutParams *params = dynamic_cast<CacheHorizontalLayoutParams *>(functorParams);
+    assert(params);
+    assert(params->m_layoutCache);
+
+    std::vector<Alignment *> alignments;
+    std::vector<LayerElement *> elements;
+
+    if (params->m_restore) {
+        // Cross-staff content depends on the vertical position of the staves, which is not known yet
+        if (!m_contentDone || m_hasCrossStaffContent) return FUNCTOR_SIBLINGS;
+
+        // The values are restored again after the bounding boxes are calculated since drawing the measure can change
+        // some of them - the key is calculated only the first time, before the bounding boxes
+        if ((m_horizontalLayoutKey != 0) && !m_horizontalLayoutCached) return FUNCTOR_SIBLINGS;
+        // Only the measures that were drawn need to be restored again
+        if (m_horizontalLayoutCached && !this->NeedsHorizontalBoundingBoxes()) return FUNCTOR_SIBLINGS;
+
+        this->GetHorizontalLayoutObjects(alignments, elements);
+        if (m_horizontalLayoutKey == 0) {
+            m_horizontalLayoutKey = this->CalcHorizontalLayoutKey(params->m_contextHash, alignments, elements);
+        }
+
+        const LayoutCacheEntry *entry = params->m_layoutCache->GetEntry(m_horizontalLayoutKey);
+        if (!entry || (entry->m_alignmentXRels.size() != alignments.size())
+            || (entry->m_elementXRels.size() != elements.size())) {
+            return FUNCTOR_SIBLINGS;
+        }
+
+        int i;
+        for (i = 0; i < (int)alignments.size(); ++i) {
+            alignments.at(i)->SetXRel(entry->m_alignmentXRels.at(i));
+        }
+        for (i = 0; i < (int)elements.size(); ++i) {
+            elements.at(i)->SetDrawingXRel(entry->m_elementXRels.at(i));
+        }
+        if (!m_horizontalLayoutCached) params->m_restoredCount++;
+        m_horizontalLayoutCached = true;
+    }
+    // Store the result of the adjustment unless it was restored from the cache
+    else if ((m_horizontalLayoutKey != 0) && !m_horizontalLayoutCached) {
+        this->GetHorizontalLayoutObjects(alignments, elements);
+
+        LayoutCacheEntry entry;
+        entry.m_alignmentXRels.reserve(alignments.size());
+        std::vector<Alignment *>::iterator alignmentIter;
+        for (alignmentIter = alignments.begin(); alignmentIter != alignments.end(); ++alignmentIter) {
+            entry.m_alignmentXRels.push_back((*alignmentIter)->GetXRel());
+        }
+        entry.m_elementXRels.reserve(elements.size());
+        std::vector<LayerElement *>::iterator elementIter;
+        for (elementIter = elements.begin(); elementIter != elements.end(); ++elementIter) {
+            entry.m_elementXRels.push_back((*elementIter)->GetDrawingXRel());
+        }
+        params->m_layoutCache->SetEntry(m_horizontalLayoutKey, entry);
+    }
+
+    return FUNCTOR_SIBLINGS;
+}
+
 int Measure::AdjustSylSpacingEnd(FunctorParams *functorParams)
 {
     AdjustSylSpacingParams *params = dynamic_cast<AdjustSylSpacingParams *>(functorParams);
@@ -790,6 +1074,7 @@ int Measure::ResetDrawing(FunctorParams *functorParams)
     this->m_rightBarLine.Reset();
     this->m_timestampAligner.Reset();
     m_drawingEnding = NULL;
+    this->ResetContent();
     return FUNCTOR_CONTINUE;
 }
 
@@ -888,6 +1173,28 @@ int Measure::PrepareCrossStaff(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Measure::PrepareMeasureContent(FunctorParams *functorParams)
+{
+    PrepareMeasureContentParams *params = dynamic_cast<PrepareMeasureContentParams *>(functorParams);
+    assert(params);
+
+    this->ResetContent();
+    params->m_currentMeasure = this;
+
+    return FUNCTOR_CONTINUE;
+}
+
+int Measure::PrepareMeasureContentEnd(FunctorParams *functorParams)
+{
+    PrepareMeasureContentParams *params = dynamic_cast<PrepareMeasureContentParams *>(functorParams);
+    assert(params);
+
+    m_contentDone = true;
+    params->m_currentMeasure = NULL;
+
+    return FUNCTOR_CONTINUE;
+}
+
 int Measure::PrepareFloatingGrps(FunctorParams *functorParams)
 {
     PrepareFloatingGrpsParams *params = dynamic_cast<PrepareFloatingGrpsParams *>(functorParams);
@@ -0,0 +1,343 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        memorystats.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "memorystats.h"
+
+//----------------------------------------------------------------------------
+
+#include <assert.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------
+
+#include "accid.h"
+#include "anchoredtext.h"
+#include "annot.h"
+#include "arpeg.h"
+#include "artic.h"
+#include "barline.h"
+#include "beam.h"
+#include "beatrpt.h"
+#include "boundary.h"
+#include "breath.h"
+#include "btrem.h"
+#include "chord.h"
+#include "clef.h"
+#include "controlelement.h"
+#include "custos.h"
+#include "dir.h"
+#include "doc.h"
+#include "dot.h"
+#include "dynam.h"
+#include "editorial.h"
+#include "elementpart.h"
+#include "ending.h"
+#include "expansion.h"
+#include "fb.h"
+#include "fermata.h"
+#include "fig.h"
+#include "floatingobject.h"
+#include "ftrem.h"
+#include "hairpin.h"
+#include "harm.h"
+#include "horizontalaligner.h"
+#include "instrdef.h"
+#include "keysig.h"
+#include "label.h"
+#include "labelabbr.h"
+#include "layer.h"
+#include "layerelement.h"
+#include "lb.h"
+#include "ligature.h"
+#include "mdiv.h"
+#include "measure.h"
+#include "mensur.h"
+#include "metersig.h"
+#include "mnum.h"
+#include "mordent.h"
+#include "mrest.h"
+#include "mrpt.h"
+#include "mrpt2.h"
+#include "multirest.h"
+#include "multirpt.h"
+#include "note.h"
+#include "num.h"
+#include "octave.h"
+#include "page.h"
+#include "pages.h"
+#include "pb.h"
+#include "pedal.h"
+#include "pgfoot.h"
+#include "pgfoot2.h"
+#include "pghead.h"
+#include "pghead2.h"
+#include "proport.h"
+#include "pugixml.hpp"
+#include "ref.h"
+#include "rend.h"
+#include "rest.h"
+#include "runningelement.h"
+#include "sb.h"
+#include "score.h"
+#include "scoredef.h"
+#include "section.h"
+#include "slur.h"
+#include "space.h"
+#include "staff.h"
+#include "staffdef.h"
+#include "staffgrp.h"
+#include "svg.h"
+#include "syl.h"
+#include "system.h"
+#include "systemelement.h"
+#include "tempo.h"
+#include "text.h"
+#include "textelement.h"
+#include "tie.h"
+#include "timestamp.h"
+#include "trill.h"
+#include "tuplet.h"
+#include "turn.h"
+#include "verse.h"
+#include "verticalaligner.h"
+#include "vrv.h"
+
+namespace vrv {
+
+/**
+ * The approximate size of the node and attribute structures of pugixml (a header and pointers)
+ */
+#define MEMORY_STATS_XML_NODE_SIZE (8 * sizeof(void *))
+#define MEMORY_STATS_XML_ATTRIBUTE_SIZE (5 * sizeof(void *))
+
+//----------------------------------------------------------------------------
+// MemoryStats
+//----------------------------------------------------------------------------
+
+MemoryStats::MemoryStats()
+{
+    Reset();
+}
+
+MemoryStats::~MemoryStats() {}
+
+void MemoryStats::Reset()
+{
+    for (int i = 0; i < MEMORY_STATS_GROUP_COUNT; ++i) m_entries[i].clear();
+}
+
+void MemoryStats::Add(MemoryStatsGroup group, const std::string &name, int count, size_t bytes)
+{
+    MemoryStatsEntry &entry = m_entries[group][name];
+    entry.m_count += count;
+    entry.m_bytes += bytes;
+}
+
+void MemoryStats::AddObject(MemoryStatsGroup group, const Object *object)
+{
+    assert(object);
+
+    size_t bytes = GetClassSize(object->GetClassId());
+    bytes += object->GetChildCount() * sizeof(Object *);
+
+    this->Add(group, object->GetClassName(), 1, bytes);
+}
+
+void MemoryStats::AddObjectTree(MemoryStatsGroup group, const Object *object)
+{
+    assert(object);
+
+    this->AddObject(group, object);
+
+    if (object->Is(ALIGNMENT)) {
+        const Alignment *alignment = dynamic_cast<const Alignment *>(object);
+        assert(alignment);
+        for (auto &graceAligner : *alignment->GetGraceAligners()) {
+            this->AddObjectTree(group, graceAligner.second);
+        }
+    }
+    else if (object->Is(STAFF_ALIGNMENT)) {
+        const StaffAlignment *staffAlignment = dynamic_cast<const StaffAlignment *>(object);
+        assert(staffAlignment);
+        const ArrayOfFloatingPositioners *positioners = staffAlignment->GetFloatingPositioners();
+        this->Add(group, "FloatingPositioner", (int)positioners->size(),
+            positioners->size() * (sizeof(FloatingPositioner) + sizeof(FloatingPositioner *)));
+    }
+
+    // The children of a reference object are owned (and counted) elsewhere
+    if (object->IsReferenceObject()) return;
+
+    for (int i = 0; i < object->GetChildCount(); ++i) {
+        this->AddObjectTree(group, object->GetChild(i));
+    }
+}
+
+void MemoryStats::SetXml(const std::string &name, const pugi::xml_node &node)
+{
+    MemoryStatsEntry entry;
+
+    pugi::xml_node current = node;
+    while (current) {
+        entry.m_count++;
+        entry.m_bytes += MEMORY_STATS_XML_NODE_SIZE + strlen(current.name()) + strlen(current.value()) + 2;
+        for (pugi::xml_attribute attr = current.first_attribute(); attr; attr = attr.next_attribute()) {
+            entry.m_bytes += MEMORY_STATS_XML_ATTRIBUTE_SIZE + strlen(attr.name()) + strlen(attr.value()) + 2;
+        }
+        // Depth-first traversal of the subtree of node
+        if (current.first_child()) {
+            current = current.first_child();
+            continue;
+        }
+        while (current && (current != node) && !current.next_sibling()) current = current.parent();
+        if (!current || (current == node)) break;
+        current = current.next_sibling();
+    }
+
+    m_entries[MEMORY_STATS_XML][name] = entry;
+}
+
+void MemoryStats::Merge(const MemoryStats &memoryStats)
+{
+    for (int i = 0; i < MEMORY_STATS_GROUP_COUNT; ++i) {
+        for (auto &entry : memoryStats.m_entries[i]) {
+            this->Add((MemoryStatsGroup)i, entry.first, entry.second.m_count, entry.second.m_bytes);
+        }
+    }
+}
+
+size_t MemoryStats::GetClassSize(ClassId classId)
+{
+    switch (classId) {
+        case FLOATING_OBJECT: return sizeof(FloatingObject);
+        case FLOATING_POSITIONER: return sizeof(FloatingPositioner);
+        case ALIGNMENT: return sizeof(Alignment);
+        case ALIGNMENT_REFERENCE: return sizeof(AlignmentReference);
+        case DOC: return sizeof(Doc);
+        case FB: return sizeof(Fb);
+        case GRACE_ALIGNER: return sizeof(GraceAligner);
+        case INSTRDEF: return sizeof(InstrDef);
+        case LABEL: return sizeof(Label);
+        case LABELABBR: return sizeof(LabelAbbr);
+        case LAYER: return sizeof(Layer);
+        case MDIV: return sizeof(Mdiv);
+        case MEASURE: return sizeof(Measure);
+        case MEASURE_ALIGNER: return sizeof(MeasureAligner);
+        case PAGE: return sizeof(Page);
+        case PAGES: return sizeof(Pages);
+        case SCORE: return sizeof(Score);
+        case STAFF: return sizeof(Staff);
+        case STAFF_ALIGNMENT: return sizeof(StaffAlignment);
+        case STAFFGRP: return sizeof(StaffGrp);
+        case SVG: return sizeof(Svg);
+        case SYSTEM: return sizeof(System);
+        case SYSTEM_ALIGNER: return sizeof(SystemAligner);
+        case TIMESTAMP_ALIGNER: return sizeof(TimestampAligner);
+        case EDITORIAL_ELEMENT: return sizeof(EditorialElement);
+        case ABBR: return sizeof(Abbr);
+        case ADD: return sizeof(vrv::Add);
+        case ANNOT: return sizeof(Annot);
+        case APP: return sizeof(App);
+        case CHOICE: return sizeof(Choice);
+        case CORR: return sizeof(Corr);
+        case DAMAGE: return sizeof(Damage);
+        case DEL: return sizeof(Del);
+        case EXPAN: return sizeof(Expan);
+        case LEM: return sizeof(Lem);
+        case ORIG: return sizeof(Orig);
+        case RDG: return sizeof(Rdg);
+        case REF: return sizeof(Ref);
+        case REG: return sizeof(Reg);
+        case RESTORE: return sizeof(Restore);
+        case SIC: return sizeof(Sic);
+        case SUPPLIED: return sizeof(Supplied);
+        case UNCLEAR: return sizeof(Unclear);
+        case RUNNING_ELEMENT: return sizeof(RunningElement);
+        case PGFOOT: return sizeof(PgFoot);
+        case PGFOOT2: return sizeof(PgFoot2);
+        case PGHEAD: return sizeof(PgHead);
+        case PGHEAD2: return sizeof(PgHead2);
+        case SYSTEM_ELEMENT: return sizeof(SystemElement);
+        case BOUNDARY_END: return sizeof(BoundaryEnd);
+        case ENDING: return sizeof(Ending);
+        case EXPANSION: return sizeof(Expansion);
+        case PB: return sizeof(Pb);
+        case SB: return sizeof(Sb);
+        case SECTION: return sizeof(Section);
+        case CONTROL_ELEMENT: return sizeof(ControlElement);
+        case ANCHORED_TEXT: return sizeof(AnchoredText);
+        case ARPEG: return sizeof(Arpeg);
+        case BREATH: return sizeof(Breath);
+        case DIR: return sizeof(Dir);
+        case DYNAM: return sizeof(Dynam);
+        case FERMATA: return sizeof(Fermata);
+        case HAIRPIN: return sizeof(Hairpin);
+        case HARM: return sizeof(Harm);
+        case MORDENT: return sizeof(Mordent);
+        case MNUM: return sizeof(MNum);
+        case OCTAVE: return sizeof(Octave);
+        case PEDAL: return sizeof(Pedal);
+        case SLUR: return sizeof(Slur);
+        case TEMPO: return sizeof(Tempo);
+        case TIE: return sizeof(Tie);
+        case TRILL: return sizeof(Trill);
+        case TURN: return sizeof(Turn);
+        case LAYER_ELEMENT: return sizeof(LayerElement);
+        case ACCID: return sizeof(Accid);
+        case ARTIC: return sizeof(Artic);
+        case ARTIC_PART: return sizeof(ArticPart);
+        case BARLINE: return sizeof(BarLine);
+        case BARLINE_ATTR_LEFT: return sizeof(BarLineAttr);
+        case BARLINE_ATTR_RIGHT: return sizeof(BarLineAttr);
+        case BEAM: return sizeof(Beam);
+        case BEATRPT: return sizeof(BeatRpt);
+        case BRACKET: return sizeof(Bracket);
+        case BTREM: return sizeof(BTrem);
+        case CHORD: return sizeof(Chord);
+        case CLEF: return sizeof(Clef);
+        case CUSTOS: return sizeof(Custos);
+        case DOT: return sizeof(Dot);
+        case DOTS: return sizeof(Dots);
+        case FLAG: return sizeof(Flag);
+        case FTREM: return sizeof(FTrem);
+        case KEYSIG: return sizeof(KeySig);
+        case LIGATURE: return sizeof(Ligature);
+        case MENSUR: return sizeof(Mensur);
+        case METERSIG: return sizeof(MeterSig);
+        case MREST: return sizeof(MRest);
+        case MRPT: return sizeof(MRpt);
+        case MRPT2: return sizeof(MRpt2);
+        case MULTIREST: return sizeof(MultiRest);
+        case MULTIRPT: return sizeof(MultiRpt);
+        case NOTE: return sizeof(Note);
+        case TUPLET_NUM: return sizeof(TupletNum);
+        case PROPORT: return sizeof(Proport);
+        case REST: return sizeof(Rest);
+        case SPACE: return sizeof(Space);
+        case STEM: return sizeof(Stem);
+        case SYL: return sizeof(Syl);
+        case TIMESTAMP_ATTR: return sizeof(TimestampAttr);
+        case TUPLET: return sizeof(Tuplet);
+        case VERSE: return sizeof(Verse);
+        case SCOREDEF_ELEMENT: return sizeof(ScoreDefElement);
+        case SCOREDEF: return sizeof(ScoreDef);
+        case STAFFDEF: return sizeof(StaffDef);
+        case TEXT_ELEMENT: return sizeof(TextElement);
+        case FIG: return sizeof(Fig);
+        case FIGURE: return sizeof(F);
+        case LB: return sizeof(Lb);
+        case NUM: return sizeof(Num);
+        case REND: return sizeof(Rend);
+        case TEXT: return sizeof(Text);
+        default:
+            // A class is missing in the list above
+            LogDebug("No size for the ClassId %d", classId);
+            assert(false);
+            return sizeof(Object);
+    }
+}
+
+} // namespace vrv
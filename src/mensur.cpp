@@ -18,9 +18,6 @@
 
 namespace vrv {
 
-int Mensur::s_num = 3;
-int Mensur::s_numBase = 2;
-
 //----------------------------------------------------------------------------
 // Mensur
 //----------------------------------------------------------------------------
@@ -12,7 +12,9 @@
 #include <assert.h>
 #include <iostream>
 #include <math.h>
+#include <random>
 #include <sstream>
+#include <thread>
 
 //----------------------------------------------------------------------------
 
@@ -27,13 +29,16 @@
 #include "io.h"
 #include "keysig.h"
 #include "layer.h"
+#include "layoutcache.h"
 #include "mdiv.h"
 #include "measure.h"
+#include "memorystats.h"
 #include "mensur.h"
 #include "metersig.h"
 #include "note.h"
 #include "page.h"
 #include "plistinterface.h"
+#include "positioninterface.h"
 #include "staff.h"
 #include "staffdef.h"
 #include "system.h"
@@ -48,22 +53,18 @@ namespace vrv {
 // Object
 //----------------------------------------------------------------------------
 
-unsigned long Object::s_objectCounter = 0;
+/** The generator for the uuids of the thread */
+thread_local std::mt19937 uuidGenerator;
+thread_local bool uuidGeneratorSeeded = false;
 
 Object::Object() : BoundingBox()
 {
     Init("m-");
-    if (s_objectCounter++ == 0) {
-        SeedUuid();
-    }
 }
 
 Object::Object(std::string classid) : BoundingBox()
 {
     Init(classid);
-    if (s_objectCounter++ == 0) {
-        SeedUuid();
-    }
 }
 
 Object *Object::Clone() const
@@ -83,6 +84,7 @@ Object::Object(const Object &object) : BoundingBox(object)
     m_interfaces = object.m_interfaces;
     m_isReferencObject = object.m_isReferencObject;
     m_isModified = true;
+    m_cachedIdx = -1;
     this->GenerateUuid();
     // For now do not copy them
     // m_uuid = object.m_uuid;
@@ -116,6 +118,7 @@ Object &Object::operator=(const Object &object)
         m_interfaces = object.m_interfaces;
         m_isReferencObject = object.m_isReferencObject;
         m_isModified = true;
+        m_cachedIdx = -1;
         this->GenerateUuid();
         // For now do now copy them
         // m_uuid = object.m_uuid;
@@ -126,9 +129,11 @@ Object &Object::operator=(const Object &object)
             for (i = 0; i < (int)object.m_children.size(); ++i) {
                 Object *current = object.m_children.at(i);
                 Object *copy = current->Clone();
-                copy->Modify();
-                copy->SetParent(this);
-                m_children.push_back(copy);
+                if (copy) {
+                    copy->Modify();
+                    copy->SetParent(this);
+                    m_children.push_back(copy);
+                }
             }
         }
     }
@@ -145,6 +150,7 @@ void Object::Init(std::string classid)
     m_parent = NULL;
     m_isAttribute = false;
     m_isModified = true;
+    m_cachedIdx = -1;
     m_classid = classid;
     m_isReferencObject = false;
     this->GenerateUuid();
@@ -270,6 +276,20 @@ int Object::GetChildCount(const ClassId classId) const
     return (int)count_if(m_children.begin(), m_children.end(), ObjectComparison(classId));
 }
 
+int Object::GetDescendantCount() const
+{
+    int count = (int)m_children.size();
+    for (auto child : m_children) count += child->GetDescendantCount();
+    return count;
+}
+
+int Object::GetDescendantCount(const ClassId classId) const
+{
+    int count = this->GetChildCount(classId);
+    for (auto child : m_children) count += child->GetDescendantCount(classId);
+    return count;
+}
+
 int Object::GetAttributes(ArrayOfStrAttr *attributes) const
 {
     assert(attributes);
@@ -483,7 +503,7 @@ bool Object::DeleteChild(Object *child)
 
 void Object::GenerateUuid()
 {
-    int nr = std::rand();
+    int nr = Object::GenerateUuidNumber();
     char str[17];
     // I do not want to use a stream for doing this!
     snprintf(str, 17, "%016d", nr);
@@ -500,11 +520,19 @@ void Object::SeedUuid(unsigned int seed)
 {
     // Init random number generator for uuids
     if (seed == 0) {
-        std::srand((unsigned int)std::time(0));
-    }
-    else {
-        std::srand(seed);
+        // Mix the thread id for threads started at the same time
+        seed = (unsigned int)std::time(0) ^ (unsigned int)std::hash<std::thread::id>()(std::this_thread::get_id());
     }
+    uuidGenerator.seed(seed);
+    uuidGeneratorSeeded = true;
+}
+
+int Object::GenerateUuidNumber()
+{
+    if (!uuidGeneratorSeeded) Object::SeedUuid();
+
+    // Keep 31 bits for a positive int
+    return (int)(uuidGenerator() >> 1);
 }
 
 void Object::SetParent(Object *parent)
@@ -554,14 +582,23 @@ void Object::ResetCachedDrawingY() const
 
 int Object::GetChildIndex(const Object *child)
 {
-    ArrayOfObjects::iterator iter;
+    assert(child);
+
+    // The cached index is still valid
+    int idx = child->m_cachedIdx;
+    if ((idx >= 0) && (idx < (int)m_children.size()) && (m_children.at(idx) == child)) {
+        return idx;
+    }
+
+    // Otherwise cache the index of all the children - backwards for returning the first position if the object
+    // appears more than once
+    idx = -1;
     int i;
-    for (iter = m_children.begin(), i = 0; iter != m_children.end(); ++iter, ++i) {
-        if (child == *iter) {
-            return i;
-        }
+    for (i = (int)m_children.size() - 1; i >= 0; --i) {
+        m_children.at(i)->m_cachedIdx = i;
+        if (child == m_children.at(i)) idx = i;
     }
-    return -1;
+    return idx;
 }
 
 void Object::Modify(bool modified)
@@ -629,6 +666,11 @@ void Object::Process(Functor *functor, FunctorParams *functorParams, Functor *en
         return;
     }
 
+    // The operation of the thread is cancelled
+    if (CancellationToken::IsCurrentCancelled()) {
+        throw CancellationException();
+    }
+
     bool processChildren = true;
     if (functor->m_visibleOnly) {
         if (this->IsEditorialElement()) {
@@ -732,6 +774,8 @@ ObjectListInterface::ObjectListInterface(const ObjectListInterface &interface)
 {
     // actually nothing to do, we just don't want the list to be copied
     m_list.clear();
+    m_listIndex.clear();
+    m_listLastIndex.clear();
 }
 
 ObjectListInterface &ObjectListInterface::operator=(const ObjectListInterface &interface)
@@ -739,6 +783,8 @@ ObjectListInterface &ObjectListInterface::operator=(const ObjectListInterface &i
     // actually nothing to do, we just don't want the list to be copied
     if (this != &interface) {
         this->m_list.clear();
+        this->m_listIndex.clear();
+        this->m_listLastIndex.clear();
     }
     return *this;
 }
@@ -754,6 +800,16 @@ void ObjectListInterface::ResetList(Object *node)
     m_list.clear();
     node->FillFlatList(&m_list);
     this->FilterList(&m_list);
+
+    m_listIndex.clear();
+    m_listLastIndex.clear();
+    int i;
+    for (i = 0; i < (int)m_list.size(); ++i) {
+        // keep the first position if an object appears more than once and the last one separately
+        if (!m_listIndex.insert(std::make_pair(m_list.at(i), i)).second) {
+            m_listLastIndex[m_list.at(i)] = i;
+        }
+    }
 }
 
 const ListOfObjects *ObjectListInterface::GetList(Object *node)
@@ -764,32 +820,25 @@ const ListOfObjects *ObjectListInterface::GetList(Object *node)
 
 int ObjectListInterface::GetListIndex(const Object *listElement)
 {
-    ListOfObjects::iterator iter;
-    int i;
-    for (iter = m_list.begin(), i = 0; iter != m_list.end(); ++iter, ++i) {
-        if (listElement == *iter) {
-            return i;
-        }
-    }
-    return -1;
+    auto iter = m_listIndex.find(listElement);
+    if (iter == m_listIndex.end()) return -1;
+    return iter->second;
 }
 
 Object *ObjectListInterface::GetListFirst(const Object *startFrom, const ClassId classId)
 {
-    ListOfObjects::iterator it = m_list.begin();
     int idx = GetListIndex(startFrom);
     if (idx == -1) return NULL;
-    std::advance(it, idx);
+    ListOfObjects::iterator it = m_list.begin() + idx;
     it = std::find_if(it, m_list.end(), ObjectComparison(classId));
     return (it == m_list.end()) ? NULL : *it;
 }
 
 Object *ObjectListInterface::GetListFirstBackward(Object *startFrom, const ClassId classId)
 {
-    ListOfObjects::iterator it = m_list.begin();
     int idx = GetListIndex(startFrom);
     if (idx == -1) return NULL;
-    std::advance(it, idx);
+    ListOfObjects::iterator it = m_list.begin() + idx;
     ListOfObjects::reverse_iterator rit(it);
     rit = std::find_if(rit, m_list.rend(), ObjectComparison(classId));
     return (rit == m_list.rend()) ? NULL : *rit;
@@ -797,36 +846,18 @@ Object *ObjectListInterface::GetListFirstBackward(Object *startFrom, const Class
 
 Object *ObjectListInterface::GetListPrevious(Object *listElement)
 {
-    ListOfObjects::iterator iter;
-    int i;
-    for (iter = m_list.begin(), i = 0; iter != m_list.end(); ++iter, ++i) {
-        if (listElement == *iter) {
-            if (i > 0) {
-                return *(--iter);
-            }
-            else {
-                return NULL;
-            }
-        }
-    }
-    return NULL;
+    int idx = GetListIndex(listElement);
+    if (idx <= 0) return NULL;
+    return m_list.at(idx - 1);
 }
 
 Object *ObjectListInterface::GetListNext(Object *listElement)
 {
-    ListOfObjects::reverse_iterator iter;
-    int i;
-    for (iter = m_list.rbegin(), i = 0; iter != m_list.rend(); ++iter, ++i) {
-        if (listElement == *iter) {
-            if (i > 0) {
-                return *(--iter);
-            }
-            else {
-                return NULL;
-            }
-        }
-    }
-    return NULL;
+    // Use the last position as when looking for the object from the end of the list
+    auto iter = m_listLastIndex.find(listElement);
+    int idx = (iter != m_listLastIndex.end()) ? iter->second : GetListIndex(listElement);
+    if ((idx == -1) || (idx + 1 >= (int)m_list.size())) return NULL;
+    return m_list.at(idx + 1);
 }
 
 //----------------------------------------------------------------------------
@@ -1009,6 +1040,84 @@ int Object::ConvertToCastOffMensural(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Object::CalcContentHash(FunctorParams *functorParams)
+{
+    CalcContentHashParams *params = dynamic_cast<CalcContentHashParams *>(functorParams);
+    assert(params);
+
+    // The control events are positioned after the horizontal layout and do not change it
+    if (this->IsControlElement()) return FUNCTOR_SIBLINGS;
+
+    LayoutCache::Hash(params->m_hash, this->GetClassId());
+
+    // All the attributes since they can change the glyphs drawn and therefore the bounding boxes
+    // The stems, flags and dots are created from the attributes of their parent and are skipped
+    if (!this->Is({ STEM, FLAG, DOTS })) {
+        ArrayOfStrAttr attributes;
+        this->GetAttributes(&attributes);
+        ArrayOfStrAttr::iterator iter;
+        for (iter = attributes.begin(); iter != attributes.end(); ++iter) {
+            LayoutCache::Hash(params->m_hash, (*iter).first);
+            LayoutCache::Hash(params->m_hash, (*iter).second);
+        }
+    }
+
+    StemmedDrawingInterface *stemmedDrawingInterface = this->GetStemmedDrawingInterface();
+    if (stemmedDrawingInterface) {
+        LayoutCache::Hash(params->m_hash, stemmedDrawingInterface->GetDrawingStemDir());
+    }
+
+    if (this->Is(TEXT)) {
+        Text *text = dynamic_cast<Text *>(this);
+        assert(text);
+        LayoutCache::Hash(params->m_hash, UTF16to8(text->GetText()));
+    }
+    // The key signatures are drawn from values that are not attributes
+    else if (this->Is(KEYSIG)) {
+        KeySig *keySig = dynamic_cast<KeySig *>(this);
+        assert(keySig);
+        LayoutCache::Hash(params->m_hash, keySig->GetAlterationNumber());
+        LayoutCache::Hash(params->m_hash, keySig->GetAlterationType());
+        LayoutCache::Hash(params->m_hash, keySig->m_drawingCancelAccidType);
+        LayoutCache::Hash(params->m_hash, (int)keySig->m_drawingCancelAccidCount);
+        LayoutCache::Hash(params->m_hash, keySig->m_drawingShow);
+        LayoutCache::Hash(params->m_hash, keySig->m_drawingShowchange);
+    }
+
+    return FUNCTOR_CONTINUE;
+}
+
+int Object::CalcContentHashEnd(FunctorParams *functorParams)
+{
+    CalcContentHashParams *params = dynamic_cast<CalcContentHashParams *>(functorParams);
+    assert(params);
+
+    // Close the subtree so that the nesting of the objects is part of the hash
+    LayoutCache::Hash(params->m_hash, this->GetChildCount());
+
+    return FUNCTOR_CONTINUE;
+}
+
+int Object::CalcMemoryStats(FunctorParams *functorParams)
+{
+    CalcMemoryStatsParams *params = dynamic_cast<CalcMemoryStatsParams *>(functorParams);
+    assert(params);
+
+    params->m_memoryStats->AddObject(MEMORY_STATS_DOC, this);
+
+    return FUNCTOR_CONTINUE;
+}
+
+int Object::PrepareMeasureContent(FunctorParams *functorParams)
+{
+    PrepareMeasureContentParams *params = dynamic_cast<PrepareMeasureContentParams *>(functorParams);
+    assert(params);
+
+    if (params->m_currentMeasure) params->m_currentMeasure->AddContent(this);
+
+    return FUNCTOR_CONTINUE;
+}
+
 int Object::PreparePlist(FunctorParams *functorParams)
 {
     PreparePlistParams *params = dynamic_cast<PreparePlistParams *>(functorParams);
@@ -1089,6 +1198,10 @@ int Object::SetCurrentScoreDef(FunctorParams *functorParams)
     if (this->Is(MEASURE)) {
         Measure *measure = dynamic_cast<Measure *>(this);
         assert(measure);
+        // Keep the scoreDef as it is when reaching the measure
+        if (params->m_measureScoreDef && (measure == params->m_scoreDefMeasure)) {
+            *params->m_measureScoreDef = *params->m_upcomingScoreDef;
+        }
         bool systemBreak = false;
         bool scoreDefInsert = false;
         // This is the first measure of the system - more to do...
@@ -1097,7 +1210,8 @@ int Object::SetCurrentScoreDef(FunctorParams *functorParams)
             // We had a scoreDef so we need to put cautionnary values
             // This will also happend with clef in the last measure - however, the cautionnary functor will not do
             // anything then
-            if (params->m_upcomingScoreDef->m_setAsDrawing && params->m_previousMeasure) {
+            if (params->m_upcomingScoreDef->m_setAsDrawing && params->m_previousMeasure
+                && !params->m_cautionaryScoreDefDone) {
                 ScoreDef cautionaryScoreDef = *params->m_upcomingScoreDef;
                 SetCautionaryScoreDefParams setCautionaryScoreDefParams(&cautionaryScoreDef);
                 Functor setCautionaryScoreDef(&Object::SetCautionaryScoreDef);
@@ -1110,6 +1224,7 @@ int Object::SetCurrentScoreDef(FunctorParams *functorParams)
             params->m_currentSystem->GetDrawingScoreDef()->SetDrawLabels(params->m_drawLabels);
             params->m_currentSystem = NULL;
             params->m_drawLabels = false;
+            params->m_cautionaryScoreDefDone = false;
         }
         if (params->m_upcomingScoreDef->m_setAsDrawing) {
             scoreDefInsert = true;
@@ -19,10 +19,10 @@
 
 namespace vrv {
 
-std::map<int, std::string> Option::s_breaks
+const std::map<int, std::string> Option::s_breaks
     = { { BREAKS_none, "none" }, { BREAKS_auto, "auto" }, { BREAKS_encoded, "encoded" } };
 
-std::map<int, std::string> Option::s_measureNumber
+const std::map<int, std::string> Option::s_measureNumber
     = { { MEASURENUMBER_system, "system" }, { MEASURENUMBER_interval, "interval" } };
 
 //----------------------------------------------------------------------------
@@ -352,7 +352,7 @@ void OptionIntMap::CopyTo(Option *option)
     *child = *this;
 }
 
-void OptionIntMap::Init(int defaultValue, std::map<int, std::string> *values)
+void OptionIntMap::Init(int defaultValue, const std::map<int, std::string> *values)
 {
     m_value = defaultValue;
     m_defaultValue = defaultValue;
@@ -364,7 +364,7 @@ bool OptionIntMap::SetValue(std::string value)
 {
     assert(m_values);
 
-    std::map<int, std::string>::iterator it;
+    std::map<int, std::string>::const_iterator it;
     for (it = m_values->begin(); it != m_values->end(); ++it)
         if (it->second == value) {
             m_value = it->first;
@@ -406,7 +406,7 @@ std::vector<std::string> OptionIntMap::GetStrValues(bool withoutDefault) const
 
     std::vector<std::string> strValues;
     strValues.reserve(m_values->size());
-    std::map<int, std::string>::iterator it;
+    std::map<int, std::string>::const_iterator it;
     for (it = m_values->begin(); it != m_values->end(); ++it) {
         if (withoutDefault && (it->first == m_defaultValue)) {
             continue;
@@ -503,6 +503,10 @@ Options::Options()
     m_landscape.Init(false);
     this->Register(&m_landscape, "landscape", &m_general);
 
+    m_logMaxCount.SetInfo("Log max count", "The maximum number of different messages logged (0 for no limit)");
+    m_logMaxCount.Init(0, 0, 1000000);
+    this->Register(&m_logMaxCount, "logMaxCount", &m_general);
+
     m_mensuralToMeasure.SetInfo("Mensural to measure", "Convert mensural sections to measure-based MEI");
     m_mensuralToMeasure.Init(false);
     this->Register(&m_mensuralToMeasure, "mensuralToMeasure", &m_general);
@@ -675,6 +679,11 @@ Options::Options()
     m_mdivXPathQuery.Init("");
     this->Register(&m_mdivXPathQuery, "mdivXPathQuery", &m_selectors);
 
+    m_mdivSelectedOnly.SetInfo("Mdiv selected only",
+        "Load only the selected <mdiv> and its ancestors; the other ones are skipped and not kept in the MEI output");
+    m_mdivSelectedOnly.Init(false);
+    this->Register(&m_mdivSelectedOnly, "mdivSelectedOnly", &m_selectors);
+
     /********* The layout left margin by element *********/
 
     m_elementMargins.SetLabel("Element margins", "4-elementMargins");
@@ -824,6 +833,46 @@ Options::Options()
     m_rightMarginRightBarLine.Init(0.0, 0.0, 2.0);
     this->Register(&m_rightMarginRightBarLine, "rightMarginRightBarLine", &m_elementMargins);
 
+    /********* Performance *********/
+
+    m_performance.SetLabel("Performance options (they do not change the output)", "5-performance");
+    m_grps.push_back(&m_performance);
+
+    m_displayList.SetInfo(
+        "Display list", "Record the drawing of the SVG pages for replaying it when they are rendered again");
+    m_displayList.Init(false);
+    this->Register(&m_displayList, "displayList", &m_performance);
+
+    m_layoutCache.SetInfo(
+        "Layout cache", "Cache the horizontal layout of the measures for re-using it in later layouts");
+    m_layoutCache.Init(false);
+    this->Register(&m_layoutCache, "layoutCache", &m_performance);
+
+    m_layoutCacheFile.SetInfo(
+        "Layout cache file", "Load the measure layout cache from the file and save it back on exit (with layoutCache)");
+    m_layoutCacheFile.Init("");
+    this->Register(&m_layoutCacheFile, "layoutCacheFile", &m_performance);
+
+    m_lazyLayout.SetInfo("Lazy layout", "Cast off the pages only up to the one requested (with automatic breaks)");
+    m_lazyLayout.Init(false);
+    this->Register(&m_lazyLayout, "lazyLayout", &m_performance);
+
+    m_lazyLayoutLookAhead.SetInfo("Lazy layout look-ahead", "The number of pages cast off ahead of the one requested");
+    m_lazyLayoutLookAhead.Init(1, 0, 100);
+    this->Register(&m_lazyLayoutLookAhead, "lazyLayoutLookAhead", &m_performance);
+
+    m_lowMemory.SetInfo("Low memory", "Release the layout of the pages that are not rendered (with automatic breaks)");
+    m_lowMemory.Init(false);
+    this->Register(&m_lowMemory, "lowMemory", &m_performance);
+
+    m_renderCacheSize.SetInfo("Render cache size", "The memory budget in KB for caching the SVG of the pages rendered");
+    m_renderCacheSize.Init(0, 0, 1048576);
+    this->Register(&m_renderCacheSize, "renderCacheSize", &m_performance);
+
+    m_traceFile.SetInfo("Trace file", "Write a Chrome trace event file with the time spent in each stage");
+    m_traceFile.Init("");
+    this->Register(&m_traceFile, "traceFile", &m_performance);
+
     /*
     // Example of a staffRel param
     OptionStaffrel rel;
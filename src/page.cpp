@@ -15,8 +15,12 @@
 
 #include "attcomparison.h"
 #include "bboxdevicecontext.h"
+#include "displaylistdevicecontext.h"
 #include "doc.h"
 #include "functorparams.h"
+#include "layoutcache.h"
+#include "measure.h"
+#include "memorystats.h"
 #include "pages.h"
 #include "pgfoot.h"
 #include "pgfoot2.h"
@@ -35,10 +39,15 @@ namespace vrv {
 
 Page::Page() : Object("page-")
 {
+    m_displayList = NULL;
+
     Reset();
 }
 
-Page::~Page() {}
+Page::~Page()
+{
+    ResetDisplayList();
+}
 
 void Page::Reset()
 {
@@ -46,6 +55,8 @@ void Page::Reset()
 
     m_drawingScoreDef.Reset();
     m_layoutDone = false;
+    m_layoutReleased = false;
+    ResetDisplayList();
     this->ResetUuid();
 
     // by default we have no values and use the document ones
@@ -76,7 +87,8 @@ void Page::AddChild(Object *child)
 RunningElement *Page::GetHeader() const
 {
     Doc *doc = dynamic_cast<Doc *>(this->GetFirstParent(DOC));
-    if (!doc || doc->GetOptions()->m_noHeader.GetValue()) {
+    // No running elements on excerpts (see Doc::CastOffExcerpt)
+    if (!doc || doc->GetOptions()->m_noHeader.GetValue() || (doc->GetExcerptPage() == this)) {
         return NULL;
     }
 
@@ -95,7 +107,8 @@ RunningElement *Page::GetHeader() const
 RunningElement *Page::GetFooter() const
 {
     Doc *doc = dynamic_cast<Doc *>(this->GetFirstParent(DOC));
-    if (!doc || doc->GetOptions()->m_noFooter.GetValue()) {
+    // No running elements on excerpts (see Doc::CastOffExcerpt)
+    if (!doc || doc->GetOptions()->m_noFooter.GetValue() || (doc->GetExcerptPage() == this)) {
         return NULL;
     }
 
@@ -111,6 +124,57 @@ RunningElement *Page::GetFooter() const
     }
 }
 
+void Page::ResetLayout()
+{
+    m_layoutDone = false;
+    ResetDisplayList();
+}
+
+void Page::ReleaseLayout()
+{
+    if (m_layoutReleased) return;
+
+    Functor resetHorizontalAlignment(&Object::ResetHorizontalAlignment);
+    this->Process(&resetHorizontalAlignment, NULL);
+
+    Functor resetVerticalAlignment(&Object::ResetVerticalAlignment);
+    this->Process(&resetVerticalAlignment, NULL);
+
+    AttComparison matchType(MEASURE);
+    ArrayOfObjects measures;
+    this->FindAllChildByAttComparison(&measures, &matchType);
+    for (auto &object : measures) {
+        Measure *measure = dynamic_cast<Measure *>(object);
+        assert(measure);
+        measure->ReleaseAlignments();
+    }
+
+    this->ResetLayout();
+    m_layoutReleased = true;
+}
+
+DisplayListDeviceContext *Page::GetDisplayList(uint64_t key) const
+{
+    if (!m_displayList || (m_displayListKey != key)) return NULL;
+    return m_displayList;
+}
+
+void Page::SetDisplayList(DisplayListDeviceContext *displayList, uint64_t key)
+{
+    ResetDisplayList();
+    m_displayList = displayList;
+    m_displayListKey = key;
+}
+
+void Page::ResetDisplayList()
+{
+    if (m_displayList) {
+        delete m_displayList;
+        m_displayList = NULL;
+    }
+    m_displayListKey = 0;
+}
+
 void Page::LayOut(bool force)
 {
     if (m_layoutDone && !force) {
@@ -120,6 +184,8 @@ void Page::LayOut(bool force)
         return;
     }
 
+    this->ResetDisplayList();
+
     this->LayOutHorizontally();
     this->JustifyHorizontally();
     this->LayOutVertically();
@@ -133,6 +199,9 @@ void Page::LayOutTranscription(bool force)
         return;
     }
 
+    this->ResetDisplayList();
+    m_layoutReleased = false;
+
     Doc *doc = dynamic_cast<Doc *>(GetFirstParent(DOC));
     assert(doc);
 
@@ -199,11 +268,15 @@ void Page::LayOutTranscription(bool force)
     m_layoutDone = true;
 }
 
-void Page::LayOutHorizontally()
+void Page::LayOutHorizontally(bool useCastOffLayout, int longestActualDur)
 {
+    TraceSpan traceSpan("LayOutHorizontally", "page", this->GetTracePageNumber());
+
     Doc *doc = dynamic_cast<Doc *>(GetFirstParent(DOC));
     assert(doc);
 
+    m_layoutReleased = false;
+
     // Doc::SetDrawingPage should have been called before
     // Make sure we have the correct page
     assert(this == doc->GetDrawingPage());
@@ -235,16 +308,8 @@ void Page::LayOutHorizontally()
     // Unless duration-based spacing is disabled, set the X position of each Alignment.
     // Does non-linear spacing based on the duration space between two Alignment objects.
     if (!doc->GetOptions()->m_evenNoteSpacing.GetValue()) {
-        int longestActualDur = DUR_4;
         // Get the longest duration in the piece
-        AttDurExtreme durExtremeComparison(LONGEST);
-        Object *longestDur = this->FindChildExtremeByAttComparison(&durExtremeComparison);
-        if (longestDur) {
-            DurationInterface *interface = longestDur->GetDurationInterface();
-            assert(interface);
-            longestActualDur = interface->GetActualDur();
-            // LogDebug("Longest duration is DUR_* code %d", longestActualDur);
-        }
+        if (longestActualDur == VRV_UNSET) longestActualDur = this->GetLongestActualDur();
 
         Functor setAlignmentX(&Object::SetAlignmentXPos);
         SetAlignmentXPosParams setAlignmentXPosParams(doc, &setAlignmentX);
@@ -269,6 +334,25 @@ void Page::LayOutHorizontally()
     Functor calcDots(&Object::CalcDots);
     this->Process(&calcDots, &calcDotsParams);
 
+    // When re-flowing the document, the positions calculated below are the ones stored by Doc::CastOffDoc
+    if (useCastOffLayout && this->RestoreCastOffLayout()) {
+        AlignMeasuresParams alignMeasuresParams;
+        Functor alignMeasures(&Object::AlignMeasures);
+        Functor alignMeasuresEnd(&Object::AlignMeasuresEnd);
+        this->Process(&alignMeasures, &alignMeasuresParams, &alignMeasuresEnd);
+        return;
+    }
+
+    // Restore the adjustment of the measures found in the layout cache
+    // The measures restored are skipped by the bounding box rendering and by the four adjustment functors below
+    LayoutCache *layoutCache = doc->GetOptions()->m_layoutCache.GetValue() ? doc->GetLayoutCache() : NULL;
+    Functor cacheHorizontalLayout(&Object::CacheHorizontalLayout);
+    CacheHorizontalLayoutParams cacheHorizontalLayoutParams(
+        layoutCache, layoutCache ? LayoutCache::CalcContextHash(doc) : 0, doc);
+    if (layoutCache) {
+        this->Process(&cacheHorizontalLayout, &cacheHorizontalLayoutParams);
+    }
+
     // Render it for filling the bounding box
     View view;
     view.SetDoc(doc);
@@ -277,6 +361,11 @@ void Page::LayOutHorizontally()
     view.SetPage(this->GetIdx(), false);
     view.DrawCurrentPage(&bBoxDC, false);
 
+    // Restore the values of the measures that were drawn again
+    if (layoutCache) {
+        this->Process(&cacheHorizontalLayout, &cacheHorizontalLayoutParams);
+    }
+
     // Adjust the x position of the LayerElement where multiple layer collide
     // Look at each LayerElement and change the m_xShift if the bounding box is overlapping
     Functor adjustLayers(&Object::AdjustLayers);
@@ -303,6 +392,13 @@ void Page::LayOutHorizontally()
         doc, &adjustGraceXPos, &adjustGraceXPosEnd, doc->m_scoreDef.GetStaffNs());
     this->Process(&adjustGraceXPos, &adjustGraceXPosParams, &adjustGraceXPosEnd);
 
+    // Store the adjustment of the measures not restored from the layout cache
+    if (layoutCache) {
+        cacheHorizontalLayoutParams.m_restore = false;
+        this->Process(&cacheHorizontalLayout, &cacheHorizontalLayoutParams);
+        TraceCounter("LayoutCacheRestored", cacheHorizontalLayoutParams.m_restoredCount);
+    }
+
     // We need to populate processing lists for processing the document by Layer (for matching @tie) and
     // by Verse (for matching syllable connectors)
     PrepareProcessingListsParams prepareProcessingListsParams;
@@ -324,11 +420,43 @@ void Page::LayOutHorizontally()
     this->Process(&alignMeasures, &alignMeasuresParams, &alignMeasuresEnd);
 }
 
+int Page::GetTracePageNumber() const
+{
+    if (!TraceRecorder::GetCurrent() || !this->GetParent()) return 0;
+
+    return this->GetIdx() + 1;
+}
+
+bool Page::RestoreCastOffLayout()
+{
+    AttComparison matchType(MEASURE);
+    ArrayOfObjects measures;
+    this->FindAllChildByAttComparison(&measures, &matchType);
+
+    ArrayOfObjects::iterator iter;
+    for (iter = measures.begin(); iter != measures.end(); ++iter) {
+        Measure *measure = dynamic_cast<Measure *>(*iter);
+        assert(measure);
+        if (!measure->RestoreCastOffLayout(true)) return false;
+    }
+    for (iter = measures.begin(); iter != measures.end(); ++iter) {
+        Measure *measure = dynamic_cast<Measure *>(*iter);
+        assert(measure);
+        measure->RestoreCastOffLayout(false);
+    }
+
+    return true;
+}
+
 void Page::LayOutVertically()
 {
+    TraceSpan traceSpan("LayOutVertically", "page", this->GetTracePageNumber());
+
     Doc *doc = dynamic_cast<Doc *>(GetFirstParent(DOC));
     assert(doc);
 
+    m_layoutReleased = false;
+
     // Doc::SetDrawingPage should have been called before
     // Make sure we have the correct page
     assert(this == doc->GetDrawingPage());
@@ -407,6 +535,8 @@ void Page::LayOutVertically()
 
 void Page::JustifyHorizontally()
 {
+    TraceSpan traceSpan("JustifyHorizontally", "page", this->GetTracePageNumber());
+
     Doc *doc = dynamic_cast<Doc *>(GetFirstParent(DOC));
     assert(doc);
 
@@ -428,6 +558,8 @@ void Page::JustifyHorizontally()
 
 void Page::LayOutPitchPos()
 {
+    this->ResetDisplayList();
+
     Doc *doc = dynamic_cast<Doc *>(GetFirstParent(DOC));
     assert(doc);
 
@@ -487,6 +619,20 @@ int Page::GetContentWidth() const
     return first->m_drawingTotalWidth + first->m_systemLeftMar + first->m_systemRightMar;
 }
 
+int Page::GetLongestActualDur()
+{
+    int longestActualDur = DUR_4;
+    AttDurExtreme durExtremeComparison(LONGEST);
+    Object *longestDur = this->FindChildExtremeByAttComparison(&durExtremeComparison);
+    if (longestDur) {
+        DurationInterface *interface = longestDur->GetDurationInterface();
+        assert(interface);
+        longestActualDur = interface->GetActualDur();
+        // LogDebug("Longest duration is DUR_* code %d", longestActualDur);
+    }
+    return longestActualDur;
+}
+
 void Page::AdjustSylSpacingByVerse(PrepareProcessingListsParams &listsParams, Doc *doc)
 {
     IntTree_t::iterator staves;
@@ -606,4 +752,16 @@ int Page::AlignSystems(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Page::CalcMemoryStats(FunctorParams *functorParams)
+{
+    CalcMemoryStatsParams *params = dynamic_cast<CalcMemoryStatsParams *>(functorParams);
+    assert(params);
+
+    if (m_displayList) {
+        params->m_memoryStats->Add(MEMORY_STATS_CACHE, "DisplayList", 1, m_displayList->GetMemorySize());
+    }
+
+    return Object::CalcMemoryStats(functorParams);
+}
+
 } // namespace vrv
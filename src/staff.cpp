@@ -21,6 +21,7 @@
 #include "keysig.h"
 #include "layer.h"
 #include "measure.h"
+#include "memorystats.h"
 #include "note.h"
 #include "page.h"
 #include "staffdef.h"
@@ -283,6 +284,25 @@ int Staff::ApplyPPUFactor(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Staff::CalcMemoryStats(FunctorParams *functorParams)
+{
+    CalcMemoryStatsParams *params = dynamic_cast<CalcMemoryStatsParams *>(functorParams);
+    assert(params);
+
+    for (ArrayOfLedgerLines *lines :
+        { m_ledgerLinesAbove, m_ledgerLinesBelow, m_ledgerLinesAboveCue, m_ledgerLinesBelowCue }) {
+        if (!lines) continue;
+        // Each dash is a node of a std::list
+        size_t bytes = sizeof(ArrayOfLedgerLines) + lines->capacity() * sizeof(LedgerLine);
+        for (auto &line : *lines) {
+            bytes += line.m_dashes.size() * (sizeof(std::pair<int, int>) + 2 * sizeof(void *));
+        }
+        params->m_memoryStats->Add(MEMORY_STATS_LAYOUT, "LedgerLine", (int)lines->size(), bytes);
+    }
+
+    return Object::CalcMemoryStats(functorParams);
+}
+
 int Staff::AlignHorizontally(FunctorParams *functorParams)
 {
     AlignHorizontallyParams *params = dynamic_cast<AlignHorizontallyParams *>(functorParams);
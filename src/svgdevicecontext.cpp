@@ -17,6 +17,7 @@
 #include "floatingobject.h"
 #include "glyph.h"
 #include "layerelement.h"
+#include "memorystats.h"
 #include "staff.h"
 #include "staffdef.h"
 #include "view.h"
@@ -48,6 +49,8 @@ SvgDeviceContext::SvgDeviceContext() : DeviceContext()
 
     m_mmOutput = false;
 
+    m_memoryStats = NULL;
+
     // create the initial SVG element
     // width and height need to be set later; these are taken care of in "commit"
     m_svgNode = m_svgDoc.append_child("svg");
@@ -63,7 +66,11 @@ SvgDeviceContext::SvgDeviceContext() : DeviceContext()
     m_outdata.clear();
 }
 
-SvgDeviceContext::~SvgDeviceContext() {}
+SvgDeviceContext::~SvgDeviceContext()
+{
+    // The DOM is complete and still alive here whatever the method that rendered the SVG
+    if (m_memoryStats) m_memoryStats->SetXml("SvgDeviceContext", m_svgDoc);
+}
 
 bool SvgDeviceContext::CopyFileToStream(const std::string &filename, std::ostream &dest)
 {
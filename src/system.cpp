@@ -21,6 +21,7 @@
 #include "functorparams.h"
 #include "layer.h"
 #include "measure.h"
+#include "memorystats.h"
 #include "page.h"
 #include "pages.h"
 #include "section.h"
@@ -73,6 +74,8 @@ void System::Reset()
     m_drawingJustifiableWidth = 0;
     m_drawingLabelsWidth = 0;
     m_drawingAbbrLabelsWidth = 0;
+    m_castOffYRel = 0;
+    m_castOffHeight = 0;
 }
 
 void System::AddChild(Object *child)
@@ -135,6 +138,12 @@ int System::GetHeight() const
     return 0;
 }
 
+void System::StoreCastOffLayout()
+{
+    m_castOffYRel = this->GetDrawingYRel();
+    m_castOffHeight = this->GetHeight();
+}
+
 void System::SetDrawingLabelsWidth(int width)
 {
     if (m_drawingLabelsWidth < width) {
@@ -263,6 +272,16 @@ int System::ApplyPPUFactor(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int System::CalcMemoryStats(FunctorParams *functorParams)
+{
+    CalcMemoryStatsParams *params = dynamic_cast<CalcMemoryStatsParams *>(functorParams);
+    assert(params);
+
+    params->m_memoryStats->AddObjectTree(MEMORY_STATS_LAYOUT, &m_systemAligner);
+
+    return Object::CalcMemoryStats(functorParams);
+}
+
 int System::AlignHorizontally(FunctorParams *functorParams)
 {
     AlignHorizontallyParams *params = dynamic_cast<AlignHorizontallyParams *>(functorParams);
@@ -484,13 +503,13 @@ int System::CastOffPages(FunctorParams *functorParams)
         currentShift += params->m_pgHead2Height + params->m_pgFoot2Height;
     }
 
-    if ((params->m_currentPage->GetChildCount() > 0) && (this->m_drawingYRel - this->GetHeight() - currentShift < 0)) {
+    if ((params->m_currentPage->GetChildCount() > 0) && (m_castOffYRel - m_castOffHeight - currentShift < 0)) {
         params->m_currentPage = new Page();
         // Use VRV_UNSET value as a flag
         params->m_pgHeadHeight = VRV_UNSET;
         assert(params->m_doc->GetPages());
         params->m_doc->GetPages()->AddChild(params->m_currentPage);
-        params->m_shift = this->m_drawingYRel - params->m_pageHeight;
+        params->m_shift = m_castOffYRel - params->m_pageHeight;
     }
 
     // Special case where we use the Relinquish method.
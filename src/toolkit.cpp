@@ -9,22 +9,28 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
+#include <memory>
+#include <string.h>
 
 //----------------------------------------------------------------------------
 
 #include "attcomparison.h"
+#include "displaylistdevicecontext.h"
 #include "functorparams.h"
 #include "iodarms.h"
 #include "iohumdrum.h"
 #include "iomei.h"
 #include "iomusxml.h"
 #include "iopae.h"
+#include "iosnapshot.h"
 #include "layer.h"
 #include "measure.h"
 #include "note.h"
 #include "options.h"
 #include "page.h"
+#include "pages.h"
 #include "slur.h"
 #include "svgdevicecontext.h"
 #include "vrv.h"
@@ -45,8 +51,6 @@ const char *UTF_16_LE_BOM = "\xFF\xFE";
 // Toolkit
 //----------------------------------------------------------------------------
 
-char *Toolkit::m_humdrumBuffer = NULL;
-
 Toolkit::Toolkit(bool initFont)
 {
     m_scale = DEFAULT_SCALE;
@@ -56,35 +60,52 @@ Toolkit::Toolkit(bool initFont)
     m_scoreBasedMei = false;
 
     m_humdrumBuffer = NULL;
-    m_cString = NULL;
+    m_cString = "[unspecified]";
+
+    m_renderCacheOptionsHash = 0;
+    m_renderCacheModificationCount = 0;
+    this->ResetRenderCache();
 
+    m_resources = *Resources::GetCurrent();
     if (initFont) {
+        ResourcesScope resourcesScope(&m_resources);
         Resources::InitFonts();
     }
 
     m_options = m_doc.GetOptions();
+    m_logSink.SetMaxCount(m_options->m_logMaxCount.GetValue());
+
+    m_doc.SetLayoutCache(&m_layoutCache);
 }
 
 Toolkit::~Toolkit()
 {
+    if (!m_layoutCacheFile.empty() && m_layoutCache.IsModified()) {
+        m_layoutCache.Save(m_layoutCacheFile);
+    }
+
     if (m_humdrumBuffer) {
         free(m_humdrumBuffer);
         m_humdrumBuffer = NULL;
     }
-    if (m_cString) {
-        free(m_cString);
-        m_cString = NULL;
-    }
 }
 
 bool Toolkit::SetResourcePath(const std::string &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     Resources::SetPath(path);
     return Resources::InitFonts();
 }
 
 bool Toolkit::SetScale(int scale)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     if (scale < MIN_SCALE || scale > MAX_SCALE) {
         LogError("Scale out of bounds; default is %d, minimum is %d, and maximum is %d", DEFAULT_SCALE, MIN_SCALE,
             MAX_SCALE);
@@ -96,6 +117,10 @@ bool Toolkit::SetScale(int scale)
 
 bool Toolkit::SetOutputFormat(std::string const &outformat)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     if ((outformat == "humdrum") || (outformat == "hum")) {
         m_outformat = HUMDRUM;
     }
@@ -108,8 +133,11 @@ bool Toolkit::SetOutputFormat(std::string const &outformat)
     else if (outformat == "timemap") {
         m_outformat = TIMEMAP;
     }
+    else if (outformat == "snapshot") {
+        m_outformat = SNAPSHOT;
+    }
     else if (outformat != "svg") {
-        LogError("Output format can only be: mei, humdrum, midi, timemap or svg");
+        LogError("Output format can only be: mei, humdrum, midi, timemap, snapshot or svg");
         return false;
     }
     return true;
@@ -117,6 +145,10 @@ bool Toolkit::SetOutputFormat(std::string const &outformat)
 
 bool Toolkit::SetFormat(std::string const &informat)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     if (informat == "pae") {
         m_format = PAE;
     }
@@ -141,11 +173,14 @@ bool Toolkit::SetFormat(std::string const &informat)
     else if (informat == "esac") {
         m_format = ESAC;
     }
+    else if (informat == "snapshot") {
+        m_format = SNAPSHOT;
+    }
     else if (informat == "auto") {
         m_format = AUTO;
     }
     else {
-        LogError("Input format can only be: mei, humdrum, pae, musicxml or darms");
+        LogError("Input format can only be: mei, humdrum, pae, musicxml, darms or snapshot");
         return false;
     }
     return true;
@@ -163,6 +198,9 @@ FileFormat Toolkit::IdentifyInputFormat(const string &data)
     if (data.size() == 0) {
         return UNKNOWN;
     }
+    if (SnapshotInput::IsSnapshot(data)) {
+        return SNAPSHOT;
+    }
     if (data[0] == 0) {
         return UNKNOWN;
     }
@@ -233,11 +271,16 @@ FileFormat Toolkit::IdentifyInputFormat(const string &data)
 
 bool Toolkit::LoadFile(const std::string &filename)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     if (IsUTF16(filename)) {
         return LoadUTF16File(filename);
     }
 
-    std::ifstream in(filename.c_str());
+    // Read in binary mode since the file can be a snapshot
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
     if (!in.is_open()) {
         return false;
     }
@@ -306,8 +349,24 @@ bool Toolkit::LoadUTF16File(const std::string &filename)
 
 bool Toolkit::LoadData(const std::string &data)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+    // The log of the previous data is cleared with its duplicates and suppressed messages
+    m_logSink.Reset();
+    m_logSink.SetMaxCount(m_options->m_logMaxCount.GetValue());
+
+    // The music font of the options is the one of this toolkit only
+    if (!Resources::SetFont(m_options->m_font.GetValue())) {
+        LogError("Font '%s' could not be loaded", m_options->m_font.GetValue().c_str());
+        return false;
+    }
+    TraceRecorderScope traceRecorderScope(this->GetTraceRecorder());
+    TraceSpan traceSpan("LoadData");
+
     string newData;
-    FileInputStream *input = NULL;
+    // The input streams are deleted if the loading is cancelled
+    std::unique_ptr<FileInputStream> input;
 
     auto inputFormat = m_format;
     if (inputFormat == AUTO) {
@@ -316,7 +375,7 @@ bool Toolkit::LoadData(const std::string &data)
 
     if (inputFormat == PAE) {
 #ifndef NO_PAE_SUPPORT
-        input = new PaeInput(&m_doc, "");
+        input.reset(new PaeInput(&m_doc, ""));
 #else
         LogError("Plaine & Easie import is not supported in this build.");
         return false;
@@ -324,7 +383,7 @@ bool Toolkit::LoadData(const std::string &data)
     }
     else if (inputFormat == DARMS) {
 #ifndef NO_DARMS_SUPPORT
-        input = new DarmsInput(&m_doc, "");
+        input.reset(new DarmsInput(&m_doc, ""));
 #else
         LogError("DARMS import is not supported in this build.");
         return false;
@@ -336,14 +395,13 @@ bool Toolkit::LoadData(const std::string &data)
 
         Doc tempdoc;
         tempdoc.SetOptions(m_doc.GetOptions());
-        HumdrumInput *tempinput = new HumdrumInput(&tempdoc, "");
+        std::unique_ptr<HumdrumInput> tempinput(new HumdrumInput(&tempdoc, ""));
         if (GetOutputFormat() == HUMDRUM) {
             tempinput->SetOutputFormat("humdrum");
         }
 
         if (!tempinput->ImportString(data)) {
             LogError("Error importing Humdrum data");
-            delete tempinput;
             return false;
         }
 
@@ -356,17 +414,21 @@ bool Toolkit::LoadData(const std::string &data)
         MeiOutput meioutput(&tempdoc, "");
         meioutput.SetScoreBasedMEI(true);
         newData = meioutput.GetOutput();
-        delete tempinput;
 
-        input = new MeiInput(&m_doc, "");
+        input.reset(new MeiInput(&m_doc, ""));
     }
 #endif
     else if (inputFormat == MEI) {
-        input = new MeiInput(&m_doc, "");
+        input.reset(new MeiInput(&m_doc, ""));
+    }
+    else if (inputFormat == SNAPSHOT) {
+        SnapshotInput *snapshotInput = new SnapshotInput(&m_doc, "");
+        snapshotInput->SetOptionsHash(this->CalcOptionsHash());
+        input.reset(snapshotInput);
     }
     else if (inputFormat == MUSICXML) {
         // This is the direct converter from MusicXML to MEI using iomusicxml:
-        input = new MusicXmlInput(&m_doc, "");
+        input.reset(new MusicXmlInput(&m_doc, ""));
     }
 #ifndef NO_HUMDRUM_SUPPORT
     else if (inputFormat == MUSICXMLHUM) {
@@ -386,17 +448,15 @@ bool Toolkit::LoadData(const std::string &data)
         // Now convert Humdrum into MEI:
         Doc tempdoc;
         tempdoc.SetOptions(m_doc.GetOptions());
-        FileInputStream *tempinput = new HumdrumInput(&tempdoc, "");
+        std::unique_ptr<FileInputStream> tempinput(new HumdrumInput(&tempdoc, ""));
         if (!tempinput->ImportString(conversion.str())) {
             LogError("Error importing Humdrum data");
-            delete tempinput;
             return false;
         }
         MeiOutput meioutput(&tempdoc, "");
         meioutput.SetScoreBasedMEI(true);
         newData = meioutput.GetOutput();
-        delete tempinput;
-        input = new MeiInput(&m_doc, "");
+        input.reset(new MeiInput(&m_doc, ""));
     }
 
     else if (inputFormat == MEIHUM) {
@@ -416,17 +476,15 @@ bool Toolkit::LoadData(const std::string &data)
         // Now convert Humdrum into MEI:
         Doc tempdoc;
         tempdoc.SetOptions(m_doc.GetOptions());
-        FileInputStream *tempinput = new HumdrumInput(&tempdoc, "");
+        std::unique_ptr<FileInputStream> tempinput(new HumdrumInput(&tempdoc, ""));
         if (!tempinput->ImportString(conversion.str())) {
             LogError("Error importing Humdrum data");
-            delete tempinput;
             return false;
         }
         MeiOutput meioutput(&tempdoc, "");
         meioutput.SetScoreBasedMEI(true);
         newData = meioutput.GetOutput();
-        delete tempinput;
-        input = new MeiInput(&m_doc, "");
+        input.reset(new MeiInput(&m_doc, ""));
     }
 
     else if (inputFormat == ESAC) {
@@ -444,17 +502,15 @@ bool Toolkit::LoadData(const std::string &data)
         // Now convert Humdrum into MEI:
         Doc tempdoc;
         tempdoc.SetOptions(m_doc.GetOptions());
-        FileInputStream *tempinput = new HumdrumInput(&tempdoc, "");
+        std::unique_ptr<FileInputStream> tempinput(new HumdrumInput(&tempdoc, ""));
         if (!tempinput->ImportString(conversion.str())) {
             LogError("Error importing Humdrum data");
-            delete tempinput;
             return false;
         }
         MeiOutput meioutput(&tempdoc, "");
         meioutput.SetScoreBasedMEI(true);
         newData = meioutput.GetOutput();
-        delete tempinput;
-        input = new MeiInput(&m_doc, "");
+        input.reset(new MeiInput(&m_doc, ""));
     }
 #endif
     else {
@@ -468,10 +524,14 @@ bool Toolkit::LoadData(const std::string &data)
         return false;
     }
 
+    // The measures of the snapshot cache are deleted with the current document
+    m_snapshotCache.Clear();
+
     // load the file
+    m_xmlMemoryStats.Reset();
+    input->SetMemoryStats(&m_xmlMemoryStats);
     if (!input->ImportString(newData.size() ? newData : data)) {
         LogError("Error importing data");
-        delete input;
         return false;
     }
 
@@ -483,18 +543,36 @@ bool Toolkit::LoadData(const std::string &data)
     // generate missing measure numbers
     m_doc.GenerateMeasureNumbers();
 
-    m_doc.PrepareDrawing();
+    // load the layout cache if a new file is given - the current one is saved first
+    if (m_options->m_layoutCache.GetValue() && (m_options->m_layoutCacheFile.GetValue() != m_layoutCacheFile)) {
+        if (!m_layoutCacheFile.empty() && m_layoutCache.IsModified()) {
+            m_layoutCache.Save(m_layoutCacheFile);
+        }
+        m_layoutCacheFile = m_options->m_layoutCacheFile.GetValue();
+        if (!m_layoutCacheFile.empty()) {
+            m_layoutCache.Load(m_layoutCacheFile);
+        }
+    }
+
+    // The drawing values of a prepared snapshot are read with it
+    SnapshotInput *snapshotInput = dynamic_cast<SnapshotInput *>(input.get());
+    if (!snapshotInput || !snapshotInput->IsPrepared()) {
+        m_doc.PrepareDrawing();
+    }
 
     // Convert pseudo-measures into distinct segments based on barLine elements
     if (m_doc.IsMensuralMusicOnly()) {
         m_doc.ConvertToCastOffMensuralDoc();
     }
 
+    // The pages of a snapshot cast off with the same options are kept as they are
+    bool hasCastOffPages = (snapshotInput && snapshotInput->HasCastOffPages());
+
     // Do the layout? this depends on the options and the file. PAE and
     // DARMS have no layout information. MEI files _can_ have it, but it
     // might have been ignored because of the --breaks auto option.
     // Regardless, we won't do layout if the --breaks none option was set.
-    if (m_options->m_breaks.GetValue() != BREAKS_none) {
+    if ((m_options->m_breaks.GetValue() != BREAKS_none) && !hasCastOffPages) {
         if (input->HasLayoutInformation() && (m_options->m_breaks.GetValue() == BREAKS_encoded)) {
             // LogElapsedTimeStart();
             m_doc.CastOffEncodingDoc();
@@ -505,22 +583,43 @@ bool Toolkit::LoadData(const std::string &data)
                 LogWarning("Requesting layout with encoded breaks but nothing provided in the data");
             }
             // LogElapsedTimeStart();
-            m_doc.CastOffDoc();
+            if (m_options->m_lazyLayout.GetValue()) {
+                m_doc.CastOffDocLazy();
+                m_doc.CastOffLazyPages(1 + m_options->m_lazyLayoutLookAhead.GetValue());
+            }
+            else {
+                m_doc.CastOffDoc();
+            }
             // LogElapsedTimeEnd("layout");
         }
     }
 
-    delete input;
+    this->ReleaseLayouts(-1);
+
+    input.reset();
     m_view.SetDoc(&m_doc);
 
+    if (TraceRecorder::GetCurrent()) {
+        TraceCounter("Objects", m_doc.GetDescendantCount());
+        TraceCounter("Measures", m_doc.GetDescendantCount(MEASURE));
+        TraceCounter("Notes", m_doc.GetDescendantCount(NOTE));
+        TraceCounter("Pages", m_doc.GetPageCount());
+    }
+
     return true;
 }
 
 std::string Toolkit::GetMEI(int pageNo, bool scoreBased)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     // Page number is one-based - correct it to 0-based first
     pageNo--;
 
+    m_doc.CastOffLazyPages();
+
     MeiOutput meioutput(&m_doc, "");
     meioutput.SetScoreBasedMEI(scoreBased);
     return meioutput.GetOutput(pageNo);
@@ -528,6 +627,12 @@ std::string Toolkit::GetMEI(int pageNo, bool scoreBased)
 
 bool Toolkit::SaveFile(const std::string &filename)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
+    m_doc.CastOffLazyPages();
+
     MeiOutput meioutput(&m_doc, filename.c_str());
     meioutput.SetScoreBasedMEI(m_scoreBasedMei);
     if (!meioutput.ExportFile()) {
@@ -537,6 +642,38 @@ bool Toolkit::SaveFile(const std::string &filename)
     return true;
 }
 
+std::string Toolkit::GetSnapshot(bool withPages)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
+    m_doc.CastOffLazyPages();
+
+    SnapshotOutput snapshotOutput(&m_doc, "");
+    snapshotOutput.SetCastOffPages(withPages, this->CalcOptionsHash());
+    snapshotOutput.SetCache(&m_snapshotCache);
+    return snapshotOutput.GetOutput();
+}
+
+bool Toolkit::SaveSnapshotFile(const std::string &filename, bool withPages)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
+    m_doc.CastOffLazyPages();
+
+    SnapshotOutput snapshotOutput(&m_doc, filename);
+    snapshotOutput.SetCastOffPages(withPages, this->CalcOptionsHash());
+    snapshotOutput.SetCache(&m_snapshotCache);
+    if (!snapshotOutput.ExportFile()) {
+        LogError("Unknown error");
+        return false;
+    }
+    return true;
+}
+
 std::string Toolkit::GetOptions(bool defaultValues) const
 {
     jsonxx::Object o;
@@ -681,6 +818,10 @@ std::string Toolkit::GetAvailableOptions() const
 
 bool Toolkit::SetOptions(const std::string &json_options)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     jsonxx::Object json;
 
     // Read JSON options
@@ -820,6 +961,8 @@ bool Toolkit::SetOptions(const std::string &json_options)
         }
     }
 
+    m_logSink.SetMaxCount(m_options->m_logMaxCount.GetValue());
+
     return true;
 }
 
@@ -836,6 +979,10 @@ std::string Toolkit::GetOption(const std::string &option, bool defaultValue) con
 
 bool Toolkit::SetOption(const std::string &option, const std::string &value)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     if (m_options->GetItems()->count(option) == 0) {
         LogError("Unsupported option '%s'", option.c_str());
         return false;
@@ -847,6 +994,10 @@ bool Toolkit::SetOption(const std::string &option, const std::string &value)
 
 std::string Toolkit::GetElementAttr(const std::string &xmlId)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     jsonxx::Object o;
 
     if (!m_doc.GetDrawingPage()) return o.json();
@@ -871,8 +1022,21 @@ std::string Toolkit::GetElementAttr(const std::string &xmlId)
 
 bool Toolkit::Edit(const std::string &json_editorAction)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
 #ifdef USE_EMSCRIPTEN
 
+    // The layout kept for re-flowing the document and the display lists of the pages are not valid anymore
+    m_doc.SetModified();
+    m_doc.ResetCastOffLayout();
+    for (int i = 0; i < m_doc.GetPageCount(); ++i) {
+        Page *page = dynamic_cast<Page *>(m_doc.GetPages()->GetChild(i));
+        assert(page);
+        page->ResetDisplayList();
+    }
+
     jsonxx::Object json;
 
     // Read JSON actions
@@ -917,17 +1081,60 @@ bool Toolkit::Edit(const std::string &json_editorAction)
 
 std::string Toolkit::GetLog()
 {
-#ifdef USE_EMSCRIPTEN
-    std::string str;
-    std::vector<std::string>::iterator iter;
-    for (iter = logBuffer.begin(); iter != logBuffer.end(); ++iter) {
-        str += (*iter);
+    return m_logSink.GetLog();
+}
+
+std::string Toolkit::GetMemoryStats()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
+    MemoryStats memoryStats;
+    memoryStats.Merge(m_xmlMemoryStats);
+    CalcMemoryStatsParams calcMemoryStatsParams(&memoryStats);
+    Functor calcMemoryStats(&Object::CalcMemoryStats);
+    m_doc.Process(&calcMemoryStats, &calcMemoryStatsParams);
+
+    // The caches of the toolkit - the display lists are added by the pages
+    size_t renderCacheBytes = 0;
+    for (auto &entry : m_renderCache) {
+        renderCacheBytes += MEMORY_STATS_NODE_SIZE + sizeof(entry) + entry.second.m_svg.capacity();
+    }
+    memoryStats.Add(MEMORY_STATS_CACHE, "RenderCache", (int)m_renderCache.size(), renderCacheBytes);
+    memoryStats.Add(
+        MEMORY_STATS_CACHE, "LayoutCache", m_layoutCache.GetEntryCount(), m_layoutCache.GetMemorySize());
+    memoryStats.Add(
+        MEMORY_STATS_CACHE, "SnapshotCache", m_snapshotCache.GetMeasureCount(), m_snapshotCache.GetMemorySize());
+    memoryStats.Add(
+        MEMORY_STATS_CACHE, "TraceRecorder", m_traceRecorder.GetEventCount(), m_traceRecorder.GetMemorySize());
+
+    jsonxx::Object o;
+    size_t totalBytes = 0;
+    std::pair<MemoryStatsGroup, std::string> groups[] = { { MEMORY_STATS_DOC, "doc" },
+        { MEMORY_STATS_LAYOUT, "layout" }, { MEMORY_STATS_XML, "xml" }, { MEMORY_STATS_CACHE, "cache" } };
+    for (auto &group : groups) {
+        jsonxx::Object classes;
+        int count = 0;
+        size_t bytes = 0;
+        for (auto &entry : *memoryStats.GetEntries(group.first)) {
+            jsonxx::Object stats;
+            stats << "count" << entry.second.m_count;
+            stats << "bytes" << (double)entry.second.m_bytes;
+            classes << entry.first << stats;
+            count += entry.second.m_count;
+            bytes += entry.second.m_bytes;
+        }
+        jsonxx::Object grp;
+        grp << "classes" << classes;
+        grp << "count" << count;
+        grp << "bytes" << (double)bytes;
+        o << group.second << grp;
+        totalBytes += bytes;
     }
-    return str;
-#else
-    // The non-js version of the app should not use this function.
-    return "";
-#endif
+    o << "bytes" << (double)totalBytes;
+
+    return o.json();
 }
 
 std::string Toolkit::GetVersion()
@@ -937,23 +1144,45 @@ std::string Toolkit::GetVersion()
 
 void Toolkit::ResetLogBuffer()
 {
-#ifdef USE_EMSCRIPTEN
-    vrv::logBuffer.clear();
-#endif
+    m_logSink.Reset();
 }
 
 void Toolkit::RedoLayout()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+    TraceRecorderScope traceRecorderScope(this->GetTraceRecorder());
+    TraceSpan traceSpan("RedoLayout");
+
     if (m_doc.GetType() == Transcription) {
         return;
     }
 
+    // No need to redo the full layout if only the page size or margins changed
+    if (m_doc.ReflowDoc()) {
+        this->ReleaseLayouts(-1);
+        return;
+    }
+
     m_doc.UnCastOffDoc();
-    m_doc.CastOffDoc();
+    if (m_options->m_lazyLayout.GetValue()) {
+        m_doc.CastOffDocLazy();
+        m_doc.CastOffLazyPages(1 + m_options->m_lazyLayoutLookAhead.GetValue());
+    }
+    else {
+        m_doc.CastOffDoc();
+    }
+
+    this->ReleaseLayouts(-1);
 }
 
 void Toolkit::RedoPagePitchPosLayout()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     Page *page = m_doc.GetDrawingPage();
 
     if (!page) {
@@ -962,22 +1191,46 @@ void Toolkit::RedoPagePitchPosLayout()
     }
 
     page->LayOutPitchPos();
+    m_doc.SetModified();
 }
 
 bool Toolkit::RenderToDeviceContext(int pageNo, DeviceContext *deviceContext)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     // Page number is one-based - correct it to 0-based first
     pageNo--;
 
+    // With the lazy layout, cast off the pages up to the one requested
+    if (m_doc.IsCastOffPending()) {
+        m_doc.CastOffLazyPages(pageNo + 1 + m_options->m_lazyLayoutLookAhead.GetValue());
+    }
+
+    if (!m_doc.HasPage(pageNo)) {
+        LogError("Page %d does not exist", pageNo + 1);
+        return false;
+    }
+
+    this->RenderPage(pageNo, deviceContext, m_options->m_adjustPageHeight.GetValue());
+
+    return true;
+}
+
+void Toolkit::RenderPage(int pageIdx, DeviceContext *deviceContext, bool adjustPageHeight)
+{
+    this->ReleaseLayouts(pageIdx);
+
     // Get the current system for the SVG clipping size
-    m_view.SetPage(pageNo);
+    m_view.SetPage(pageIdx);
 
     // Adjusting page width and height according to the options
     int width = m_options->m_pageWidth.GetUnfactoredValue();
     int height = m_options->m_pageHeight.GetUnfactoredValue();
 
     if (m_options->m_breaks.GetValue() == BREAKS_none) width = m_doc.GetAdjustedDrawingPageWidth();
-    if (m_options->m_adjustPageHeight.GetValue() || (m_options->m_breaks.GetValue() == BREAKS_none))
+    if (adjustPageHeight || (m_options->m_breaks.GetValue() == BREAKS_none))
         height = m_doc.GetAdjustedDrawingPageHeight();
 
     // set dimensions
@@ -986,31 +1239,275 @@ bool Toolkit::RenderToDeviceContext(int pageNo, DeviceContext *deviceContext)
     double userScale = m_view.GetPPUFactor() * m_scale / 100;
     deviceContext->SetUserScale(userScale, userScale);
 
-    // render the page
-    m_view.DrawCurrentPage(deviceContext, false);
+    // For SVG and with the displayList option, the drawing of the page is recorded the first time and replayed
+    // afterwards. This is not done for the excerpt page that is deleted once rendered.
+    Page *page = m_doc.GetDrawingPage();
+    if (!deviceContext->Is(SVG_DEVICE_CONTEXT) || !m_options->m_displayList.GetValue()
+        || (page == m_doc.GetExcerptPage())) {
+        // render the page
+        m_view.DrawCurrentPage(deviceContext, false);
+        return;
+    }
 
-    return true;
+    uint64_t key = this->CalcOptionsHash();
+    LayoutCache::Hash(key, (int)deviceContext->UseGlobalStyling());
+    DisplayListDeviceContext *displayList = page->GetDisplayList(key);
+    if (!displayList) {
+        // The display list is deleted if the drawing is cancelled
+        std::unique_ptr<DisplayListDeviceContext> recordedList(
+            new DisplayListDeviceContext(deviceContext->UseGlobalStyling()));
+        recordedList->SetWidth(width);
+        recordedList->SetHeight(height);
+        recordedList->SetUserScale(userScale, userScale);
+        m_view.DrawCurrentPage(recordedList.get(), false);
+        displayList = recordedList.release();
+        page->SetDisplayList(displayList, key);
+    }
+    displayList->Replay(deviceContext);
+}
+
+uint64_t Toolkit::CalcOptionsHash() const
+{
+    uint64_t hash = LayoutCache::s_hashInit;
+
+    // The performance options do not change the output
+    const std::vector<Option *> *performanceOptions = m_options->m_performance.GetOptions();
+
+    const MapOfStrOptions *items = m_options->GetItems();
+    for (auto iter = items->begin(); iter != items->end(); ++iter) {
+        if (std::find(performanceOptions->begin(), performanceOptions->end(), iter->second)
+            != performanceOptions->end()) {
+            continue;
+        }
+        LayoutCache::Hash(hash, iter->first);
+        LayoutCache::Hash(hash, iter->second->GetStrValue());
+    }
+
+    return hash;
+}
+
+void Toolkit::ReleaseLayouts(int pageIdx)
+{
+    if (!m_options->m_lowMemory.GetValue()) return;
+    if ((m_doc.GetType() == Transcription) || m_doc.IsCastOffPending()) return;
+
+    Page *activePage = NULL;
+    if (m_doc.HasPage(pageIdx)) {
+        activePage = dynamic_cast<Page *>(m_doc.GetPages()->GetChild(pageIdx));
+        assert(activePage);
+    }
+    m_doc.ReleaseLayouts(activePage);
+}
+
+void Toolkit::ValidateRenderCache()
+{
+    uint64_t optionsHash = this->CalcOptionsHash();
+    LayoutCache::Hash(optionsHash, m_scale);
+
+    if ((optionsHash != m_renderCacheOptionsHash) || (m_doc.GetModificationCount() != m_renderCacheModificationCount)) {
+        this->ResetRenderCache();
+        m_renderCacheOptionsHash = optionsHash;
+        m_renderCacheModificationCount = m_doc.GetModificationCount();
+    }
+}
+
+void Toolkit::AddToRenderCache(int key, const std::string &svg)
+{
+    int budget = m_options->m_renderCacheSize.GetValue() * 1024;
+    if ((int)svg.size() > budget) return;
+
+    while (!m_renderCache.empty() && (m_renderCacheSize + (int)svg.size() > budget)) {
+        std::map<int, RenderCacheEntry>::iterator leastRecent = m_renderCache.begin();
+        std::map<int, RenderCacheEntry>::iterator iter;
+        for (iter = m_renderCache.begin(); iter != m_renderCache.end(); ++iter) {
+            if (iter->second.m_lastUse < leastRecent->second.m_lastUse) leastRecent = iter;
+        }
+        m_renderCacheSize -= (int)leastRecent->second.m_svg.size();
+        m_renderCache.erase(leastRecent);
+    }
+
+    RenderCacheEntry &entry = m_renderCache[key];
+    entry.m_svg = svg;
+    entry.m_lastUse = ++m_renderCacheUse;
+    m_renderCacheSize += (int)svg.size();
+}
+
+void Toolkit::ResetRenderCache()
+{
+    m_renderCache.clear();
+    m_renderCacheSize = 0;
+    m_renderCacheUse = 0;
 }
 
 std::string Toolkit::RenderToSVG(int pageNo, bool xml_declaration)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+    TraceRecorderScope traceRecorderScope(this->GetTraceRecorder());
+    TraceSpan traceSpan("RenderToSVG", "page", pageNo);
+
+    int cacheKey = 2 * pageNo + (int)xml_declaration;
+    bool useRenderCache = (m_options->m_renderCacheSize.GetValue() > 0);
+    if (useRenderCache) {
+        // With the lazy layout, cast off the pages first since it modifies the document
+        if (m_doc.IsCastOffPending()) {
+            m_doc.CastOffLazyPages(pageNo + m_options->m_lazyLayoutLookAhead.GetValue());
+        }
+        this->ValidateRenderCache();
+        std::map<int, RenderCacheEntry>::iterator iter = m_renderCache.find(cacheKey);
+        if (iter != m_renderCache.end()) {
+            // Still set the page as for drawing it since the editor methods use the drawing page
+            this->ReleaseLayouts(pageNo - 1);
+            m_view.SetPage(pageNo - 1);
+            iter->second.m_lastUse = ++m_renderCacheUse;
+            return iter->second.m_svg;
+        }
+    }
+
     // Create the SVG object, h & w come from the system
     // We will need to set the size of the page after having drawn it depending on the options
     SvgDeviceContext svg;
+    svg.SetMemoryStats(&m_xmlMemoryStats);
 
     if (m_options->m_mmOutput.GetValue()) {
         svg.SetMMOutput(true);
     }
 
     // render the page
-    RenderToDeviceContext(pageNo, &svg);
+    if (!RenderToDeviceContext(pageNo, &svg)) return svg.GetStringSVG(xml_declaration);
 
     std::string out_str = svg.GetStringSVG(xml_declaration);
+    if (useRenderCache) this->AddToRenderCache(cacheKey, out_str);
     return out_str;
 }
 
+std::string Toolkit::RenderMeasureRangeToSVG(
+    const std::string &startMeasureId, const std::string &endMeasureId, bool xml_declaration)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
+    Measure *startMeasure = dynamic_cast<Measure *>(m_doc.FindChildByUuid(startMeasureId));
+    if (!startMeasure) {
+        LogError("Measure '%s' not found", startMeasureId.c_str());
+        return "";
+    }
+    Measure *endMeasure = dynamic_cast<Measure *>(m_doc.FindChildByUuid(endMeasureId));
+    if (!endMeasure) {
+        LogError("Measure '%s' not found", endMeasureId.c_str());
+        return "";
+    }
+
+    // The drawing page is set back once the excerpt page is deleted
+    Page *drawingPage = m_doc.GetDrawingPage();
+    int drawingPageIdx = (drawingPage) ? drawingPage->GetIdx() : VRV_UNSET;
+
+    if (!m_doc.CastOffExcerpt(startMeasure, endMeasure)) {
+        return "";
+    }
+
+    SvgDeviceContext svg;
+    svg.SetMemoryStats(&m_xmlMemoryStats);
+
+    if (m_options->m_mmOutput.GetValue()) {
+        svg.SetMMOutput(true);
+    }
+
+    // render the excerpt page, always with a page height adjusted to the content
+    this->RenderPage(m_doc.GetExcerptPage()->GetIdx(), &svg, true);
+
+    m_doc.UnCastOffExcerpt();
+    if (drawingPageIdx != VRV_UNSET) {
+        m_view.SetPage(drawingPageIdx);
+    }
+    else {
+        m_view.SetDoc(&m_doc);
+    }
+
+    std::string out_str = svg.GetStringSVG(xml_declaration);
+    return out_str;
+}
+
+#ifndef USE_EMSCRIPTEN
+std::future<bool> Toolkit::LoadDataAsync(const std::string &data, CancellationToken *token)
+{
+    return std::async(std::launch::async, [this, data, token]() {
+        // The lock is held until the cancelled document is reset
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        try {
+            CancellationScope cancellationScope(token);
+            return this->LoadData(data);
+        }
+        catch (CancellationException &) {
+            this->ResetCancelledDoc();
+            return false;
+        }
+    });
+}
+
+std::future<bool> Toolkit::RedoLayoutAsync(CancellationToken *token)
+{
+    return std::async(std::launch::async, [this, token]() {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        try {
+            CancellationScope cancellationScope(token);
+            this->RedoLayout();
+            return true;
+        }
+        catch (CancellationException &) {
+            LogSinkScope logSinkScope(&m_logSink);
+            LogError("Layout cancelled, it has to be done again with RedoLayout");
+            return false;
+        }
+    });
+}
+
+std::future<std::string> Toolkit::RenderToSVGAsync(int pageNo, bool xml_declaration, CancellationToken *token)
+{
+    return std::async(std::launch::async, [this, pageNo, xml_declaration, token]() {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        try {
+            CancellationScope cancellationScope(token);
+            return this->RenderToSVG(pageNo, xml_declaration);
+        }
+        catch (CancellationException &) {
+            // The layout of the page is not marked as done and is laid out again when rendered
+            LogSinkScope logSinkScope(&m_logSink);
+            LogError("Rendering cancelled");
+            return std::string();
+        }
+    });
+}
+#endif
+
+void Toolkit::ResetCancelledDoc()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
+    // The document can be partially loaded - it is left empty with no page
+    m_view.SetDoc(NULL);
+    m_doc.Reset();
+    this->ResetRenderCache();
+
+    LogError("Loading cancelled, the data has to be loaded again");
+}
+
+TraceRecorder *Toolkit::GetTraceRecorder()
+{
+    m_traceRecorder.SetFilename(m_options->m_traceFile.GetValue());
+    return (m_traceRecorder.IsEnabled()) ? &m_traceRecorder : NULL;
+}
+
 bool Toolkit::RenderToSVGFile(const std::string &filename, int pageNo)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     std::string output = RenderToSVG(pageNo, true);
 
     std::ofstream outfile;
@@ -1033,6 +1530,10 @@ std::string Toolkit::GetHumdrum()
 
 bool Toolkit::GetHumdrumFile(const std::string &filename)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     std::ofstream output;
     output.open(filename.c_str());
 
@@ -1053,6 +1554,19 @@ void Toolkit::GetHumdrum(ostream &output)
 
 std::string Toolkit::RenderToMIDI()
 {
+    std::string midi = this->RenderToMIDIRaw();
+    std::string outputstr
+        = Base64Encode(reinterpret_cast<const unsigned char *>(midi.c_str()), (unsigned int)midi.length());
+
+    return outputstr;
+}
+
+std::string Toolkit::RenderToMIDIRaw()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     MidiFile outputfile;
     outputfile.absoluteTicks();
     m_doc.ExportMIDI(&outputfile);
@@ -1060,14 +1574,16 @@ std::string Toolkit::RenderToMIDI()
 
     stringstream strstrem;
     outputfile.write(strstrem);
-    std::string outputstr = Base64Encode(
-        reinterpret_cast<const unsigned char *>(strstrem.str().c_str()), (unsigned int)strstrem.str().length());
 
-    return outputstr;
+    return strstrem.str();
 }
 
 std::string Toolkit::RenderToTimemap()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     std::string output;
     m_doc.ExportTimemap(output);
     return output;
@@ -1075,6 +1591,10 @@ std::string Toolkit::RenderToTimemap()
 
 std::string Toolkit::GetElementsAtTime(int millisec)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     jsonxx::Object o;
     jsonxx::Array a;
 
@@ -1090,6 +1610,8 @@ std::string Toolkit::GetElementsAtTime(int millisec)
         return o.json();
     }
 
+    m_doc.CastOffLazyPagesUntil(measure);
+
     int repeat = measure->EnclosesTime(millisec);
     int measureTimeOffset = measure->GetRealTimeOffsetMilliseconds(repeat);
 
@@ -1116,6 +1638,10 @@ std::string Toolkit::GetElementsAtTime(int millisec)
 
 bool Toolkit::RenderToMIDIFile(const std::string &filename)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     MidiFile outputfile;
     outputfile.absoluteTicks();
     m_doc.ExportMIDI(&outputfile);
@@ -1127,6 +1653,10 @@ bool Toolkit::RenderToMIDIFile(const std::string &filename)
 
 bool Toolkit::RenderToTimemapFile(const std::string &filename)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     std::string outputString;
     m_doc.ExportTimemap(outputString);
 
@@ -1141,15 +1671,25 @@ bool Toolkit::RenderToTimemapFile(const std::string &filename)
 
 int Toolkit::GetPageCount()
 {
-    return m_doc.GetPageCount();
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
+    // This is an estimation until all the pages are cast off with the lazy layout
+    return m_doc.GetEstimatedPageCount();
 }
 
 int Toolkit::GetPageWithElement(const std::string &xmlId)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     Object *element = m_doc.FindChildByUuid(xmlId);
     if (!element) {
         return 0;
     }
+    m_doc.CastOffLazyPagesUntil(element);
     Page *page = dynamic_cast<Page *>(element->GetFirstParent(PAGE));
     if (!page) {
         return 0;
@@ -1159,6 +1699,10 @@ int Toolkit::GetPageWithElement(const std::string &xmlId)
 
 int Toolkit::GetTimeForElement(const std::string &xmlId)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     Object *element = m_doc.FindChildByUuid(xmlId);
     int timeofElement = 0;
     if (element->Is(NOTE)) {
@@ -1182,6 +1726,10 @@ int Toolkit::GetTimeForElement(const std::string &xmlId)
 
 void Toolkit::SetHumdrumBuffer(const char *data)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LogSinkScope logSinkScope(&m_logSink);
+    ResourcesScope resourcesScope(&m_resources);
+
     if (m_humdrumBuffer) {
         free(m_humdrumBuffer);
         m_humdrumBuffer = NULL;
@@ -1263,6 +1811,7 @@ bool Toolkit::Drag(std::string elementId, int x, int y)
             = (data_PITCHNAME)m_view.CalculatePitchCode(layer, m_view.ToLogicalY(y), note->GetDrawingX(), &oct);
         note->SetPname(pname);
         note->SetOct(oct);
+        m_snapshotCache.Invalidate(note);
         return true;
     }
     return false;
@@ -1296,6 +1845,7 @@ bool Toolkit::Insert(std::string elementType, std::string startid, std::string e
         slur->SetStartid(startid);
         slur->SetEndid(endid);
         measure->AddChild(slur);
+        m_snapshotCache.Invalidate(measure);
         m_doc.PrepareDrawing();
         return true;
     }
@@ -1332,6 +1882,7 @@ bool Toolkit::Set(std::string elementId, std::string attrType, std::string attrV
     else if (Att::SetVisual(element, attrType, attrValue))
         success = true;
     if (success) {
+        m_snapshotCache.Invalidate(element);
         m_doc.PrepareDrawing();
         m_doc.GetDrawingPage()->LayOut(true);
         return true;
@@ -1378,28 +1929,27 @@ bool Toolkit::ParseSetAction(
 
 void Toolkit::SetCString(const std::string &data)
 {
-    if (m_cString) {
-        free(m_cString);
-        m_cString = NULL;
-    }
-
-    m_cString = (char *)malloc(strlen(data.c_str()) + 1);
+    m_cString = data;
+}
 
-    // something went wrong
-    if (!m_cString) {
-        return;
-    }
-    strcpy(m_cString, data.c_str());
+void Toolkit::SetCString(std::string &&data)
+{
+    m_cString = std::move(data);
 }
 
 const char *Toolkit::GetCString()
 {
-    if (m_cString) {
-        return m_cString;
-    }
-    else {
-        return "[unspecified]";
+    return m_cString.c_str();
+}
+
+int Toolkit::CopyCString(char *buffer, int size) const
+{
+    if (buffer && (size > 0)) {
+        int length = std::min(size - 1, (int)m_cString.size());
+        memcpy(buffer, m_cString.data(), length);
+        buffer[length] = '\0';
     }
+    return (int)m_cString.size();
 }
 
 } // namespace vrv
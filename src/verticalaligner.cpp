@@ -9,6 +9,7 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
 #include <math.h>
 
@@ -85,6 +86,59 @@ StaffAlignment *SystemAligner::GetStaffAlignmentForStaffN(int staffN) const
     return NULL;
 }
 
+//----------------------------------------------------------------------------
+// OverflowBBoxes
+//----------------------------------------------------------------------------
+
+void OverflowBBoxes::Add(BoundingBox *box)
+{
+    assert(box);
+
+    m_bboxes.push_back(box);
+
+    // Boxes without content bounding box never overlap and do not need to be indexed
+    if (!box->HasContentBB()) return;
+
+    std::pair<int, int> entry = std::make_pair(box->GetContentLeft(), (int)m_bboxes.size() - 1);
+    // Keep the index sorted - the insertion index being the second value, equal positions stay in insertion order
+    m_leftIndex.insert(std::upper_bound(m_leftIndex.begin(), m_leftIndex.end(), entry), entry);
+    m_maxWidth = std::max(m_maxWidth, box->GetContentRight() - box->GetContentLeft());
+}
+
+void OverflowBBoxes::Clear()
+{
+    m_bboxes.clear();
+    m_leftIndex.clear();
+    m_maxWidth = 0;
+}
+
+void OverflowBBoxes::FindHorizontalContentOverlaps(const BoundingBox *box, ArrayOfBoundingBoxes *overlaps) const
+{
+    assert(box);
+    assert(overlaps);
+
+    overlaps->clear();
+    if (!box->HasContentBB()) return;
+
+    const int left = box->GetContentLeft();
+    const int right = box->GetContentRight();
+
+    // An overlapping box starts before the right of box and ends after its left, i.e., it cannot start more than
+    // m_maxWidth before the left of box. Insertion indexes are all lower than the size.
+    auto iter = std::upper_bound(
+        m_leftIndex.begin(), m_leftIndex.end(), std::make_pair(left - m_maxWidth, (int)m_bboxes.size()));
+    std::vector<int> indexes;
+    for (; (iter != m_leftIndex.end()) && (iter->first < right); ++iter) {
+        if (box->HorizontalContentOverlap(m_bboxes.at(iter->second))) indexes.push_back(iter->second);
+    }
+
+    // Return them in insertion order since the caller processing can depend on it
+    std::sort(indexes.begin(), indexes.end());
+    for (auto &index : indexes) {
+        overlaps->push_back(m_bboxes.at(index));
+    }
+}
+
 //----------------------------------------------------------------------------
 // StaffAlignment
 //----------------------------------------------------------------------------
@@ -231,11 +285,12 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
             this->SetOverflowBelow(minMargin + this->GetVerseCount() * (height - descender + margin));
             // For now just clear the overflowBelow, which avoids the overlap to be calculated. We could also keep them
             // and check if they are some lyrics in order to know if the overlap needs to be calculated or not.
-            m_overflowBelowBBoxes.clear();
+            m_overflowBelowBBoxes.Clear();
         }
         return FUNCTOR_SIBLINGS;
     }
 
+    ArrayOfBoundingBoxes overlaps;
     ArrayOfFloatingPositioners::iterator iter;
     for (iter = m_floatingPositioners.begin(); iter != m_floatingPositioners.end(); ++iter) {
         assert((*iter)->GetObject());
@@ -261,7 +316,7 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
             if (overflowAbove > params->m_doc->GetDrawingStaffLineWidth(staffSize) / 2) {
                 // LogMessage("%sparams->m_doctop overflow: %d", current->GetUuid().c_str(), overflowAbove);
                 this->SetOverflowAbove(overflowAbove);
-                this->m_overflowAboveBBoxes.push_back((*iter));
+                this->m_overflowAboveBBoxes.Add((*iter));
             }
 
             int overflowBelow = 0;
@@ -269,7 +324,7 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
             if (overflowBelow > params->m_doc->GetDrawingStaffLineWidth(staffSize) / 2) {
                 // LogMessage("%s bottom overflow: %d", current->GetUuid().c_str(), overflowBelow);
                 this->SetOverflowBelow(overflowBelow);
-                this->m_overflowBelowBBoxes.push_back((*iter));
+                this->m_overflowBelowBBoxes.Add((*iter));
             }
             continue;
         }
@@ -277,33 +332,28 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
         // This sets the default position (without considering any overflowing box)
         (*iter)->CalcDrawingYRel(params->m_doc, this, NULL);
 
-        ArrayOfBoundingBoxes *overflowBoxes = &m_overflowBelowBBoxes;
+        OverflowBBoxes *overflowBoxes = &m_overflowBelowBBoxes;
         // above?
         data_STAFFREL_basic place = (*iter)->GetDrawingPlace();
         if (place == STAFFREL_basic_above) {
             overflowBoxes = &m_overflowAboveBBoxes;
         }
-        auto i = overflowBoxes->begin();
-        auto end = overflowBoxes->end();
-        while (i != end) {
-            // find all the overflowing elements from the staff that overlap horizonatally
-            i = std::find_if(i, end, [iter](BoundingBox *elem) { return (*iter)->HorizontalContentOverlap(elem); });
-            if (i != end) {
-                // update the yRel accordingly
-                (*iter)->CalcDrawingYRel(params->m_doc, this, *i);
-                i++;
-            }
+        // find all the overflowing elements from the staff that overlap horizonatally
+        overflowBoxes->FindHorizontalContentOverlaps((*iter), &overlaps);
+        for (auto &overlap : overlaps) {
+            // update the yRel accordingly
+            (*iter)->CalcDrawingYRel(params->m_doc, this, overlap);
         }
         //  Now update the staffAlignment max overflow (above or below) and add the positioner to the list of
         //  overflowing elements
         if (place == STAFFREL_basic_above) {
             int overflowAbove = this->CalcOverflowAbove((*iter));
-            overflowBoxes->push_back((*iter));
+            overflowBoxes->Add((*iter));
             this->SetOverflowAbove(overflowAbove);
         }
         else {
             int overflowBelow = this->CalcOverflowBelow((*iter));
-            overflowBoxes->push_back((*iter));
+            overflowBoxes->Add((*iter));
             this->SetOverflowBelow(overflowBelow);
         }
     }
@@ -378,25 +428,21 @@ int StaffAlignment::AdjustStaffOverlap(FunctorParams *functorParams)
         return FUNCTOR_SIBLINGS;
     }
 
-    ArrayOfBoundingBoxes::iterator iter;
+    ArrayOfBoundingBoxes overlaps;
+    const ArrayOfBoundingBoxes *previousBBoxes = params->m_previous->m_overflowBelowBBoxes.GetBBoxes();
+    ArrayOfBoundingBoxes::const_iterator iter;
     // go through all the elements of the top staff that have an overflow below
-    for (iter = params->m_previous->m_overflowBelowBBoxes.begin();
-         iter != params->m_previous->m_overflowBelowBBoxes.end(); ++iter) {
-        auto i = m_overflowAboveBBoxes.begin();
-        auto end = m_overflowAboveBBoxes.end();
-        while (i != end) {
-            // find all the elements from the bottom staff that have an overflow at the top with an horizontal overlap
-            i = std::find_if(i, end, [iter](BoundingBox *elem) { return (*iter)->HorizontalContentOverlap(elem); });
-            if (i != end) {
-                // calculate the vertical overlap and see if this is more than the expected space
-                int overflowBelow = params->m_previous->CalcOverflowBelow(*iter);
-                int overflowAbove = this->CalcOverflowAbove(*i);
-                int spacing = std::max(params->m_previous->m_overflowBelow, this->m_overflowAbove);
-                if (spacing < (overflowBelow + overflowAbove)) {
-                    // LogDebug("Overlap %d", (overflowBelow + overflowAbove) - spacing);
-                    this->SetOverlap((overflowBelow + overflowAbove) - spacing);
-                }
-                i++;
+    for (iter = previousBBoxes->begin(); iter != previousBBoxes->end(); ++iter) {
+        // find all the elements from the bottom staff that have an overflow at the top with an horizontal overlap
+        m_overflowAboveBBoxes.FindHorizontalContentOverlaps(*iter, &overlaps);
+        for (auto &overlap : overlaps) {
+            // calculate the vertical overlap and see if this is more than the expected space
+            int overflowBelow = params->m_previous->CalcOverflowBelow(*iter);
+            int overflowAbove = this->CalcOverflowAbove(overlap);
+            int spacing = std::max(params->m_previous->m_overflowBelow, this->m_overflowAbove);
+            if (spacing < (overflowBelow + overflowAbove)) {
+                // LogDebug("Overlap %d", (overflowBelow + overflowAbove) - spacing);
+                this->SetOverlap((overflowBelow + overflowAbove) - spacing);
             }
         }
     }
@@ -29,9 +29,6 @@
 
 namespace vrv {
 
-int View::s_drawingLigX[2], View::s_drawingLigY[2]; // to keep coords. of ligatures
-bool View::s_drawingLigObliqua = false; // mark the first pass for an oblique
-
 //----------------------------------------------------------------------------
 // View - Mensural
 //----------------------------------------------------------------------------
@@ -15,6 +15,7 @@
 
 #include "annot.h"
 #include "attcomparison.h"
+#include "bboxdevicecontext.h"
 #include "beam.h"
 #include "clef.h"
 #include "controlelement.h"
@@ -729,6 +730,13 @@ void View::DrawMeasure(DeviceContext *dc, Measure *measure, System *system)
     assert(measure);
     assert(system);
 
+    // The horizontal bounding boxes are not needed when the horizontal layout was restored from the layout cache
+    if (dc->Is(BBOX_DEVICE_CONTEXT)) {
+        BBoxDeviceContext *bBoxDC = dynamic_cast<BBoxDeviceContext *>(dc);
+        assert(bBoxDC);
+        if (!bBoxDC->UpdateVerticalValues() && !measure->NeedsHorizontalBoundingBoxes()) return;
+    }
+
     // This is a special case where we do not draw (SVG, Bounding boxes, etc.) the measure for unmeasured music
     if (measure->IsMeasuredMusic()) {
         dc->StartGraphic(measure, "", measure->GetUuid());
@@ -12,6 +12,7 @@
 
 #include <assert.h>
 #include <cmath>
+#include <fstream>
 #include <sstream>
 #include <stdarg.h>
 #include <stdio.h>
@@ -56,57 +57,135 @@ namespace vrv {
 // Static members with some default values
 //----------------------------------------------------------------------------
 
-std::string Resources::m_path = "/usr/local/share/verovio";
-std::map<wchar_t, Glyph> Resources::m_font;
-std::map<wchar_t, Glyph> Resources::m_textFont;
+std::mutex Resources::s_fontMutex;
+std::map<std::pair<std::string, std::string>, std::shared_ptr<GlyphTable> > Resources::s_glyphTables;
+
+/** The current resources of the thread */
+thread_local Resources *currentResources = NULL;
 
 //----------------------------------------------------------------------------
 // Font related methods
 //----------------------------------------------------------------------------
 
+Resources::Resources()
+{
+    m_path = "/usr/local/share/verovio";
+}
+
 bool Resources::InitFonts()
 {
+    Resources *resources = GetCurrent();
+
+    std::lock_guard<std::mutex> lock(s_fontMutex);
+
     // We will need to rethink this for adding the option to add custom fonts
-    // Font Bravura first since it is expected to have always all symbols
-    if (!LoadFont("Bravura")) LogError("Bravura font could not be loaded.");
     // The Leipzig as the default font
-    if (!LoadFont("Leipzig")) LogError("Leipzig font could not be loaded.");
+    std::shared_ptr<GlyphTable> font = GetGlyphTable(resources->m_path, "Leipzig");
+    if (!font) return false;
 
-    if (m_font.size() < SMUFL_COUNT) {
-        LogError("Expected %d default SMUFL glyphs but could load only %d.", SMUFL_COUNT, m_font.size());
-        return false;
-    }
-
-    if (!InitTextFont()) {
+    std::shared_ptr<GlyphTable> textFont = GetGlyphTable(resources->m_path, "");
+    if (!textFont) {
         LogError("Text font could not be initialized.");
         return false;
     }
 
+    resources->m_font = font;
+    resources->m_textFont = textFont;
+
     return true;
 }
 
 bool Resources::SetFont(std::string fontName)
 {
-    return LoadFont(fontName);
+    Resources *resources = GetCurrent();
+
+    std::lock_guard<std::mutex> lock(s_fontMutex);
+
+    std::shared_ptr<GlyphTable> font = GetGlyphTable(resources->m_path, fontName);
+    if (!font) return false;
+
+    resources->m_font = font;
+    if (!resources->m_textFont) resources->m_textFont = GetGlyphTable(resources->m_path, "");
+
+    return true;
 }
 
 Glyph *Resources::GetGlyph(wchar_t smuflCode)
 {
-    if (!m_font.count(smuflCode)) return NULL;
-    return &m_font[smuflCode];
+    Resources *resources = GetCurrent();
+    if (!resources->m_font) return NULL;
+
+    GlyphTable::iterator iter = resources->m_font->find(smuflCode);
+    if (iter == resources->m_font->end()) return NULL;
+    return &iter->second;
 }
 
 Glyph *Resources::GetTextGlyph(wchar_t code)
 {
-    if (!m_textFont.count(code)) return NULL;
-    return &m_textFont[code];
+    Resources *resources = GetCurrent();
+    if (!resources->m_textFont) return NULL;
+
+    GlyphTable::iterator iter = resources->m_textFont->find(code);
+    if (iter == resources->m_textFont->end()) return NULL;
+    return &iter->second;
+}
+
+Resources *Resources::GetCurrent()
+{
+    if (currentResources) return currentResources;
+
+    static Resources defaultResources;
+    return &defaultResources;
 }
 
-bool Resources::LoadFont(std::string fontName)
+Resources *Resources::SetCurrent(Resources *resources)
+{
+    Resources *previous = currentResources;
+    currentResources = resources;
+    return previous;
+}
+
+std::shared_ptr<GlyphTable> Resources::GetGlyphTable(const std::string &path, const std::string &fontName)
+{
+    std::pair<std::string, std::string> key(path, fontName);
+    auto iter = s_glyphTables.find(key);
+    if (iter != s_glyphTables.end()) return iter->second;
+
+    std::shared_ptr<GlyphTable> table;
+    // The text font
+    if (fontName.empty()) {
+        table = std::make_shared<GlyphTable>();
+        if (!LoadTextFont(*table, path)) return NULL;
+    }
+    // The default font
+    else if (fontName == "Leipzig") {
+        table = std::make_shared<GlyphTable>();
+        // Font Bravura first since it is expected to have always all symbols
+        if (!LoadFont(*table, path, "Bravura")) LogError("Bravura font could not be loaded.");
+        if (!LoadFont(*table, path, "Leipzig")) LogError("Leipzig font could not be loaded.");
+
+        if (table->size() < SMUFL_COUNT) {
+            LogError("Expected %d default SMUFL glyphs but could load only %d.", SMUFL_COUNT, table->size());
+            return NULL;
+        }
+    }
+    // Other fonts are loaded over a copy of the default font
+    else {
+        std::shared_ptr<GlyphTable> defaultTable = GetGlyphTable(path, "Leipzig");
+        if (!defaultTable) return NULL;
+        table = std::make_shared<GlyphTable>(*defaultTable);
+        if (!LoadFont(*table, path, fontName)) return NULL;
+    }
+
+    s_glyphTables[key] = table;
+    return table;
+}
+
+bool Resources::LoadFont(GlyphTable &table, const std::string &path, const std::string &fontName)
 {
     ::DIR *dir;
     dirent *pdir;
-    std::string dirname = Resources::GetPath() + "/" + fontName;
+    std::string dirname = path + "/" + fontName;
     dir = opendir(dirname.c_str());
 
     if (!dir) {
@@ -116,7 +195,7 @@ bool Resources::LoadFont(std::string fontName)
 
     // First loop through the fontName directory and load each glyph
     // Since the filename starts with the Unicode code, it is used
-    // to assign the glyph to the corresponding position in m_fonts
+    // to assign the glyph to the corresponding position in the table
     while ((pdir = readdir(dir))) {
         if (strstr(pdir->d_name, ".xml")) {
             // E.g, : E053-gClef8va.xml => strtol extracts E053 as hex
@@ -127,8 +206,8 @@ bool Resources::LoadFont(std::string fontName)
             }
             std::string codeStr = pdir->d_name;
             codeStr = codeStr.substr(0, 4);
-            Glyph glyph(Resources::GetPath() + "/" + fontName + "/" + pdir->d_name, codeStr);
-            m_font[smuflCode] = glyph;
+            Glyph glyph(path + "/" + fontName + "/" + pdir->d_name, codeStr);
+            table[smuflCode] = glyph;
         }
     }
 
@@ -136,7 +215,7 @@ bool Resources::LoadFont(std::string fontName)
 
     // Then load the bounding boxes (if bounding box file is provided)
     pugi::xml_document doc;
-    std::string filename = Resources::GetPath() + "/" + fontName + ".xml";
+    std::string filename = path + "/" + fontName + ".xml";
     pugi::xml_parse_result result = doc.load_file(filename.c_str());
     if (!result) {
         // File not found, default bounding boxes will be used
@@ -154,11 +233,11 @@ bool Resources::LoadFont(std::string fontName)
         Glyph *glyph = NULL;
         if (current.attribute("c")) {
             wchar_t smuflCode = (wchar_t)strtol(current.attribute("c").value(), NULL, 16);
-            if (!m_font.count(smuflCode)) {
+            if (!table.count(smuflCode)) {
                 LogWarning("Glyph with code '%d' not found.", smuflCode);
                 continue;
             }
-            glyph = &m_font[smuflCode];
+            glyph = &table[smuflCode];
             if (glyph->GetUnitsPerEm() != unitsPerEm * 10) {
                 LogWarning("Glyph and bounding box units-per-em for code '%d' miss-match (bounding box: %d)", smuflCode,
                     unitsPerEm);
@@ -190,13 +269,13 @@ bool Resources::LoadFont(std::string fontName)
     return true;
 }
 
-bool Resources::InitTextFont()
+bool Resources::LoadTextFont(GlyphTable &table, const std::string &path)
 {
     // For the text font, we load the bounding boxes only
     pugi::xml_document doc;
     // For now, we have only Times bounding boxes for ASCII chars
     // For any other char, we currently use 'o' bounding box
-    std::string filename = Resources::GetPath() + "/text/Times.xml";
+    std::string filename = path + "/text/Times.xml";
     pugi::xml_parse_result result = doc.load_file(filename.c_str());
     if (!result) {
         // File not found, default bounding boxes will be used
@@ -224,7 +303,7 @@ bool Resources::InitTextFont()
             if (current.attribute("h")) height = atof(current.attribute("h").value());
             glyph.SetBoundingBox(x, y, width, height);
             if (current.attribute("h-a-x")) glyph.SetHorizAdvX(atof(current.attribute("h-a-x").value()));
-            m_textFont[code] = glyph;
+            table[code] = glyph;
         }
     }
     return true;
@@ -234,14 +313,12 @@ bool Resources::InitTextFont()
 // Logging related methods
 //----------------------------------------------------------------------------
 
-/** Global for LogElapsedTimeXXX functions (debugging purposes) */
-struct timeval start;
+/** The start time of the LogElapsedTimeXXX functions of the thread (debugging purposes) */
+thread_local struct timeval start;
 /** For disabling log */
-bool noLog = false;
-
-#ifdef EMSCRIPTEN
-std::vector<std::string> logBuffer;
-#endif
+thread_local bool noLog = false;
+/** The current log sink of the thread */
+thread_local LogSink *currentLogSink = NULL;
 
 void LogElapsedTimeStart()
 {
@@ -258,86 +335,73 @@ void LogElapsedTimeEnd(const char *msg)
     LogMessage("Elapsed time (%s): %.3fs", msg, elapsedTime / 1000);
 }
 
+/**
+ * Print the message to the console (emscripten) or to stderr
+ */
+static void PrintLog(consoleLogLevel level, const std::string &message)
+{
+#ifdef EMSCRIPTEN
+    switch (level) {
+        case CONSOLE_ERROR: EM_ASM_ARGS({ console.error(Pointer_stringify($0)); }, message.c_str()); break;
+        case CONSOLE_WARN: EM_ASM_ARGS({ console.warn(Pointer_stringify($0)); }, message.c_str()); break;
+        case CONSOLE_INFO: EM_ASM_ARGS({ console.info(Pointer_stringify($0)); }, message.c_str()); break;
+        default: EM_ASM_ARGS({ console.log(Pointer_stringify($0)); }, message.c_str()); break;
+    }
+#else
+    fputs(message.c_str(), stderr);
+#endif
+}
+
+/**
+ * Format the message and pass it to the current sink of the thread, or print it if there is none
+ */
+static void LogVariable(consoleLogLevel level, const char *prefix, const char *fmt, va_list args)
+{
+    std::string message = prefix + StringFormatVariable(fmt, args) + "\n";
+    if (currentLogSink) {
+        currentLogSink->Append(level, message);
+    }
+    else {
+        PrintLog(level, message);
+    }
+}
+
 void LogDebug(const char *fmt, ...)
 {
     if (noLog) return;
 #if defined(DEBUG)
-#ifdef EMSCRIPTEN
-    std::string s;
-    va_list args;
-    va_start(args, fmt);
-    s = "[Debug] " + StringFormatVariable(fmt, args) + "\n";
-    AppendLogBuffer(true, s, CONSOLE_LOG);
-    va_end(args);
-#else
     va_list args;
     va_start(args, fmt);
-    fprintf(stderr, "[Debug] ");
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
+    LogVariable(CONSOLE_LOG, "[Debug] ", fmt, args);
     va_end(args);
 #endif
-#endif
 }
 
 void LogError(const char *fmt, ...)
 {
     if (noLog) return;
-#ifdef EMSCRIPTEN
-    std::string s;
-    va_list args;
-    va_start(args, fmt);
-    s = "[Error] " + StringFormatVariable(fmt, args) + "\n";
-    AppendLogBuffer(true, s, CONSOLE_ERROR);
-    va_end(args);
-#else
     va_list args;
     va_start(args, fmt);
-    fprintf(stderr, "[Error] ");
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
+    LogVariable(CONSOLE_ERROR, "[Error] ", fmt, args);
     va_end(args);
-#endif
 }
 
 void LogMessage(const char *fmt, ...)
 {
     if (noLog) return;
-#ifdef EMSCRIPTEN
-    std::string s;
     va_list args;
     va_start(args, fmt);
-    s = "[Message] " + StringFormatVariable(fmt, args) + "\n";
-    AppendLogBuffer(true, s, CONSOLE_INFO);
+    LogVariable(CONSOLE_INFO, "[Message] ", fmt, args);
     va_end(args);
-#else
-    va_list args;
-    va_start(args, fmt);
-    fprintf(stderr, "[Message] ");
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
-    va_end(args);
-#endif
 }
 
 void LogWarning(const char *fmt, ...)
 {
     if (noLog) return;
-#ifdef EMSCRIPTEN
-    std::string s;
     va_list args;
     va_start(args, fmt);
-    s = "[Warning] " + StringFormatVariable(fmt, args) + "\n";
-    AppendLogBuffer(true, s, CONSOLE_WARN);
+    LogVariable(CONSOLE_WARN, "[Warning] ", fmt, args);
     va_end(args);
-#else
-    va_list args;
-    va_start(args, fmt);
-    fprintf(stderr, "[Warning] ");
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
-    va_end(args);
-#endif
 }
 
 void DisableLog()
@@ -345,31 +409,352 @@ void DisableLog()
     noLog = true;
 }
 
+//----------------------------------------------------------------------------
+// LogSink
+//----------------------------------------------------------------------------
+
+LogSink::LogSink()
+{
+    m_maxCount = 0;
+    m_suppressedCount = 0;
+}
+
+LogSink::~LogSink()
+{
+    if (currentLogSink == this) currentLogSink = NULL;
+
+    std::string suppressedLine = this->GetSuppressedLine();
+    if (!suppressedLine.empty()) PrintLog(CONSOLE_WARN, suppressedLine);
+}
+
+void LogSink::Append(consoleLogLevel level, const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Errors are always kept, the other messages are only counted once the max count is reached
+    if ((level != CONSOLE_ERROR) && (m_maxCount > 0) && ((int)m_buffer.size() >= m_maxCount)) {
+        if (m_messages.count(message) == 0) ++m_suppressedCount;
+        return;
+    }
+
+    const bool isDuplicate = !m_messages.insert(message).second;
+    if (!isDuplicate) m_buffer.push_back(message);
 #ifdef EMSCRIPTEN
-bool LogBufferContains(std::string s)
+    if (isDuplicate) return;
+#else
+    // Without a max count, stderr gets every message as it comes, including the duplicates
+    if (isDuplicate && (m_maxCount > 0)) return;
+#endif
+    PrintLog(level, message);
+}
+
+std::string LogSink::GetLog() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string str;
+    for (auto &message : m_buffer) str += message;
+    str += this->GetSuppressedLine();
+    return str;
+}
+
+void LogSink::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string suppressedLine = this->GetSuppressedLine();
+    if (!suppressedLine.empty()) PrintLog(CONSOLE_WARN, suppressedLine);
+
+    m_buffer.clear();
+    m_messages.clear();
+    m_suppressedCount = 0;
+}
+
+std::string LogSink::GetSuppressedLine() const
+{
+    if (m_suppressedCount == 0) return "";
+
+    return StringFormat("[Warning] %d messages suppressed (maximum of %d log messages reached)\n", m_suppressedCount,
+        m_maxCount);
+}
+
+void LogSink::SetMaxCount(int maxCount)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_maxCount = maxCount;
+}
+
+LogSink *LogSink::GetCurrent()
+{
+    return currentLogSink;
+}
+
+LogSink *LogSink::SetCurrent(LogSink *sink)
 {
-    std::vector<std::string>::iterator iter = logBuffer.begin();
-    while (iter != logBuffer.end()) {
-        if ((*iter) == s) return true;
-        ++iter;
+    LogSink *previous = currentLogSink;
+    currentLogSink = sink;
+    return previous;
+}
+
+//----------------------------------------------------------------------------
+// CancellationToken
+//----------------------------------------------------------------------------
+
+/** The current cancellation token of the thread */
+thread_local CancellationToken *currentCancellationToken = NULL;
+/** The number of calls to CancellationToken::IsCurrentCancelled since the deadline was checked */
+thread_local int cancellationCheckCount = 0;
+/** The depth of the CancellationDeferralScope of the thread */
+thread_local int cancellationDeferralDepth = 0;
+
+CancellationToken::CancellationToken()
+{
+    m_isCancelled = false;
+    m_hasDeadline = false;
+    m_deadline = 0;
+}
+
+CancellationToken::~CancellationToken()
+{
+    if (currentCancellationToken == this) currentCancellationToken = NULL;
+}
+
+void CancellationToken::SetTimeout(int milliseconds)
+{
+    std::chrono::steady_clock::time_point deadline
+        = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+    // The deadline is set before the flag for the thread reading them
+    m_deadline = (int64_t)deadline.time_since_epoch().count();
+    m_hasDeadline = true;
+}
+
+bool CancellationToken::IsCancelled()
+{
+    if (m_isCancelled) return true;
+
+    if (m_hasDeadline
+        && ((int64_t)std::chrono::steady_clock::now().time_since_epoch().count() >= m_deadline.load())) {
+        m_isCancelled = true;
     }
-    return false;
+    return m_isCancelled;
 }
 
-void AppendLogBuffer(bool checkDuplicate, std::string message, consoleLogLevel level)
+CancellationToken *CancellationToken::GetCurrent()
 {
-    if (checkDuplicate && LogBufferContains(message)) return;
-    logBuffer.push_back(message);
+    return currentCancellationToken;
+}
 
-    switch (level) {
-        case CONSOLE_ERROR: EM_ASM_ARGS({ console.error(Pointer_stringify($0)); }, message.c_str()); break;
-        case CONSOLE_WARN: EM_ASM_ARGS({ console.warn(Pointer_stringify($0)); }, message.c_str()); break;
-        case CONSOLE_INFO: EM_ASM_ARGS({ console.info(Pointer_stringify($0)); }, message.c_str()); break;
-        default: EM_ASM_ARGS({ console.log(Pointer_stringify($0)); }, message.c_str()); break;
+CancellationToken *CancellationToken::SetCurrent(CancellationToken *token)
+{
+    CancellationToken *previous = currentCancellationToken;
+    currentCancellationToken = token;
+    cancellationCheckCount = 0;
+    return previous;
+}
+
+void CancellationToken::DeferCancellation()
+{
+    ++cancellationDeferralDepth;
+}
+
+void CancellationToken::ResumeCancellation()
+{
+    assert(cancellationDeferralDepth > 0);
+    --cancellationDeferralDepth;
+}
+
+bool CancellationToken::IsCurrentCancelled()
+{
+    CancellationToken *token = currentCancellationToken;
+    if (!token || (cancellationDeferralDepth > 0)) return false;
+
+    if (++cancellationCheckCount < CANCELLATION_CHECK_INTERVAL) return token->m_isCancelled;
+    cancellationCheckCount = 0;
+    return token->IsCancelled();
+}
+
+//----------------------------------------------------------------------------
+// TraceRecorder
+//----------------------------------------------------------------------------
+
+/** The current trace recorder of the thread */
+thread_local TraceRecorder *currentTraceRecorder = NULL;
+/** The thread ids in the trace events, numbered from 1 in the order the threads record one */
+std::atomic<int> traceThreadCount(0);
+thread_local int traceThreadId = 0;
+
+TraceRecorder::TraceRecorder()
+{
+    m_origin = std::chrono::steady_clock::now();
+    m_isFileStarted = false;
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    if (currentTraceRecorder == this) currentTraceRecorder = NULL;
+}
+
+void TraceRecorder::SetFilename(const std::string &filename)
+{
+    if (filename == m_filename) return;
+
+    this->Reset();
+    m_filename = filename;
+}
+
+long TraceRecorder::GetTimestamp(std::chrono::steady_clock::time_point time) const
+{
+    return (long)std::chrono::duration_cast<std::chrono::microseconds>(time - m_origin).count();
+}
+
+void TraceRecorder::AddSpan(
+    const char *name, std::chrono::steady_clock::time_point start, const char *argName, int argValue)
+{
+    if (traceThreadId == 0) traceThreadId = ++traceThreadCount;
+
+    long ts = this->GetTimestamp(start);
+    long dur = this->GetTimestamp(std::chrono::steady_clock::now()) - ts;
+    std::string event = StringFormat(
+        "{\"name\":\"%s\",\"cat\":\"verovio\",\"ph\":\"X\",\"ts\":%ld,\"dur\":%ld,\"pid\":1,\"tid\":%d", name, ts, dur,
+        traceThreadId);
+    if (argName) event += StringFormat(",\"args\":{\"%s\":%d}", argName, argValue);
+    event += "}";
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.push_back(event);
+}
+
+void TraceRecorder::AddCounter(const char *name, int value)
+{
+    if (traceThreadId == 0) traceThreadId = ++traceThreadCount;
+
+    long ts = this->GetTimestamp(std::chrono::steady_clock::now());
+    std::string event
+        = StringFormat("{\"name\":\"%s\",\"cat\":\"verovio\",\"ph\":\"C\",\"ts\":%ld,\"pid\":1,\"tid\":%d,"
+                       "\"args\":{\"value\":%d}}",
+            name, ts, traceThreadId, value);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.push_back(event);
+}
+
+bool TraceRecorder::Save()
+{
+    if (m_filename.empty()) return false;
+
+    std::vector<std::string> events;
+    bool isFileStarted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        events.swap(m_events);
+        isFileStarted = m_isFileStarted;
+        m_isFileStarted = true;
     }
+    if (isFileStarted && events.empty()) return true;
+
+    std::ofstream outfile;
+    outfile.open(m_filename.c_str(), (isFileStarted) ? std::ios::app : std::ios::trunc);
+    if (!outfile.is_open()) {
+        LogError("Unable to write trace to file '%s'", m_filename.c_str());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isFileStarted = isFileStarted;
+        return false;
+    }
+    // The array is not closed and each event is followed by a comma, both of which the trace viewers accept
+    if (!isFileStarted) outfile << "[\n";
+    for (auto &event : events) {
+        outfile << event << ",\n";
+    }
+    outfile.close();
+    return true;
 }
 
-#endif
+void TraceRecorder::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_events.clear();
+    m_isFileStarted = false;
+}
+
+int TraceRecorder::GetEventCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return (int)m_events.size();
+}
+
+size_t TraceRecorder::GetMemorySize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t bytes = m_events.capacity() * sizeof(std::string);
+    for (auto &event : m_events) bytes += event.capacity();
+    return bytes;
+}
+
+TraceRecorder *TraceRecorder::GetCurrent()
+{
+    return currentTraceRecorder;
+}
+
+TraceRecorder *TraceRecorder::SetCurrent(TraceRecorder *recorder)
+{
+    TraceRecorder *previous = currentTraceRecorder;
+    currentTraceRecorder = recorder;
+    return previous;
+}
+
+//----------------------------------------------------------------------------
+// TraceRecorderScope
+//----------------------------------------------------------------------------
+
+TraceRecorderScope::TraceRecorderScope(TraceRecorder *recorder)
+{
+    m_recorder = recorder;
+    m_previous = TraceRecorder::SetCurrent(recorder);
+}
+
+TraceRecorderScope::~TraceRecorderScope()
+{
+    TraceRecorder::SetCurrent(m_previous);
+    if (m_recorder && (m_recorder != m_previous)) m_recorder->Save();
+}
+
+//----------------------------------------------------------------------------
+// TraceSpan
+//----------------------------------------------------------------------------
+
+TraceSpan::TraceSpan(const char *name, const char *argName, int argValue)
+{
+    m_recorder = currentTraceRecorder;
+    m_name = name;
+    m_argName = argName;
+    m_argValue = argValue;
+    if (m_recorder) m_start = std::chrono::steady_clock::now();
+}
+
+void TraceSpan::End()
+{
+    if (!m_recorder || !m_name) return;
+
+    m_recorder->AddSpan(m_name, m_start, m_argName, m_argValue);
+    m_name = NULL;
+}
+
+void TraceSpan::Restart(const char *name)
+{
+    this->End();
+
+    m_name = name;
+    if (m_recorder) m_start = std::chrono::steady_clock::now();
+}
+
+void TraceCounter(const char *name, int value)
+{
+    if (currentTraceRecorder) currentTraceRecorder->AddCounter(name, value);
+}
 
 bool Check(Object *object)
 {
@@ -453,6 +838,19 @@ std::string GetFilename(std::string fullpath)
     return name;
 }
 
+bool HasInputFileExtension(const std::string &filename)
+{
+    static const std::vector<std::string> extensions
+        = { ".mei", ".xml", ".musicxml", ".krn", ".hum", ".pae", ".darms", ".vrvs" };
+    for (auto &extension : extensions) {
+        if ((filename.size() > extension.size())
+            && (filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 std::string GetVersion()
 {
     std::string dev;
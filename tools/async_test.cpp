@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        async_test.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "toolkit.h"
+#include "vrv.h"
+
+// A Plaine & Easie incipit loaded as data
+static const std::string TEST_DATA = "@clef:G-2\n@keysig:xF\n@timesig:c\n@data:'4CDEF/2GG/4AAAA/1G/\n";
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &message)
+{
+    if (!condition) {
+        std::cerr << "Failed: " << message << std::endl;
+        ++failures;
+    }
+}
+
+/**
+ * Test the asynchronous methods of the toolkit, and in particular that the toolkit can still be used after the
+ * loading is cancelled. The path of the resources is given as argument.
+ */
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        std::cerr << "Usage: verovio-async-test <resources>" << std::endl;
+        return 1;
+    }
+
+    vrv::Toolkit toolkit(false);
+    check(toolkit.SetResourcePath(argv[1]), "the resources can be loaded");
+    check(toolkit.SetOptions("{\"inputFrom\": \"pae\"}"), "the options can be set");
+
+    // A cancelled loading leaves an empty document
+    vrv::CancellationToken cancelledToken;
+    cancelledToken.Cancel();
+    check(!toolkit.LoadDataAsync(TEST_DATA, &cancelledToken).get(), "the cancelled loading fails");
+    check(toolkit.GetPageCount() == 0, "the page count is 0 after a cancelled loading");
+    check(toolkit.RenderToSVG(1).find("<g") == std::string::npos, "no page is rendered after a cancelled loading");
+
+    // The data can be loaded again
+    vrv::CancellationToken token;
+    check(toolkit.LoadDataAsync(TEST_DATA, &token).get(), "the data can be loaded again");
+    check(toolkit.GetPageCount() == 1, "the data has one page");
+    check(toolkit.RenderToSVGAsync(1, false, &token).get().find("<svg") != std::string::npos, "the page is rendered");
+
+    if (failures == 0) std::cout << "Async test passed" << std::endl;
+    return (failures == 0) ? 0 : 1;
+}
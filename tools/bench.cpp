@@ -0,0 +1,497 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        bench.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#else
+#include "win_dirent.h"
+#include "win_getopt.h"
+#endif
+
+//----------------------------------------------------------------------------
+
+#include "toolkit.h"
+#include "vrv.h"
+
+//----------------------------------------------------------------------------
+
+#include "jsonxx.h"
+
+// Differences below these values are not reported as regressions
+#define BENCH_MIN_TIME_DIFFERENCE 0.1
+#define BENCH_MIN_BYTES_DIFFERENCE 65536.0
+#define BENCH_MIN_RSS_DIFFERENCE 1024.0
+
+//----------------------------------------------------------------------------
+// Allocation counting
+//----------------------------------------------------------------------------
+
+// The benchmark is single-threaded
+static long allocationCount = 0;
+static long allocatedBytes = 0;
+
+void *operator new(size_t size)
+{
+    ++allocationCount;
+    allocatedBytes += (long)size;
+    void *p = malloc((size) ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+//----------------------------------------------------------------------------
+// Stages
+//----------------------------------------------------------------------------
+
+enum BenchStage { STAGE_load = 0, STAGE_castOff, STAGE_svg, STAGE_svgPage, STAGE_midi, STAGE_timemap };
+
+static const std::vector<std::string> stageNames = { "load", "castOff", "svg", "svgPage", "midi", "timemap" };
+
+// The values measured for one stage for each iteration (for each page with svgPage)
+struct StageResult {
+    std::vector<double> m_times;
+    std::vector<long> m_allocationCounts;
+    std::vector<long> m_allocatedBytes;
+};
+
+// Measure the time and the allocations of a stage
+class StageTimer {
+public:
+    StageTimer(StageResult &result) : m_result(result)
+    {
+        m_allocationCount = allocationCount;
+        m_allocatedBytes = allocatedBytes;
+        m_start = std::chrono::steady_clock::now();
+    }
+    ~StageTimer()
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+        m_result.m_times.push_back(elapsed.count());
+        m_result.m_allocationCounts.push_back(allocationCount - m_allocationCount);
+        m_result.m_allocatedBytes.push_back(allocatedBytes - m_allocatedBytes);
+    }
+
+private:
+    StageResult &m_result;
+    long m_allocationCount;
+    long m_allocatedBytes;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+template <class T> T percentile(std::vector<T> values, double percent)
+{
+    assert(!values.empty());
+    std::sort(values.begin(), values.end());
+    int idx = (int)std::ceil(percent / 100.0 * values.size()) - 1;
+    return values.at(std::max(0, std::min(idx, (int)values.size() - 1)));
+}
+
+//----------------------------------------------------------------------------
+// Resident set size
+//----------------------------------------------------------------------------
+
+// Return a value in kB of /proc/self/status (Linux only) or -1
+long get_status_value(const std::string &key)
+{
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, key.size() + 1, key + ":") == 0) return atol(line.c_str() + key.size() + 1);
+    }
+    return -1;
+}
+
+// Reset the peak resident set size of the process to the current one (Linux only)
+bool reset_peak_rss()
+{
+    std::ofstream out("/proc/self/clear_refs");
+    if (!out.is_open()) return false;
+    out << "5";
+    out.close();
+    return !out.fail() && (get_status_value("VmHWM") == get_status_value("VmRSS"));
+}
+
+// Return the peak resident set size in kB since the last reset - since the start of the process if it cannot be reset
+long get_peak_rss()
+{
+    long peak = get_status_value("VmHWM");
+    if (peak >= 0) return peak;
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Benchmark of one file
+//----------------------------------------------------------------------------
+
+std::string get_format_name(vrv::FileFormat format)
+{
+    switch (format) {
+        case vrv::MEI: return "mei";
+        case vrv::MUSICXML: return "musicxml";
+        case vrv::HUMDRUM: return "humdrum";
+        case vrv::PAE: return "pae";
+        case vrv::DARMS: return "darms";
+        default: return "unsupported";
+    }
+}
+
+// Run all the stages with a new toolkit and return the number of pages. The data is loaded without breaks and cast
+// off with RedoLayout, so the time of LoadData is the one of the import and of the preparation for drawing only.
+int run_stages(const std::string &data, std::vector<StageResult> &results)
+{
+    // The fonts are loaded once in main
+    vrv::Toolkit toolkit(false);
+    toolkit.SetOptions("{\"breaks\": \"none\"}");
+    {
+        StageTimer timer(results.at(STAGE_load));
+        if (!toolkit.LoadData(data)) return 0;
+    }
+    toolkit.SetOptions("{\"breaks\": \"auto\"}");
+    {
+        StageTimer timer(results.at(STAGE_castOff));
+        toolkit.RedoLayout();
+    }
+
+    int pageCount = toolkit.GetPageCount();
+    {
+        StageTimer timer(results.at(STAGE_svg));
+        for (int page = 1; page <= pageCount; ++page) {
+            StageTimer pageTimer(results.at(STAGE_svgPage));
+            toolkit.RenderToSVG(page);
+        }
+    }
+    {
+        StageTimer timer(results.at(STAGE_midi));
+        toolkit.RenderToMIDIRaw();
+    }
+    {
+        StageTimer timer(results.at(STAGE_timemap));
+        toolkit.RenderToTimemap();
+    }
+
+    return pageCount;
+}
+
+bool bench_file(const std::string &filename, int iterations, int warmups, jsonxx::Object &json)
+{
+    std::ifstream in(filename.c_str());
+    if (!in.is_open()) {
+        std::cerr << "The file '" << filename << "' could not be opened." << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string data = buffer.str();
+
+    vrv::Toolkit toolkit(false);
+    vrv::FileFormat format = toolkit.IdentifyInputFormat(data);
+
+    // The peak is the one of this file only when it can be reset
+    static bool isPeakRssReset = true;
+    if (isPeakRssReset && !reset_peak_rss()) {
+        std::cerr << "The peak RSS cannot be reset and is the one of the process." << std::endl;
+        isPeakRssReset = false;
+    }
+    long rss = std::max(0L, get_status_value("VmRSS"));
+
+    std::vector<StageResult> results(stageNames.size());
+    int pageCount = 0;
+    for (int i = 0; i < warmups + iterations; ++i) {
+        // Results of the warm-up iterations are discarded
+        if (i == warmups) results = std::vector<StageResult>(stageNames.size());
+        pageCount = run_stages(data, results);
+        if (pageCount == 0) {
+            std::cerr << "The file '" << filename << "' could not be imported." << std::endl;
+            return false;
+        }
+    }
+
+    jsonxx::Object stages;
+    for (int i = 0; i < (int)stageNames.size(); ++i) {
+        StageResult &result = results.at(i);
+        jsonxx::Object stage;
+        stage << "median" << percentile(result.m_times, 50);
+        stage << "p95" << percentile(result.m_times, 95);
+        if (!result.m_allocationCounts.empty()) {
+            stage << "allocations" << (double)percentile(result.m_allocationCounts, 50);
+            stage << "allocatedBytes" << (double)percentile(result.m_allocatedBytes, 50);
+        }
+        stages << stageNames.at(i) << stage;
+    }
+
+    json << "format" << get_format_name(format);
+    json << "pages" << pageCount;
+    json << "rssKb" << (double)rss;
+    json << "peakRssKb" << (double)get_peak_rss();
+    json << "stages" << stages;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Comparison with a baseline
+//----------------------------------------------------------------------------
+
+// Compare a value with the baseline one (if any) and return true if it is larger by more than the threshold
+bool compare_value(const std::string &file, const std::string &name, const std::string &key,
+    const jsonxx::Object &current, const jsonxx::Object &baseline, double threshold, double minDifference)
+{
+    if (!current.has<jsonxx::Number>(key) || !baseline.has<jsonxx::Number>(key)) return false;
+    double currentValue = current.get<jsonxx::Number>(key);
+    double previousValue = baseline.get<jsonxx::Number>(key);
+    double change = (previousValue > 0.0) ? (currentValue - previousValue) / previousValue * 100.0 : 0.0;
+    bool isRegression = (change > threshold) && (currentValue - previousValue > minDifference);
+    std::cerr << vrv::StringFormat("%s %-50s %-16s %-16s %14.3f %14.3f %+7.1f%%", (isRegression) ? "!" : " ",
+                     file.c_str(), name.c_str(), key.c_str(), previousValue, currentValue, change)
+              << std::endl;
+    return isRegression;
+}
+
+// Return the number of regressions, i.e., the values larger by more than the threshold. The median time gives the
+// speed of a stage, its p95 time the spread, and the allocated bytes and the peak RSS the memory.
+int compare_with_baseline(const jsonxx::Object &files, const std::string &baselineFile, double threshold)
+{
+    std::ifstream in(baselineFile.c_str());
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    jsonxx::Object baseline;
+    if (!in.is_open() || !baseline.parse(buffer.str()) || !baseline.has<jsonxx::Object>("files")) {
+        std::cerr << "The baseline '" << baselineFile << "' could not be read." << std::endl;
+        return -1;
+    }
+    const jsonxx::Object &baselineFiles = baseline.get<jsonxx::Object>("files");
+
+    int regressions = 0;
+    for (auto &file : files.kv_map()) {
+        if (!baselineFiles.has<jsonxx::Object>(file.first)) continue;
+        const jsonxx::Object &current = file.second->get<jsonxx::Object>();
+        const jsonxx::Object &previous = baselineFiles.get<jsonxx::Object>(file.first);
+        const jsonxx::Object &stages = current.get<jsonxx::Object>("stages");
+        const jsonxx::Object &baselineStages = previous.get<jsonxx::Object>("stages");
+        for (auto &name : stageNames) {
+            if (!stages.has<jsonxx::Object>(name) || !baselineStages.has<jsonxx::Object>(name)) continue;
+            const jsonxx::Object &stage = stages.get<jsonxx::Object>(name);
+            const jsonxx::Object &baselineStage = baselineStages.get<jsonxx::Object>(name);
+            if (compare_value(
+                    file.first, name, "median", stage, baselineStage, threshold, BENCH_MIN_TIME_DIFFERENCE)) {
+                ++regressions;
+            }
+            if (compare_value(file.first, name, "p95", stage, baselineStage, threshold, BENCH_MIN_TIME_DIFFERENCE)) {
+                ++regressions;
+            }
+            if (compare_value(file.first, name, "allocatedBytes", stage, baselineStage, threshold,
+                    BENCH_MIN_BYTES_DIFFERENCE)) {
+                ++regressions;
+            }
+        }
+        if (compare_value(file.first, "", "peakRssKb", current, previous, threshold, BENCH_MIN_RSS_DIFFERENCE)) {
+            ++regressions;
+        }
+    }
+    return regressions;
+}
+
+//----------------------------------------------------------------------------
+// Main
+//----------------------------------------------------------------------------
+
+// Add the input files of a directory (not recursively) or the file itself
+void add_input_files(const std::string &input, std::vector<std::string> &infiles)
+{
+    struct stat st;
+    if ((stat(input.c_str(), &st) == 0) && (((st.st_mode) & S_IFMT) == S_IFDIR)) {
+        ::DIR *dir = opendir(input.c_str());
+        if (!dir) return;
+        std::vector<std::string> filenames;
+        std::string dirname = (input.back() == '/') ? input.substr(0, input.size() - 1) : input;
+        dirent *pdir;
+        while ((pdir = readdir(dir))) {
+            std::string filename = pdir->d_name;
+            if (vrv::HasInputFileExtension(filename)) filenames.push_back(dirname + "/" + filename);
+        }
+        closedir(dir);
+        std::sort(filenames.begin(), filenames.end());
+        infiles.insert(infiles.end(), filenames.begin(), filenames.end());
+    }
+    else {
+        infiles.push_back(input);
+    }
+}
+
+// Add the files or directories listed in a manifest, one per line and relative to it - lines starting with # are
+// ignored
+bool add_manifest_files(const std::string &manifest, std::vector<std::string> &infiles)
+{
+    std::ifstream in(manifest.c_str());
+    if (!in.is_open()) {
+        std::cerr << "The manifest '" << manifest << "' could not be opened." << std::endl;
+        return false;
+    }
+    size_t slash = manifest.find_last_of("/\\");
+    std::string dirname = (slash != std::string::npos) ? manifest.substr(0, slash + 1) : "";
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || (line.at(0) == '#')) continue;
+        add_input_files((line.at(0) == '/') ? line : dirname + line, infiles);
+    }
+    return true;
+}
+
+void display_usage()
+{
+    std::cout << "Verovio benchmark " << vrv::GetVersion() << std::endl << std::endl;
+    std::cout << "Example usage:" << std::endl << std::endl;
+    std::cout << " verovio-bench [-n iterations] [-o outfile] [-b baseline] [-m manifest] file|dir ..." << std::endl
+              << std::endl;
+    std::cout << "Each file is loaded by a toolkit, rendered to SVG, exported to MIDI and to a timemap, and the time "
+                 "and allocations of each stage are written as JSON with the peak RSS of the file. The data is loaded "
+                 "without breaks and cast off with RedoLayout for timing them separately, and the SVG is also timed "
+                 "for each page. The corpus of the repository is listed in doc/bench/corpus.txt."
+              << std::endl
+              << std::endl;
+    std::cout << "Options" << std::endl;
+    std::cout << " -?, --help            Display this message" << std::endl;
+    std::cout << " -b, --baseline <s>    Compare the times, the allocated bytes and the peak RSS with a previous output"
+              << std::endl;
+    std::cout << " -m, --manifest <s>    File listing the input files or directories" << std::endl;
+    std::cout << " -n, --iterations <i>  Number of iterations for each file (default is 5)" << std::endl;
+    std::cout << " -o, --outfile <s>     Output file name (default is the standard output)" << std::endl;
+    std::cout << " -r, --resources <s>   Path to SVG resources (default is " << vrv::Resources::GetPath() << ")"
+              << std::endl;
+    std::cout << " -t, --threshold <f>   Percentage above which a change is a regression (default is 10)"
+              << std::endl;
+    std::cout << " -w, --warmups <i>     Number of discarded iterations for each file (default is 1)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string outfile;
+    std::string baselineFile;
+    int iterations = 5;
+    int warmups = 1;
+    double threshold = 10.0;
+
+    static struct option long_options[] = {
+        { "baseline", required_argument, 0, 'b' },
+        { "help", no_argument, 0, '?' },
+        { "iterations", required_argument, 0, 'n' },
+        { "manifest", required_argument, 0, 'm' },
+        { "outfile", required_argument, 0, 'o' },
+        { "resources", required_argument, 0, 'r' },
+        { "threshold", required_argument, 0, 't' },
+        { "warmups", required_argument, 0, 'w' },
+        { 0, 0, 0, 0 }
+    };
+
+    std::vector<std::string> infiles;
+    int c;
+    int option_index = 0;
+    while ((c = getopt_long(argc, argv, "?b:m:n:o:r:t:w:", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 'b': baselineFile = std::string(optarg); break;
+            case 'm':
+                if (!add_manifest_files(std::string(optarg), infiles)) exit(1);
+                break;
+            case 'n': iterations = std::max(1, atoi(optarg)); break;
+            case 'o': outfile = std::string(optarg); break;
+            case 'r': vrv::Resources::SetPath(optarg); break;
+            case 't': threshold = atof(optarg); break;
+            case 'w': warmups = std::max(0, atoi(optarg)); break;
+            case '?':
+                display_usage();
+                exit(0);
+                break;
+            default: break;
+        }
+    }
+
+    for (int i = optind; i < argc; ++i) {
+        add_input_files(std::string(argv[i]), infiles);
+    }
+    if (infiles.empty()) {
+        std::cerr << "Expected at least one input file or directory but found none." << std::endl << std::endl;
+        display_usage();
+        exit(1);
+    }
+
+    if (!vrv::Resources::InitFonts()) {
+        std::cerr << "The music font could not be loaded; please use -r option." << std::endl;
+        exit(1);
+    }
+
+    // The warnings of the import would be repeated for each iteration
+    vrv::DisableLog();
+
+    jsonxx::Object files;
+    for (auto &infile : infiles) {
+        jsonxx::Object file;
+        if (bench_file(infile, iterations, warmups, file)) files << infile << file;
+    }
+
+    jsonxx::Object json;
+    json << "version" << vrv::GetVersion();
+    json << "iterations" << iterations;
+    json << "files" << files;
+
+    if (outfile.empty() || (outfile == "-")) {
+        std::cout << json.json() << std::endl;
+    }
+    else {
+        std::ofstream out(outfile.c_str());
+        if (!out.is_open()) {
+            std::cerr << "Unable to write the results to " << outfile << "." << std::endl;
+            exit(1);
+        }
+        out << json.json() << std::endl;
+    }
+
+    if (!baselineFile.empty()) {
+        int regressions = compare_with_baseline(files, baselineFile, threshold);
+        if (regressions != 0) {
+            if (regressions > 0) std::cerr << regressions << " regression(s) found." << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        c_api_test.c
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------
+
+#include "c_wrapper.h"
+
+// A Plaine & Easie incipit loaded as data
+static const char *TEST_DATA = "@clef:G-2\n@keysig:xF\n@timesig:c\n@data:'4CDEF/2GG/4AAAA/1G/\n";
+
+static int failures = 0;
+
+static void check(int condition, const char *message)
+{
+    if (!condition) {
+        fprintf(stderr, "Failed: %s\n", message);
+        ++failures;
+    }
+}
+
+/**
+ * Test the C API of the library, and in particular the length and the copy of the strings returned.
+ * The path of the resources is given as argument.
+ */
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "Usage: verovio-c-api-test <resources>\n");
+        return 1;
+    }
+
+    Toolkit *tk = (Toolkit *)vrvToolkit_constructor();
+    check(vrvToolkit_setResourcePath(tk, argv[1]), "the resources can be loaded");
+    check(vrvToolkit_loadData(tk, TEST_DATA), "the data can be loaded");
+    check(vrvToolkit_getPageCount(tk) == 1, "the data has one page");
+
+    const char *svg = vrvToolkit_renderToSVG(tk, 1, "");
+    int length = vrvToolkit_getCStringLength(tk);
+    check((length > 0) && (length == (int)strlen(svg)), "the length is the one of the SVG");
+    check(strstr(svg, "</svg>") != NULL, "the SVG is complete");
+
+    // A buffer large enough gets the whole string
+    char *buffer = (char *)malloc(length + 1);
+    check(vrvToolkit_copyCString(tk, buffer, length + 1) == length, "the copy returns the length");
+    check(strcmp(buffer, svg) == 0, "the copy is the same as the SVG");
+
+    // A smaller buffer gets the beginning of the string and the full length is returned
+    memset(buffer, 'x', length + 1);
+    check(vrvToolkit_copyCString(tk, buffer, 11) == length, "the truncated copy returns the full length");
+    check((strlen(buffer) == 10) && (strncmp(buffer, svg, 10) == 0), "the truncated copy is null terminated");
+    check(vrvToolkit_copyCString(tk, NULL, 0) == length, "the length is returned without a buffer");
+    free(buffer);
+
+    // Another string replaces the previous one
+    const char *version = vrvToolkit_getVersion(tk);
+    check(vrvToolkit_getCStringLength(tk) == (int)strlen(version), "the length is the one of the version");
+
+    vrvToolkit_destructor(tk);
+
+    if (failures == 0) printf("C API test passed\n");
+    return (failures == 0) ? 0 : 1;
+}
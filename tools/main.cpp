@@ -5,21 +5,33 @@
 // Copyright (c) Authors and others. All rights reserved.
 /////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <queue>
 #include <regex>
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
 
 #ifndef _WIN32
+#include <dirent.h>
 #include <getopt.h>
 #else
+#include "win_dirent.h"
 #include "win_getopt.h"
 #endif
 
 //----------------------------------------------------------------------------
 
+#include "jsonxx.h"
 #include "options.h"
 #include "toolkit.h"
 #include "vrv.h"
@@ -82,6 +94,452 @@ bool dir_exists(std::string dir)
     }
 }
 
+// The values set on the command line that are given to the toolkit of each worker
+struct ToolkitDefaults {
+    std::string options;
+    std::string outformat;
+    int format;
+    int scale;
+    int xmlIdSeed;
+};
+
+ToolkitDefaults get_toolkit_defaults(vrv::Toolkit &toolkit, const std::string &outformat, int xmlIdSeed)
+{
+    ToolkitDefaults defaults;
+    defaults.options = toolkit.GetOptions(false);
+    defaults.outformat = outformat;
+    defaults.format = toolkit.GetFormat();
+    defaults.scale = toolkit.GetScale();
+    defaults.xmlIdSeed = xmlIdSeed;
+    return defaults;
+}
+
+void set_toolkit_defaults(vrv::Toolkit &toolkit, const ToolkitDefaults &defaults)
+{
+    toolkit.SetOptions(defaults.options);
+    toolkit.SetFormat((vrv::FileFormat)defaults.format);
+    toolkit.SetScale(defaults.scale);
+    toolkit.SetOutputFormat(defaults.outformat);
+    // The generator is seeded for each file to get the same ids whatever worker converts it
+    if (defaults.xmlIdSeed) vrv::Object::SeedUuid(defaults.xmlIdSeed);
+}
+
+// The output of the workers is serialized with this mutex
+std::mutex outputMutex;
+
+void print_message(const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cerr << message << std::endl;
+}
+
+int get_job_count(int jobs)
+{
+    return (jobs > 0) ? jobs : std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+bool run_batch_request(
+    vrv::Toolkit &toolkit, const ToolkitDefaults &defaults, jsonxx::Object &request, jsonxx::Object &response)
+{
+    // Restore the command line values since the toolkit is re-used from one request to another
+    set_toolkit_defaults(toolkit, defaults);
+
+    if (request.has<jsonxx::Object>("options")) {
+        jsonxx::Object options = request.get<jsonxx::Object>("options");
+        // The font is loaded once for all the workers from the command line
+        if (options.has<jsonxx::Value>("font")) {
+            response << "error"
+                     << "The 'font' option cannot be changed in a request and has to be given on the command line";
+            return false;
+        }
+        if (!toolkit.SetOptions(options.json())) return false;
+    }
+
+    std::string outformat = defaults.outformat;
+    if (request.has<jsonxx::String>("type")) outformat = request.get<jsonxx::String>("type");
+    if (!toolkit.SetOutputFormat(outformat)) return false;
+
+    if (request.has<jsonxx::String>("data")) {
+        if (!toolkit.LoadData(request.get<jsonxx::String>("data"))) return false;
+    }
+    else if (request.has<jsonxx::String>("input")) {
+        std::string infile = request.get<jsonxx::String>("input");
+        if (!toolkit.LoadFile(infile)) {
+            response << "error" << vrv::StringFormat("The file '%s' could not be opened", infile.c_str());
+            return false;
+        }
+    }
+    else {
+        response << "error"
+                 << "The request has no 'input' or 'data'";
+        return false;
+    }
+
+    int page = (request.has<jsonxx::Number>("page")) ? (int)request.get<jsonxx::Number>("page") : 1;
+    bool allPages = (request.has<jsonxx::Boolean>("allPages")) ? request.get<jsonxx::Boolean>("allPages") : false;
+    if ((toolkit.GetOutputFormat() != vrv::HUMDRUM) && ((page < 1) || (page > toolkit.GetPageCount()))) {
+        response << "error" << vrv::StringFormat("The page requested (%d) is not in the page range", page);
+        return false;
+    }
+
+    if (outformat == "svg") {
+        if (allPages) {
+            jsonxx::Array pages;
+            // The page count is estimated with the lazy layout and gets exact as pages are rendered
+            for (int p = 1; p <= toolkit.GetPageCount(); ++p) {
+                pages << toolkit.RenderToSVG(p);
+            }
+            response << "output" << pages;
+        }
+        else {
+            response << "output" << toolkit.RenderToSVG(page);
+        }
+    }
+    else if (outformat == "midi") {
+        response << "output" << toolkit.RenderToMIDI();
+    }
+    else if (outformat == "timemap") {
+        response << "output" << toolkit.RenderToTimemap();
+    }
+    else if (outformat == "humdrum" || outformat == "hum") {
+        response << "output" << toolkit.GetHumdrum();
+    }
+    else if (outformat == "snapshot") {
+        response << "error"
+                 << "Snapshots are binary and cannot be returned in batch mode";
+        return false;
+    }
+    else {
+        response << "output" << ((allPages) ? toolkit.GetMEI(0, true) : toolkit.GetMEI(page));
+    }
+
+    return true;
+}
+
+std::string process_batch_request(vrv::Toolkit &toolkit, const ToolkitDefaults &defaults, const std::string &line)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    jsonxx::Object request;
+    jsonxx::Object response;
+    bool success = false;
+
+    toolkit.ResetLogBuffer();
+    if (!request.parse(line)) {
+        response << "error"
+                 << "The request could not be parsed";
+    }
+    else {
+        if (request.has<jsonxx::String>("id")) {
+            response << "id" << request.get<jsonxx::String>("id");
+        }
+        else if (request.has<jsonxx::Number>("id")) {
+            response << "id" << request.get<jsonxx::Number>("id");
+        }
+        success = run_batch_request(toolkit, defaults, request, response);
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    response << "status" << std::string((success) ? "ok" : "error");
+    response << "log" << toolkit.GetLog();
+    response << "time" << elapsed.count();
+
+    // Write the response on one line - new lines and tabs in the strings are escaped by jsonxx
+    std::string json = response.json();
+    json.erase(std::remove_if(json.begin(), json.end(), [](char c) { return (c == '\n') || (c == '\t'); }), json.end());
+    return json;
+}
+
+int run_batch(vrv::Toolkit &toolkit, const std::string &outformat, int xmlIdSeed, int jobs)
+{
+    ToolkitDefaults defaults = get_toolkit_defaults(toolkit, outformat, xmlIdSeed);
+
+    jobs = get_job_count(jobs);
+    // Keep the number of requests read ahead bounded
+    const size_t maxQueued = 2 * jobs;
+
+    std::queue<std::string> requests;
+    bool endOfInput = false;
+    std::mutex queueMutex;
+    std::condition_variable requestAdded;
+    std::condition_variable requestTaken;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < jobs; ++i) {
+        workers.push_back(std::thread([&]() {
+            // Each worker has its own toolkit - the fonts are already loaded and shared by all of them
+            vrv::Toolkit worker(false);
+            while (true) {
+                std::string line;
+                {
+                    std::unique_lock<std::mutex> lock(queueMutex);
+                    requestAdded.wait(lock, [&]() { return endOfInput || !requests.empty(); });
+                    if (requests.empty()) return;
+                    line = requests.front();
+                    requests.pop();
+                }
+                requestTaken.notify_one();
+                std::string response = process_batch_request(worker, defaults, line);
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << response << std::endl;
+            }
+        }));
+    }
+
+    for (std::string line; getline(std::cin, line);) {
+        if (line.empty()) continue;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            requestTaken.wait(lock, [&]() { return requests.size() < maxQueued; });
+            requests.push(line);
+        }
+        requestAdded.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        endOfInput = true;
+    }
+    requestAdded.notify_all();
+
+    for (auto &worker : workers) worker.join();
+
+    return 0;
+}
+
+int convert_file(vrv::Toolkit &toolkit, const std::string &infile, std::string outfile, const std::string &outformat,
+    int page, int all_pages, bool std_output)
+{
+    // Load the std input or load the file
+    if (infile == "-") {
+        std::ostringstream data_stream;
+        for (std::string line; getline(std::cin, line);) {
+            data_stream << line << std::endl;
+        }
+        if (!toolkit.LoadData(data_stream.str())) {
+            print_message("The input could not be loaded.");
+            return 1;
+        }
+    }
+    else {
+        if (!toolkit.LoadFile(infile)) {
+            print_message("The file '" + infile + "' could not be opened.");
+            return 1;
+        }
+    }
+
+    if (toolkit.GetOutputFormat() != vrv::HUMDRUM) {
+        // Check the page range
+        if (page > toolkit.GetPageCount()) {
+            print_message(vrv::StringFormat(
+                "The page requested (%d) is not in the page range (max is %d).", page, toolkit.GetPageCount()));
+            return 1;
+        }
+        if (page < 1) {
+            print_message("The page number has to be greater than 0.");
+            return 1;
+        }
+    }
+
+    int from = page;
+    int to = page + 1;
+    if (all_pages) {
+        to = toolkit.GetPageCount() + 1;
+    }
+
+    if (outformat == "svg") {
+        int p;
+        for (p = from; p < to; ++p) {
+            // The page count is estimated with the lazy layout and gets exact as pages are rendered
+            if (all_pages) {
+                to = toolkit.GetPageCount() + 1;
+                if (p >= to) break;
+            }
+            std::string cur_outfile = outfile;
+            if (all_pages) {
+                cur_outfile += vrv::StringFormat("_%03d", p);
+            }
+            cur_outfile += ".svg";
+            if (std_output) {
+                std::cout << toolkit.RenderToSVG(p);
+            }
+            else if (!toolkit.RenderToSVGFile(cur_outfile, p)) {
+                print_message("Unable to write SVG to " + cur_outfile + ".");
+                return 1;
+            }
+            else {
+                print_message("Output written to " + cur_outfile + ".");
+            }
+        }
+    }
+
+    else if (outformat == "midi") {
+        outfile += ".mid";
+        if (std_output) {
+            print_message("Midi cannot write to standard output.");
+            return 1;
+        }
+        else if (!toolkit.RenderToMIDIFile(outfile)) {
+            print_message("Unable to write MIDI to " + outfile + ".");
+            return 1;
+        }
+        else {
+            print_message("Output written to " + outfile + ".");
+        }
+    }
+    else if (outformat == "timemap") {
+        outfile += ".json";
+        if (std_output) {
+            std::string output;
+            std::cout << toolkit.RenderToTimemap();
+        }
+        else if (!toolkit.RenderToTimemapFile(outfile)) {
+            print_message("Unable to write MIDI to " + outfile + ".");
+            return 1;
+        }
+        else {
+            print_message("Output written to " + outfile + ".");
+        }
+    }
+    else if (outformat == "humdrum" || outformat == "hum") {
+        outfile += ".krn";
+        if (std_output) {
+            toolkit.GetHumdrum(std::cout);
+        }
+        else {
+            if (!toolkit.GetHumdrumFile(outfile)) {
+                print_message("Unable to write Humdrum to " + outfile + ".");
+                return 1;
+            }
+            else {
+                print_message("Output written to " + outfile + ".");
+            }
+        }
+    }
+    else if (outformat == "snapshot") {
+        outfile += ".vrvs";
+        if (std_output) {
+            print_message("Snapshot cannot write to standard output.");
+            return 1;
+        }
+        else if (!toolkit.SaveSnapshotFile(outfile)) {
+            print_message("Unable to write snapshot to " + outfile + ".");
+            return 1;
+        }
+        else {
+            print_message("Output written to " + outfile + ".");
+        }
+    }
+    else {
+        if (all_pages) {
+            toolkit.SetScoreBasedMei(true);
+            outfile += ".mei";
+            if (std_output) {
+                print_message("MEI output of all pages to standard output is not possible.");
+                return 1;
+            }
+            else if (!toolkit.SaveFile(outfile)) {
+                print_message("Unable to write MEI to " + outfile + ".");
+                return 1;
+            }
+            else {
+                print_message("Output written to " + outfile + ".");
+            }
+        }
+        else {
+            if (std_output) {
+                std::cout << toolkit.GetMEI(page);
+            }
+            else {
+                print_message("MEI output of one page is available only to standard output.");
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Add the input files of a directory (not recursively), of a manifest file ("@" followed by the file name with one
+// input file per line), or the file itself
+bool add_input_files(const std::string &input, std::vector<std::string> &infiles)
+{
+    if (dir_exists(input)) {
+        ::DIR *dir = opendir(input.c_str());
+        if (!dir) return false;
+        std::vector<std::string> filenames;
+        dirent *pdir;
+        while ((pdir = readdir(dir))) {
+            std::string filename = pdir->d_name;
+            if (vrv::HasInputFileExtension(filename)) filenames.push_back(input + "/" + filename);
+        }
+        closedir(dir);
+        std::sort(filenames.begin(), filenames.end());
+        infiles.insert(infiles.end(), filenames.begin(), filenames.end());
+    }
+    else if ((input.size() > 1) && (input.at(0) == '@')) {
+        std::ifstream manifest(input.substr(1).c_str());
+        if (!manifest.is_open()) return false;
+        for (std::string line; getline(manifest, line);) {
+            if (!line.empty() && (line.back() == '\r')) line.pop_back();
+            if (!line.empty()) infiles.push_back(line);
+        }
+    }
+    else {
+        infiles.push_back(input);
+    }
+    return true;
+}
+
+int convert_files(vrv::Toolkit &toolkit, const std::vector<std::string> &infiles, const std::string &outdir,
+    const std::string &outformat, int page, int all_pages, int xmlIdSeed, int jobs)
+{
+    ToolkitDefaults defaults = get_toolkit_defaults(toolkit, outformat, xmlIdSeed);
+
+    // The output files are named after the input files and two inputs with the same name would write the same output
+    std::vector<std::string> outfiles;
+    std::map<std::string, std::string> inputsByOutput;
+    for (auto &infile : infiles) {
+        outfiles.push_back(removeExtension((outdir.empty()) ? infile : outdir + "/" + basename(infile)));
+        auto result = inputsByOutput.insert({ outfiles.back(), infile });
+        if (!result.second) {
+            std::cerr << "The files '" << result.first->second << "' and '" << infile
+                      << "' would be converted to the same output file " << outfiles.back() << "." << std::endl;
+            return 1;
+        }
+    }
+
+    jobs = std::min(get_job_count(jobs), (int)infiles.size());
+
+    std::atomic<int> next(0);
+    std::atomic<int> failed(0);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < jobs; ++i) {
+        workers.push_back(std::thread([&]() {
+            // Each worker has its own toolkit - the fonts are already loaded and shared by all of them
+            vrv::Toolkit worker(false);
+            int current;
+            while ((current = next++) < (int)infiles.size()) {
+                set_toolkit_defaults(worker, defaults);
+                // The log of the previous file is not kept
+                worker.ResetLogBuffer();
+                if (convert_file(worker, infiles.at(current), outfiles.at(current), outformat, page, all_pages, false)
+                    != 0)
+                    ++failed;
+            }
+        }));
+    }
+
+    for (auto &worker : workers) worker.join();
+
+    if (failed > 0) {
+        std::cerr << failed.load() << " of " << infiles.size() << " files could not be converted." << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 void display_version()
 {
     std::cout << "Verovio " << vrv::GetVersion() << std::endl;
@@ -93,7 +551,8 @@ void display_usage()
 
     display_version();
     std::cout << std::endl << "Example usage:" << std::endl << std::endl;
-    std::cout << " verovio [-s scale] [-t type] [-r resources] [-o outfile] infile" << std::endl << std::endl;
+    std::cout << " verovio [-s scale] [-t type] [-r resources] [-o outfile] infile" << std::endl;
+    std::cout << " verovio [-j jobs] [-t type] [-o outdir] infile|indir|@manifest ..." << std::endl << std::endl;
 
     // These need to be kept in alphabetical order:
     // -options with both short and long forms first
@@ -108,14 +567,23 @@ void display_usage()
     std::cout << " -                     Use \"-\" as input file for reading from the standard input" << std::endl;
     std::cout << " -?, --help            Display this message" << std::endl;
     std::cout << " -a, --all-pages       Output all pages" << std::endl;
-    std::cout << " -f, --format <s>      Select input format: darms, mei, pae, xml (default is mei)" << std::endl;
-    std::cout << " -o, --outfile <s>     Output file name (use \"-\" for standard output)" << std::endl;
+    std::cout << " -f, --format <s>      Select input format: darms, mei, pae, xml, snapshot (default is mei)"
+              << std::endl;
+    std::cout << " -j, --jobs <i>        Number of files converted in parallel (default is one per hardware thread)"
+              << std::endl;
+    std::cout << " -o, --outfile <s>     Output file name (use \"-\" for standard output), or output directory with "
+                 "several input files"
+              << std::endl;
     std::cout << " -p, --page <i>        Select the page to engrave (default is 1)" << std::endl;
     std::cout << " -r, --resources <s>   Path to SVG resources (default is " << vrv::Resources::GetPath() << ")" << std::endl;
     std::cout << " -s, --scale <i>       Scale percent (default is " << DEFAULT_SCALE << ")" << std::endl;
-    std::cout << " -t, --type <s>        Select output format: mei, svg, or midi (default is svg)" << std::endl;
+    std::cout << " -t, --type <s>        Select output format: mei, svg, midi or snapshot (default is svg)"
+              << std::endl;
     std::cout << " -v, --version         Display the version number" << std::endl;
     std::cout << " -x, --xml-id-seed <i> Seed the random number generator for XML IDs" << std::endl;
+    std::cout << " --batch               Read JSON-lines requests from the standard input and write the results to "
+                 "the standard output"
+              << std::endl;
 
     vrv::Options options;
     std::vector<vrv::OptionGrp *> *grp = options.GetGrps();
@@ -195,13 +663,16 @@ int main(int argc, char **argv)
     bool std_output = false;
 
     int all_pages = 0;
+    int batch = 0;
+    int jobs = 0;
     int page = 1;
     int show_help = 0;
     int show_version = 0;
+    int xml_id_seed = 0;
 
     // Create the toolkit instance without loading the font because
     // the resource path might be specified in the parameters
-    // The fonts will be loaded later with Resources::InitFonts()
+    // The fonts will be loaded later with Toolkit::SetResourcePath()
     vrv::Toolkit toolkit(false);
 
     if (argc < 2) {
@@ -212,8 +683,10 @@ int main(int argc, char **argv)
 
     static struct option base_options[] = {
         { "all-pages", no_argument, 0, 'a' },
+        { "batch", no_argument, 0, 'B' },
         { "format", required_argument, 0, 'f' },
         { "help", no_argument, 0, '?' },
+        { "jobs", required_argument, 0, 'j' },
         { "outfile", required_argument, 0, 'o' },
         { "page", required_argument, 0, 'p' },
         { "resources", required_argument, 0, 'r' },
@@ -272,7 +745,7 @@ int main(int argc, char **argv)
     int option_index = 0;
     vrv::Option *opt = NULL;
     vrv::OptionBool *optBool = NULL;
-    while ((c = getopt_long(argc, argv, "?ab:f:h:ino:p:r:s:t:w:vx:", long_options, &option_index)) != -1) {
+    while ((c = getopt_long(argc, argv, "?aBb:f:h:ij:no:p:r:s:t:w:vx:", long_options, &option_index)) != -1) {
         switch (c) {
             case 0:
                 key = long_options[option_index].name;
@@ -295,6 +768,8 @@ int main(int argc, char **argv)
 
             case 'a': all_pages = 1; break;
 
+            case 'B': batch = 1; break;
+
             case 'b':
                 vrv::LogWarning("Option -b and --border is deprecated; use --page-margin-bottom, --page-margin-left, --page-margin-right and "
                            "--page-margin-top instead");
@@ -320,6 +795,8 @@ int main(int argc, char **argv)
                 options->m_breaks.SetValue(vrv::BREAKS_auto);
                 break;
 
+            case 'j': jobs = atoi(optarg); break;
+
             case 'n':
                 vrv::LogWarning("Option --no-layout is deprecated; use --breaks none");
                 options->m_breaks.SetValue(vrv::BREAKS_none);
@@ -349,7 +826,10 @@ int main(int argc, char **argv)
                 options->m_pageWidth.SetValue(optarg);
                 break;
 
-            case 'x': vrv::Object::SeedUuid(atoi(optarg)); break;
+            case 'x':
+                xml_id_seed = atoi(optarg);
+                vrv::Object::SeedUuid(xml_id_seed);
+                break;
 
             case '?':
                 display_usage();
@@ -373,7 +853,7 @@ int main(int argc, char **argv)
     if (optind <= argc - 1) {
         infile = std::string(argv[optind]);
     }
-    else {
+    else if (!batch) {
         std::cerr << "Incorrect number of arguments: expected one input file but found none." << std::endl << std::endl;
         display_usage();
         exit(1);
@@ -388,23 +868,54 @@ int main(int argc, char **argv)
     }
 
     // Load the music font from the resource directory
-    if (!vrv::Resources::InitFonts()) {
+    if (!toolkit.SetResourcePath(vrv::Resources::GetPath())) {
         std::cerr << "The music font could not be loaded; please check the contents of the resource directory." << std::endl;
         exit(1);
     }
 
-    // Load a specified font
+    // Check the specified font, which the toolkits load with the data
     if (!vrv::Resources::SetFont(options->m_font.GetValue())) {
         std::cerr << "Font '" << options->m_font.GetValue() << "' could not be loaded." << std::endl;
         exit(1);
     }
 
     if ((outformat != "svg") && (outformat != "mei") && (outformat != "midi") && (outformat != "timemap")
-        && (outformat != "humdrum") && (outformat != "hum")) {
-        std::cerr << "Output format (" << outformat << ") can only be 'mei', 'svg', 'midi', or 'humdrum'." << std::endl;
+        && (outformat != "humdrum") && (outformat != "hum") && (outformat != "snapshot")) {
+        std::cerr << "Output format (" << outformat << ") can only be 'mei', 'svg', 'midi', 'humdrum' or 'snapshot'."
+                  << std::endl;
         exit(1);
     }
 
+    // Process the requests of the standard input with the fonts loaded only once
+    if (batch) {
+        int status = run_batch(toolkit, outformat, xml_id_seed, jobs);
+        free(long_options);
+        return status;
+    }
+
+    // Convert the files in parallel with several input files, a directory or a manifest file
+    if ((optind < argc - 1) || dir_exists(infile) || (infile.at(0) == '@')) {
+        std::vector<std::string> infiles;
+        for (int j = optind; j < argc; ++j) {
+            if (!add_input_files(std::string(argv[j]), infiles)) {
+                std::cerr << "The input '" << argv[j] << "' could not be read." << std::endl;
+                exit(1);
+            }
+        }
+        if (infiles.empty()) {
+            std::cerr << "No input file to convert was found." << std::endl;
+            exit(1);
+        }
+        // The output file name is used as output directory
+        if (!outfile.empty() && !dir_exists(outfile)) {
+            std::cerr << "The output directory '" << outfile << "' could not be found." << std::endl;
+            exit(1);
+        }
+        int status = convert_files(toolkit, infiles, outfile, outformat, page, all_pages, xml_id_seed, jobs);
+        free(long_options);
+        return status;
+    }
+
     // Make sure we provide a file name or output to std output with std input
     if ((infile == "-") && (outfile.empty())) {
         std::cerr << "Standard input can be used only with standard output or output filename." << std::endl;
@@ -423,134 +934,8 @@ int main(int argc, char **argv)
         outfile = removeExtension(outfile);
     }
 
-    // Load the std input or load the file
-    if (infile == "-") {
-        std::ostringstream data_stream;
-        for (std::string line; getline(std::cin, line);) {
-            data_stream << line << std::endl;
-        }
-        if (!toolkit.LoadData(data_stream.str())) {
-            std::cerr << "The input could not be loaded." << std::endl;
-            exit(1);
-        }
-    }
-    else {
-        if (!toolkit.LoadFile(infile)) {
-            std::cerr << "The file '" << infile << "' could not be opened." << std::endl;
-            exit(1);
-        }
-    }
-
-    if (toolkit.GetOutputFormat() != vrv::HUMDRUM) {
-        // Check the page range
-        if (page > toolkit.GetPageCount()) {
-            std::cerr << "The page requested (" << page << ") is not in the page range (max is " << toolkit.GetPageCount()
-                 << ")." << std::endl;
-            exit(1);
-        }
-        if (page < 1) {
-            std::cerr << "The page number has to be greater than 0." << std::endl;
-            exit(1);
-        }
-    }
-
-    int from = page;
-    int to = page + 1;
-    if (all_pages) {
-        to = toolkit.GetPageCount() + 1;
-    }
-
-    if (outformat == "svg") {
-        int p;
-        for (p = from; p < to; ++p) {
-            std::string cur_outfile = outfile;
-            if (all_pages) {
-                cur_outfile += vrv::StringFormat("_%03d", p);
-            }
-            cur_outfile += ".svg";
-            if (std_output) {
-                std::cout << toolkit.RenderToSVG(p);
-            }
-            else if (!toolkit.RenderToSVGFile(cur_outfile, p)) {
-                std::cerr << "Unable to write SVG to " << cur_outfile << "." << std::endl;
-                exit(1);
-            }
-            else {
-                std::cerr << "Output written to " << cur_outfile << "." << std::endl;
-            }
-        }
-    }
-
-    else if (outformat == "midi") {
-        outfile += ".mid";
-        if (std_output) {
-            std::cerr << "Midi cannot write to standard output." << std::endl;
-            exit(1);
-        }
-        else if (!toolkit.RenderToMIDIFile(outfile)) {
-            std::cerr << "Unable to write MIDI to " << outfile << "." << std::endl;
-            exit(1);
-        }
-        else {
-            std::cerr << "Output written to " << outfile << "." << std::endl;
-        }
-    }
-    else if (outformat == "timemap") {
-        outfile += ".json";
-        if (std_output) {
-            std::string output;
-            std::cout << toolkit.RenderToTimemap();
-        }
-        else if (!toolkit.RenderToTimemapFile(outfile)) {
-            std::cerr << "Unable to write MIDI to " << outfile << "." << std::endl;
-            exit(1);
-        }
-        else {
-            std::cerr << "Output written to " << outfile << "." << std::endl;
-        }
-    }
-    else if (outformat == "humdrum" || outformat == "hum") {
-        outfile += ".krn";
-        if (std_output) {
-            toolkit.GetHumdrum(std::cout);
-        }
-        else {
-            if (!toolkit.GetHumdrumFile(outfile)) {
-                std::cerr << "Unable to write Humdrum to " << outfile << "." << std::endl;
-                exit(1);
-            }
-            else {
-                std::cerr << "Output written to " << outfile << "." << std::endl;
-            }
-        }
-    }
-    else {
-        if (all_pages) {
-            toolkit.SetScoreBasedMei(true);
-            outfile += ".mei";
-            if (std_output) {
-                std::cerr << "MEI output of all pages to standard output is not possible." << std::endl;
-                exit(1);
-            }
-            else if (!toolkit.SaveFile(outfile)) {
-                std::cerr << "Unable to write MEI to " << outfile << "." << std::endl;
-                exit(1);
-            }
-            else {
-                std::cerr << "Output written to " << outfile << "." << std::endl;
-            }
-        }
-        else {
-            if (std_output) {
-                std::cout << toolkit.GetMEI(page);
-            }
-            else {
-                std::cerr << "MEI output of one page is available only to standard output." << std::endl;
-                exit(1);
-            }
-        }
-    }
+    int status = convert_file(toolkit, infile, outfile, outformat, page, all_pages, std_output);
 
     free(long_options);
-    return 0;
+    return status;
 }
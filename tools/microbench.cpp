@@ -0,0 +1,374 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        microbench.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <getopt.h>
+#else
+#include "win_getopt.h"
+#endif
+
+//----------------------------------------------------------------------------
+
+#include "att.h"
+#include "doc.h"
+#include "floatingobject.h"
+#include "glyph.h"
+#include "horizontalaligner.h"
+#include "iomei.h"
+#include "note.h"
+#include "slur.h"
+#include "svgdevicecontext.h"
+#include "view.h"
+#include "vrv.h"
+
+// Minimum time (in ms) a benchmark is repeated for
+#define MICROBENCH_MIN_TIME 200.0
+
+// The glyphs used by the benchmarks (noteheads, clefs, rests, accidentals)
+// The ones not available in the loaded fonts are removed at start-up
+static std::vector<wchar_t> glyphCodes
+    = { 0xE0A2, 0xE0A3, 0xE0A4, 0xE050, 0xE062, 0xE05C, 0xE4E3, 0xE4E4, 0xE4E5, 0xE260, 0xE261, 0xE262 };
+
+// Keep the results of the benchmarked calls so they are not optimized away
+static volatile long sink = 0;
+
+//----------------------------------------------------------------------------
+// Measurement
+//----------------------------------------------------------------------------
+
+// Call the function until the minimum time is reached and return the time per operation in ns.
+// Each call of the function is expected to perform opCount operations.
+double measure(const std::function<void()> &function, int opCount)
+{
+    // Warm up
+    function();
+
+    long calls = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed;
+    do {
+        function();
+        ++calls;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < MICROBENCH_MIN_TIME);
+
+    return elapsed.count() * 1000000.0 / ((double)calls * std::max(1, opCount));
+}
+
+// Create a score with one staff with noteCount quarter notes and a slur in each measure
+std::string create_synthetic_mei(int noteCount)
+{
+    static const std::string pitches = "cdefgab";
+
+    std::stringstream mei;
+    mei << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+    mei << "<mei xmlns=\"http://www.music-encoding.org/ns/mei\" meiversion=\"4.0.0\"><music><body><mdiv><score>";
+    mei << "<scoreDef meter.count=\"4\" meter.unit=\"4\"><staffGrp>";
+    mei << "<staffDef n=\"1\" lines=\"5\" clef.shape=\"G\" clef.line=\"2\"/></staffGrp></scoreDef><section>";
+    int measureCount = std::max(1, noteCount / 4);
+    for (int m = 0; m < measureCount; ++m) {
+        mei << "<measure n=\"" << m + 1 << "\"><staff n=\"1\"><layer n=\"1\">";
+        for (int n = 0; n < 4; ++n) {
+            mei << "<note xml:id=\"n" << m << "-" << n << "\" dur=\"4\" pname=\"" << pitches.at((m + n) % 7)
+                << "\" oct=\"" << 4 + (n % 2) << "\"/>";
+        }
+        mei << "</layer></staff><slur staff=\"1\" startid=\"#n" << m << "-0\" endid=\"#n" << m << "-3\"/></measure>";
+    }
+    mei << "</section></score></mdiv></body></music></mei>";
+    return mei.str();
+}
+
+// Load the synthetic score, lay it out and render it so the slurs have their curve calculated
+bool load_synthetic_doc(vrv::Doc &doc, int noteCount)
+{
+    vrv::MeiInput input(&doc, "");
+    if (!input.ImportString(create_synthetic_mei(noteCount))) return false;
+    doc.PrepareDrawing();
+    doc.CastOffDoc();
+
+    vrv::View view;
+    view.SetDoc(&doc);
+    for (int i = 0; i < doc.GetPageCount(); ++i) {
+        view.SetPage(i);
+        vrv::SvgDeviceContext svg;
+        view.DrawCurrentPage(&svg, false);
+    }
+    return true;
+}
+
+int count_objects(vrv::Object *object)
+{
+    int count = 1;
+    for (int i = 0; i < object->GetChildCount(); ++i) {
+        count += count_objects(object->GetChild(i));
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------------
+// Benchmarks - each one returns the time per operation in ns for the given size
+//----------------------------------------------------------------------------
+
+double bench_get_glyph(int size)
+{
+    return measure(
+        [size]() {
+            for (int i = 0; i < size; ++i) {
+                sink += (long)vrv::Resources::GetGlyph(glyphCodes.at(i % glyphCodes.size()))->GetUnitsPerEm();
+            }
+        },
+        size);
+}
+
+double bench_get_glyph_width(int size)
+{
+    vrv::Doc doc;
+    if (!load_synthetic_doc(doc, 4)) return 0.0;
+    return measure(
+        [&doc, size]() {
+            for (int i = 0; i < size; ++i) {
+                wchar_t code = glyphCodes.at(i % glyphCodes.size());
+                sink += doc.GetGlyphWidth(code, 100, false) + doc.GetGlyphHeight(code, 100, false);
+            }
+        },
+        size * 2);
+}
+
+double bench_get_text_extent(int size)
+{
+    // One string of the size
+    std::wstring text;
+    for (int i = 0; i < size; ++i) text.push_back(L'a' + (i % 26));
+
+    vrv::SvgDeviceContext svg;
+    vrv::FontInfo font;
+    font.SetPointSize(100);
+    svg.SetFont(&font);
+    return measure(
+        [&svg, &text]() {
+            vrv::TextExtend extend;
+            svg.GetTextExtent(text, &extend, true);
+            sink += extend.m_width;
+        },
+        size);
+}
+
+double bench_svg_draw_music_text(int size)
+{
+    vrv::FontInfo font;
+    font.SetPointSize(100);
+    return measure(
+        [&font, size]() {
+            vrv::SvgDeviceContext svg;
+            svg.SetFont(&font);
+            for (int i = 0; i < size; ++i) {
+                std::wstring glyph(1, glyphCodes.at(i % glyphCodes.size()));
+                svg.DrawMusicText(glyph, i * 10, 0);
+            }
+            svg.ResetFont();
+            sink += (long)svg.GetStringSVG().size();
+        },
+        size);
+}
+
+double bench_process(int size)
+{
+    vrv::Doc doc;
+    if (!load_synthetic_doc(doc, size)) return 0.0;
+    int nodeCount = count_objects(&doc);
+    return measure(
+        [&doc]() {
+            vrv::ArrayOfObjects notes;
+            vrv::AttComparison comparison(vrv::NOTE);
+            doc.FindAllChildByAttComparison(&notes, &comparison);
+            sink += (long)notes.size();
+        },
+        nodeCount);
+}
+
+double bench_find_child_by_uuid(int size)
+{
+    vrv::Doc doc;
+    if (!load_synthetic_doc(doc, size)) return 0.0;
+    // The last note of the score
+    std::string uuid = vrv::StringFormat("n%d-3", std::max(1, size / 4) - 1);
+    return measure([&doc, &uuid]() { sink += (long)(doc.FindChildByUuid(uuid) != NULL); }, 1);
+}
+
+double bench_att_converter(int size)
+{
+    static const std::vector<std::string> durations = { "1", "2", "4", "8", "16", "32" };
+    static const std::vector<std::string> pitches = { "c", "d", "e", "f", "g", "a", "b" };
+    static const std::vector<std::string> accids = { "s", "f", "n", "ss", "ff" };
+    vrv::Att att;
+    return measure(
+        [&att, size]() {
+            for (int i = 0; i < size; ++i) {
+                sink += att.StrToDuration(durations.at(i % durations.size()));
+                sink += att.StrToPitchname(pitches.at(i % pitches.size()));
+                sink += att.StrToAccidentalWritten(accids.at(i % accids.size()));
+            }
+        },
+        size * 3);
+}
+
+double bench_intersects(int size)
+{
+    vrv::Doc doc;
+    if (!load_synthetic_doc(doc, size)) return 0.0;
+
+    // Each slur is tested against the notes of its measure
+    std::vector<std::pair<vrv::FloatingPositioner *, vrv::Note *> > pairs;
+    vrv::ArrayOfObjects slurs;
+    vrv::AttComparison comparison(vrv::SLUR);
+    doc.FindAllChildByAttComparison(&slurs, &comparison);
+    for (auto object : slurs) {
+        vrv::Slur *slur = dynamic_cast<vrv::Slur *>(object);
+        assert(slur);
+        vrv::FloatingPositioner *positioner = slur->GetCurrentFloatingPositioner();
+        if (!positioner) continue;
+        vrv::ArrayOfObjects notes;
+        vrv::AttComparison noteComparison(vrv::NOTE);
+        slur->GetFirstParent(vrv::MEASURE)->FindAllChildByAttComparison(&notes, &noteComparison);
+        for (auto note : notes) pairs.push_back(std::make_pair(positioner, dynamic_cast<vrv::Note *>(note)));
+    }
+    if (pairs.empty()) return 0.0;
+
+    return measure(
+        [&pairs]() {
+            for (auto &pair : pairs) sink += pair.second->Intersects(pair.first);
+        },
+        (int)pairs.size());
+}
+
+double bench_get_alignment_at_time(int size)
+{
+    vrv::MeasureAligner aligner;
+    for (int i = 0; i < size; ++i) aligner.GetAlignmentAtTime(i * 8, vrv::ALIGNMENT_DEFAULT);
+    return measure(
+        [&aligner, size]() {
+            for (int i = 0; i < size; ++i) {
+                sink += (long)(aligner.GetAlignmentAtTime(i * 8, vrv::ALIGNMENT_DEFAULT) != NULL);
+            }
+        },
+        size);
+}
+
+//----------------------------------------------------------------------------
+// Main
+//----------------------------------------------------------------------------
+
+struct MicroBench {
+    std::string m_name;
+    std::string m_unit;
+    std::function<double(int)> m_function;
+};
+
+static const std::vector<MicroBench> microBenches = {
+    { "Resources::GetGlyph", "glyph", bench_get_glyph },
+    { "Doc::GetGlyphWidth", "call", bench_get_glyph_width },
+    { "DeviceContext::GetTextExtent", "char", bench_get_text_extent },
+    { "SvgDeviceContext::DrawMusicText", "glyph", bench_svg_draw_music_text },
+    { "Object::Process", "node", bench_process },
+    { "Object::FindChildByUuid", "search", bench_find_child_by_uuid },
+    { "AttConverter::StrTo", "value", bench_att_converter },
+    { "BoundingBox::Intersects", "call", bench_intersects },
+    { "MeasureAligner::GetAlignmentAtTime", "call", bench_get_alignment_at_time },
+};
+
+void display_usage()
+{
+    std::cout << "Verovio micro-benchmarks " << vrv::GetVersion() << std::endl << std::endl;
+    std::cout << "Example usage:" << std::endl << std::endl;
+    std::cout << " verovio-microbench [-s sizes] [-f filter]" << std::endl << std::endl;
+    std::cout << "Each benchmark is run for each size and the time per operation is given, so the scaling with the "
+                 "size is directly visible."
+              << std::endl
+              << std::endl;
+    std::cout << "Options" << std::endl;
+    std::cout << " -?, --help            Display this message" << std::endl;
+    std::cout << " -f, --filter <s>      Run only the benchmarks with a name containing the string" << std::endl;
+    std::cout << " -r, --resources <s>   Path to SVG resources (default is " << vrv::Resources::GetPath() << ")"
+              << std::endl;
+    std::cout << " -s, --sizes <s>       Comma-separated list of sizes (default is 100,1000,10000)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter;
+    std::vector<int> sizes = { 100, 1000, 10000 };
+
+    static struct option long_options[] = {
+        { "filter", required_argument, 0, 'f' },
+        { "help", no_argument, 0, '?' },
+        { "resources", required_argument, 0, 'r' },
+        { "sizes", required_argument, 0, 's' },
+        { 0, 0, 0, 0 }
+    };
+
+    int c;
+    int option_index = 0;
+    while ((c = getopt_long(argc, argv, "?f:r:s:", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 'f': filter = std::string(optarg); break;
+            case 'r': vrv::Resources::SetPath(optarg); break;
+            case 's': {
+                sizes.clear();
+                std::istringstream iss(optarg);
+                for (std::string size; getline(iss, size, ',');) {
+                    if (atoi(size.c_str()) > 0) sizes.push_back(atoi(size.c_str()));
+                }
+                break;
+            }
+            case '?':
+                display_usage();
+                exit(0);
+                break;
+            default: break;
+        }
+    }
+
+    if (!vrv::Resources::InitFonts()) {
+        std::cerr << "The music font could not be loaded; please use -r option." << std::endl;
+        exit(1);
+    }
+
+    glyphCodes.erase(std::remove_if(glyphCodes.begin(), glyphCodes.end(),
+                         [](wchar_t code) { return (vrv::Resources::GetGlyph(code) == NULL); }),
+        glyphCodes.end());
+    if (glyphCodes.empty()) {
+        std::cerr << "None of the glyphs used by the benchmarks could be loaded." << std::endl;
+        exit(1);
+    }
+
+    vrv::DisableLog();
+
+    std::cout << vrv::StringFormat("%-40s", "benchmark");
+    for (auto size : sizes) std::cout << vrv::StringFormat("%14d", size);
+    std::cout << "   ns per" << std::endl;
+
+    for (auto &microBench : microBenches) {
+        if (!filter.empty() && (microBench.m_name.find(filter) == std::string::npos)) continue;
+        std::cout << vrv::StringFormat("%-40s", microBench.m_name.c_str()) << std::flush;
+        for (auto size : sizes) {
+            std::cout << vrv::StringFormat("%14.2f", microBench.m_function(size)) << std::flush;
+        }
+        std::cout << "   " << microBench.m_unit << std::endl;
+    }
+
+    return 0;
+}
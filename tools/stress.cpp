@@ -0,0 +1,158 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        stress.cpp
+// Author:      agent
+// Created:     19/10/2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <getopt.h>
+#else
+#include "win_getopt.h"
+#endif
+
+//----------------------------------------------------------------------------
+
+#include "toolkit.h"
+#include "vrv.h"
+
+// The seed of the ids, for getting the same output in all the threads
+#define STRESS_XML_ID_SEED 1
+
+// The fonts used alternately by the toolkits, for checking that they do not share the current font
+static const std::vector<std::string> fonts = { "Leipzig", "Bravura" };
+
+//----------------------------------------------------------------------------
+// Conversion
+//----------------------------------------------------------------------------
+
+/**
+ * Load the file with the font in a new toolkit and return all the pages in SVG, the MEI and the MIDI - empty if it
+ * cannot be loaded
+ */
+std::string convert(const std::string &infile, const std::string &font)
+{
+    // The ids of the document are generated from the creation of the toolkit
+    vrv::Object::SeedUuid(STRESS_XML_ID_SEED);
+    vrv::Toolkit toolkit;
+    toolkit.SetOptions("{\"font\": \"" + font + "\"}");
+    if (!toolkit.LoadFile(infile)) return "";
+
+    std::string output;
+    for (int page = 1; page <= toolkit.GetPageCount(); ++page) {
+        output += toolkit.RenderToSVG(page);
+    }
+    output += toolkit.GetMEI(0, true);
+    output += toolkit.RenderToMIDI();
+    return output;
+}
+
+//----------------------------------------------------------------------------
+// Main
+//----------------------------------------------------------------------------
+
+void display_usage()
+{
+    std::cout << "Verovio stress test " << vrv::GetVersion() << std::endl << std::endl;
+    std::cout << "Example usage:" << std::endl << std::endl;
+    std::cout << " verovio-stress [-j threads] [-n iterations] file ..." << std::endl << std::endl;
+    std::cout << "Each file is converted once in the main thread and then repeatedly by toolkits running in parallel "
+                 "threads with alternating fonts. The test fails if any output differs from the sequential one."
+              << std::endl
+              << std::endl;
+    std::cout << "Options" << std::endl;
+    std::cout << " -?, --help            Display this message" << std::endl;
+    std::cout << " -j, --jobs <i>        Number of threads (default is 16)" << std::endl;
+    std::cout << " -n, --iterations <i>  Number of conversions of each file by each thread (default is 2)" << std::endl;
+    std::cout << " -r, --resources <s>   Path to SVG resources (default is " << vrv::Resources::GetPath() << ")"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int jobs = 16;
+    int iterations = 2;
+
+    static struct option long_options[] = {
+        { "help", no_argument, 0, '?' },
+        { "iterations", required_argument, 0, 'n' },
+        { "jobs", required_argument, 0, 'j' },
+        { "resources", required_argument, 0, 'r' },
+        { 0, 0, 0, 0 }
+    };
+
+    int c;
+    int option_index = 0;
+    while ((c = getopt_long(argc, argv, "?j:n:r:", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 'j': jobs = std::max(1, atoi(optarg)); break;
+            case 'n': iterations = std::max(1, atoi(optarg)); break;
+            case 'r': vrv::Resources::SetPath(optarg); break;
+            case '?':
+                display_usage();
+                exit(0);
+                break;
+            default: break;
+        }
+    }
+
+    std::vector<std::string> infiles(argv + optind, argv + argc);
+    if (infiles.empty()) {
+        std::cerr << "Expected at least one input file but found none." << std::endl << std::endl;
+        display_usage();
+        exit(1);
+    }
+
+    if (!vrv::Resources::InitFonts()) {
+        std::cerr << "The music font could not be loaded; please use -r option." << std::endl;
+        exit(1);
+    }
+
+    // The warnings of the import would be repeated for each conversion
+    vrv::DisableLog();
+
+    // The sequential outputs by file and font
+    std::vector<std::vector<std::string> > expected(infiles.size());
+    for (int i = 0; i < (int)infiles.size(); ++i) {
+        for (auto &font : fonts) {
+            expected.at(i).push_back(convert(infiles.at(i), font));
+            if (expected.at(i).back().empty()) {
+                std::cerr << "Unable to convert " << infiles.at(i) << "." << std::endl;
+                exit(1);
+            }
+        }
+    }
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int job = 0; job < jobs; ++job) {
+        threads.push_back(std::thread([&, job]() {
+            vrv::DisableLog();
+            const int fileCount = (int)infiles.size();
+            for (int n = 0; n < iterations * fileCount; ++n) {
+                // Each thread starts with another file and another font
+                int i = (job + n) % fileCount;
+                int f = (job + n / fileCount) % (int)fonts.size();
+                if (convert(infiles.at(i), fonts.at(f)) != expected.at(i).at(f)) {
+                    ++failures;
+                    std::cerr << "Thread " << job << ": the output of " << infiles.at(i) << " with " << fonts.at(f)
+                              << " differs from the sequential one." << std::endl;
+                }
+            }
+        }));
+    }
+    for (auto &thread : threads) thread.join();
+
+    std::cout << jobs << " threads, " << iterations * infiles.size() << " conversions each: " << failures
+              << " failure(s)" << std::endl;
+
+    return (failures == 0) ? 0 : 1;
+}